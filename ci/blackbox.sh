@@ -146,10 +146,13 @@ then
         status=$?
     fi
     
-    if [ -f "$APP_PATH/trace.vcd" ]
-    then 
-        mv -f $APP_PATH/trace.vcd .
-    fi
+    for TRACE_FILE in trace.vcd trace.fst
+    do
+        if [ -f "$APP_PATH/$TRACE_FILE" ]
+        then 
+            mv -f $APP_PATH/$TRACE_FILE .
+        fi
+    done
 else
     if [ $SCOPE -eq 1 ]
     then
@@ -76,6 +76,10 @@ CONFIGS=-DEXT_F_DISABLE ./ci/blackbox.sh --driver=rtlsim --cores=1 --app=no_mf_e
 
 # disable shared memory
 CONFIGS=-DSM_ENABLE=0 ./ci/blackbox.sh --driver=rtlsim --cores=1 --app=no_smem
+CONFIGS=-DSM_ENABLE=0 ./ci/blackbox.sh --driver=rtlsim --cores=1 --app=sched
+
+# workgroup local memory
+CONFIGS=-DLMEM_ENABLE=1 ./ci/blackbox.sh --driver=rtlsim --cores=2 --app=lmem
 
 # using Default FPU core
 FPU_CORE=FPU_DEFAULT ./ci/blackbox.sh --driver=rtlsim --cores=1 --app=dogfood
@@ -0,0 +1,88 @@
+#!/bin/sh
+
+show_usage()
+{
+    echo "Vortex Simulation Throughput Benchmark v1.0"
+    echo "Usage: [[--driver=rtlsim|vlsim] [--app=demo|basic|...] [--args=<args>] [--cores=<list>] [--vlthreads=#n] [--help]]"
+}
+
+SCRIPT_DIR=$(dirname "$0")
+VORTEX_HOME=$SCRIPT_DIR/..
+
+DRIVER=rtlsim
+APP=demo
+ARGS=
+CORES_LIST="1 2 4 8"
+VL_THREADS=$(python3 -c 'import multiprocessing as mp; print(max(1, mp.cpu_count() // 2))')
+
+for i in "$@"
+do
+case $i in
+    --driver=*)
+        DRIVER=${i#*=}
+        shift
+        ;;
+    --app=*)
+        APP=${i#*=}
+        shift
+        ;;
+    --args=*)
+        ARGS=${i#*=}
+        shift
+        ;;
+    --cores=*)
+        CORES_LIST=$(echo ${i#*=} | tr ',' ' ')
+        shift
+        ;;
+    --vlthreads=*)
+        VL_THREADS=${i#*=}
+        shift
+        ;;
+    --help)
+        show_usage
+        exit 0
+        ;;
+    *)
+    show_usage
+    exit -1
+    ;;
+esac
+done
+
+case $DRIVER in
+    rtlsim|vlsim)
+        DRIVER_PATH=$VORTEX_HOME/driver/$DRIVER
+        ;;
+    *)
+        echo "invalid driver: $DRIVER"
+        exit -1
+        ;;
+esac
+
+APP_PATH=$VORTEX_HOME/tests/regression/$APP
+if [ ! -d "$APP_PATH" ];
+then
+    echo "Application folder not found: $APP"
+    exit -1
+fi
+
+# run the app and extract the simulated cycles per second
+# reported by the harness on exit
+run_app()
+{
+    make -C $DRIVER_PATH clean > /dev/null
+    MT=$1 THREADS=$VL_THREADS CONFIGS="-DNUM_CORES=$2" make -C $DRIVER_PATH > build.log 2>&1 || { echo "build failed, see build.log" >&2; return 1; }
+    VORTEX_SIM_THROUGHPUT=1 OPTS=$ARGS make -C $APP_PATH run-$DRIVER > run.log 2>&1 || { echo "run failed, see run.log" >&2; return 1; }
+    grep "PERF: sim throughput" run.log | tail -1 | sed 's/.*cycles\/s=\([0-9]*\).*/\1/'
+}
+
+echo "driver=$DRIVER, app=$APP, verilator threads=$VL_THREADS"
+printf "%-8s %-16s %-16s %s\n" "cores" "st cycles/s" "mt cycles/s" "speedup"
+
+for CORES in $CORES_LIST
+do
+    ST_CPS=$(run_app "" $CORES) || exit -1
+    MT_CPS=$(run_app 1 $CORES) || exit -1
+    SPEEDUP=$(python3 -c "print('%.2f' % ($MT_CPS / $ST_CPS))")
+    printf "%-8s %-16s %-16s %s\n" $CORES $ST_CPS $MT_CPS $SPEEDUP
+done
@@ -9,6 +9,12 @@
 #include <sstream>
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <chrono>
 
 #if defined(USE_FPGA) || defined(USE_ASE) 
 #include <opae/fpga.h>
@@ -20,6 +26,10 @@
 #include <vortex.h>
 #include <VX_config.h>
 #include "vortex_afu.h"
+#include "vx_malloc.h"
+#include "vx_queue.h"
+#include "vx_resident.h"
+#include "vx_utils.h"
 
 #ifdef SCOPE
 #include "vx_scope.h"
@@ -48,11 +58,41 @@
 #define MMIO_DEV_CAPS       (AFU_IMAGE_MMIO_DEV_CAPS * 4)
 #define MMIO_STATUS         (AFU_IMAGE_MMIO_STATUS * 4)
 
+// maximum device span to data size ratio of a batched copy
+#define COPY_BATCH_SPAN_RATIO 4
+
+// pinned buffer pool size classes (log2 bytes)
+#define BUFFER_POOL_MIN_ORDER 12
+#define BUFFER_POOL_MAX_ORDER 26
+
+// maximum bytes kept pinned by free pool buffers
+#define BUFFER_POOL_CAPACITY  (128 * 1024 * 1024)
+
 ///////////////////////////////////////////////////////////////////////////////
 
+typedef struct {
+    uint64_t wsid;
+    void* host_ptr;
+    uint64_t io_addr;
+} pinned_buffer_t;
+
 typedef struct vx_device_ {
+    vx_device_() 
+        : mem_allocator(ALLOC_BASE_ADDR, IO_BASE_ADDR - ALLOC_BASE_ADDR, CACHE_BLOCK_SIZE) 
+        , buffer_pool(BUFFER_POOL_MAX_ORDER + 1)
+        , buffer_pool_size(0)
+        , print_pending(false)
+    {}
+
     fpga_handle fpga;
-    size_t mem_allocation;
+    vortex::MemoryAllocator mem_allocator;
+    vortex::CommandQueue queue;
+    vortex::ResidentCache resident_cache;
+    std::vector<std::vector<pinned_buffer_t>> buffer_pool; // free buffers per size class
+    size_t buffer_pool_size;
+    std::mutex buffer_pool_mutex;
+    bool print_pending; // printf ring buffers hold output of the last run
+    std::vector<uint32_t> print_counts; // ring write counts already printed
     unsigned version;
     unsigned num_cores;
     unsigned num_warps;
@@ -65,6 +105,7 @@ typedef struct vx_buffer_ {
     uint64_t io_addr;
     vx_device_h hdevice;
     size_t size;
+    size_t capacity; // pinned bytes
 } vx_buffer_t;
 
 inline size_t align_size(size_t size, size_t alignment) {        
@@ -77,6 +118,69 @@ inline bool is_aligned(size_t addr, size_t alignment) {
     return 0 == (addr & (alignment - 1));
 }
 
+// pin a DMA buffer, recycling a free pool buffer of the same size class if available
+static int acquire_pinned(vx_device_t *device, size_t size, pinned_buffer_t* pinned, size_t* capacity) {
+    uint32_t order = BUFFER_POOL_MIN_ORDER;
+    while (order < 64 && (size_t(1) << order) < size) {
+        ++order;
+    }
+
+    if (order <= BUFFER_POOL_MAX_ORDER) {
+        *capacity = size_t(1) << order;
+        std::lock_guard<std::mutex> guard(device->buffer_pool_mutex);
+        auto& free_list = device->buffer_pool.at(order);
+        if (!free_list.empty()) {
+            *pinned = free_list.back();
+            free_list.pop_back();
+            device->buffer_pool_size -= *capacity;
+            return 0;
+        }
+    } else {
+        *capacity = size;
+    }
+
+    fpga_result res = fpgaPrepareBuffer(device->fpga, *capacity, &pinned->host_ptr, &pinned->wsid, 0);
+    if (FPGA_OK != res)
+        return -1;
+
+    // Get the physical address of the buffer in the accelerator
+    res = fpgaGetIOAddress(device->fpga, pinned->wsid, &pinned->io_addr);
+    if (FPGA_OK != res) {
+        fpgaReleaseBuffer(device->fpga, pinned->wsid);
+        return -1;
+    }
+
+    return 0;
+}
+
+// return a pinned buffer to the pool, unpinning it if the pool is full
+static void release_pinned(vx_device_t *device, const pinned_buffer_t& pinned, size_t capacity) {
+    uint32_t order = __builtin_ctzll(capacity);
+    if (capacity == (size_t(1) << order)
+     && order >= BUFFER_POOL_MIN_ORDER
+     && order <= BUFFER_POOL_MAX_ORDER) {
+        std::lock_guard<std::mutex> guard(device->buffer_pool_mutex);
+        if (device->buffer_pool_size + capacity <= BUFFER_POOL_CAPACITY) {
+            device->buffer_pool.at(order).push_back(pinned);
+            device->buffer_pool_size += capacity;
+            return;
+        }
+    }
+    fpgaReleaseBuffer(device->fpga, pinned.wsid);
+}
+
+// unpin all free pool buffers
+static void flush_pinned(vx_device_t *device) {
+    std::lock_guard<std::mutex> guard(device->buffer_pool_mutex);
+    for (auto& free_list : device->buffer_pool) {
+        for (auto& pinned : free_list) {
+            fpgaReleaseBuffer(device->fpga, pinned.wsid);
+        }
+        free_list.clear();
+    }
+    device->buffer_pool_size = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifdef DUMP_PERF_STATS
@@ -147,6 +251,9 @@ extern int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value) {
     return 0;
 }
 
+static int print_init(vx_device_t *device);
+static int print_drain(vx_device_t *device);
+
 extern int vx_dev_open(vx_device_h* hdevice) {
     if (nullptr == hdevice)
         return  -1;
@@ -213,14 +320,13 @@ extern int vx_dev_open(vx_device_h* hdevice) {
 #endif
 
     // allocate device object
-    device = (vx_device_t*)malloc(sizeof(vx_device_t));
+    device = new (std::nothrow) vx_device_t();
     if (nullptr == device) {
         fpgaClose(accel_handle);
         return -1;
     }
 
     device->fpga = accel_handle;
-    device->mem_allocation = ALLOC_BASE_ADDR;
     
     {   
         // Load device CAPS
@@ -228,6 +334,7 @@ extern int vx_dev_open(vx_device_h* hdevice) {
         int ret = fpgaReadMMIO64(device->fpga, 0, MMIO_DEV_CAPS, &dev_caps);        
         if (ret != FPGA_OK) {
             fpgaClose(accel_handle);
+            delete device;
             return ret;
         }
         device->version     = (dev_caps >> 0)  & 0xffff;
@@ -240,11 +347,20 @@ extern int vx_dev_open(vx_device_h* hdevice) {
     #endif
     }
     
+    if (print_init(device) != 0) {
+        flush_pinned(device);
+        fpgaClose(accel_handle);
+        delete device;
+        return -1;
+    }
+    
 #ifdef SCOPE
     {
         int ret = vx_scope_start(accel_handle, 0, -1);
         if (ret != 0) {
+            flush_pinned(device);
             fpgaClose(accel_handle);
+            delete device;
             return ret;
         }
     }
@@ -265,6 +381,9 @@ extern int vx_dev_close(vx_device_h hdevice) {
 
     vx_device_t *device = ((vx_device_t*)hdevice);
 
+    // drain pending commands
+    device->queue.finish(-1);
+
 #ifdef SCOPE
     vx_scope_stop(device->fpga);
 #endif
@@ -274,8 +393,12 @@ extern int vx_dev_close(vx_device_h hdevice) {
     vx_dump_perf(hdevice, stdout);
 #endif
 
+    flush_pinned(device);
+
     fpgaClose(device->fpga);
 
+    delete device;
+
     return 0;
 }
 
@@ -287,23 +410,50 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
 
     vx_device_t *device = ((vx_device_t*)hdevice);
 
-    size_t dev_mem_size = LOCAL_MEM_SIZE;
-    size_t asize = align_size(size, CACHE_BLOCK_SIZE);
-    
-    if (device->mem_allocation + asize > dev_mem_size)
-        return -1;   
+    uint64_t addr;
+    if (device->mem_allocator.allocate(size, &addr) != 0)
+        return -1;
+
+    *dev_maddr = addr;
+
+    return 0;
+}
+
+extern int vx_mem_free(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+
+    return device->mem_allocator.release(dev_maddr);
+}
 
-    *dev_maddr = device->mem_allocation;
-    device->mem_allocation += asize;
+extern int vx_mem_info(vx_device_h hdevice, size_t* mem_free, size_t* mem_used) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+
+    if (mem_free)
+        *mem_free = device->mem_allocator.free_size();
+    if (mem_used)
+        *mem_used = device->mem_allocator.used_size();
 
     return 0;
 }
 
+vortex::ResidentCache* vx_resident_cache(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return nullptr;
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+
+    return &device->resident_cache;
+}
+
 extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer) {
-    fpga_result res;
-    void* host_ptr;
-    uint64_t wsid;
-    uint64_t io_addr;
+    pinned_buffer_t pinned;
+    size_t capacity;
     vx_buffer_t* buffer;
 
     if (nullptr == hdevice
@@ -315,36 +465,33 @@ extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hb
 
     size_t asize = align_size(size, CACHE_BLOCK_SIZE);
 
-    res = fpgaPrepareBuffer(device->fpga, asize, &host_ptr, &wsid, 0);
-    if (FPGA_OK != res) {
+    if (acquire_pinned(device, asize, &pinned, &capacity) != 0)
         return -1;
-    }
-
-    // Get the physical address of the buffer in the accelerator
-    res = fpgaGetIOAddress(device->fpga, wsid, &io_addr);
-    if (FPGA_OK != res) {
-        fpgaReleaseBuffer(device->fpga, wsid);
-        return -1;
-    }
 
     // allocate buffer object
     buffer = (vx_buffer_t*)malloc(sizeof(vx_buffer_t));
     if (nullptr == buffer) {
-        fpgaReleaseBuffer(device->fpga, wsid);
+        release_pinned(device, pinned, capacity);
         return -1;
     }
 
-    buffer->wsid     = wsid;
-    buffer->host_ptr = host_ptr;
-    buffer->io_addr  = io_addr;
+    buffer->wsid     = pinned.wsid;
+    buffer->host_ptr = pinned.host_ptr;
+    buffer->io_addr  = pinned.io_addr;
     buffer->hdevice  = hdevice;
     buffer->size     = asize;
+    buffer->capacity = capacity;
 
     *hbuffer = buffer;
 
     return 0;
 }
 
+extern int vx_map_dev_mem(vx_device_h /*hdevice*/, size_t /*dev_maddr*/, size_t /*size*/, vx_buffer_h* /*hbuffer*/) {
+    // device local memory is not host-visible
+    return -1;
+}
+
 extern void* vx_host_ptr(vx_buffer_h hbuffer) {
     if (nullptr == hbuffer)
         return nullptr;
@@ -360,20 +507,19 @@ extern int vx_buf_release(vx_buffer_h hbuffer) {
     vx_buffer_t* buffer = ((vx_buffer_t*)hbuffer);
     vx_device_t *device = ((vx_device_t*)buffer->hdevice);
 
-    fpgaReleaseBuffer(device->fpga, buffer->wsid);
+    pinned_buffer_t pinned;
+    pinned.wsid     = buffer->wsid;
+    pinned.host_ptr = buffer->host_ptr;
+    pinned.io_addr  = buffer->io_addr;
+    release_pinned(device, pinned, buffer->capacity);
 
     free(buffer);
 
     return 0;
 }
 
-extern int vx_ready_wait(vx_device_h hdevice, long long timeout) {
-    if (nullptr == hdevice)
-        return -1;
-
+static int ready_wait(vx_device_t *device, long long timeout) {
     std::unordered_map<int, std::stringstream> print_bufs;
-    
-    vx_device_t *device = ((vx_device_t*)hdevice);
 
     struct timespec sleep_time; 
 
@@ -417,44 +563,50 @@ extern int vx_ready_wait(vx_device_h hdevice, long long timeout) {
                 std::cout << "#" << buf.first << ": " << str << std::endl;
                 }
             }
-            if (state != 0) {
-                fprintf(stdout, "[VXDRV] ready-wait timed out: state=%d\n", state);
+            if (state != 0)
+                return VX_EVENT_PENDING;
+            if (device->print_pending) {
+                if (print_drain(device) != 0)
+                    return -1;
             }
             break;
         }
 
         nanosleep(&sleep_time, nullptr);
-        timeout -= sleep_time_ms;
+        if (timeout > 0) {
+            timeout = std::max(timeout - sleep_time_ms, 0ll);
+        }
     };
 
     return 0;
 }
 
-extern int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset) {
-    if (nullptr == hbuffer 
-     || 0 >= size)
-        return -1;
-
-    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
-    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
-
+static int check_copy_args(vx_buffer_t *buffer, size_t dev_maddr, size_t size, size_t offset) {
     size_t dev_mem_size = LOCAL_MEM_SIZE; 
     size_t asize = align_size(size, CACHE_BLOCK_SIZE);
 
     // check alignment
     if (!is_aligned(dev_maddr, CACHE_BLOCK_SIZE))
         return -1;
-    if (!is_aligned(buffer->io_addr + src_offset, CACHE_BLOCK_SIZE))
+    if (!is_aligned(buffer->io_addr + offset, CACHE_BLOCK_SIZE))
         return -1;
 
     // bound checking
-    if (src_offset + asize > buffer->size)
+    if (offset + asize > buffer->size)
         return -1;
     if (dev_maddr + asize > dev_mem_size)
         return -1;
 
+    return 0;
+}
+
+static int copy_to_dev(vx_buffer_t *buffer, size_t dev_maddr, size_t size, size_t src_offset) {
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    size_t asize = align_size(size, CACHE_BLOCK_SIZE);
+
     // Ensure ready for new command
-    if (vx_ready_wait(buffer->hdevice, -1) != 0)
+    if (ready_wait(device, -1) != 0)
         return -1;
 
     auto ls_shift = (int)std::log2(CACHE_BLOCK_SIZE);
@@ -463,14 +615,267 @@ extern int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, si
     CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_MEM_ADDR, dev_maddr >> ls_shift));
     CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_DATA_SIZE, asize >> ls_shift));   
     CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_CMD_TYPE, CMD_MEM_WRITE));
+    device->resident_cache.invalidate(dev_maddr, asize);
 
     // Wait for the write operation to finish
-    if (vx_ready_wait(buffer->hdevice, -1) != 0)
+    if (ready_wait(device, -1) != 0)
+        return -1;
+
+    return 0;
+}
+
+static int copy_from_dev(vx_buffer_t *buffer, size_t dev_maddr, size_t size, size_t dest_offset) {
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    size_t asize = align_size(size, CACHE_BLOCK_SIZE);
+
+    // Ensure ready for new command
+    if (ready_wait(device, -1) != 0)
+        return -1;
+
+    auto ls_shift = (int)std::log2(CACHE_BLOCK_SIZE);
+
+    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_IO_ADDR, (buffer->io_addr + dest_offset) >> ls_shift));
+    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_MEM_ADDR, dev_maddr >> ls_shift));    
+    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_DATA_SIZE, asize >> ls_shift));   
+    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_CMD_TYPE, CMD_MEM_READ));
+
+    // Wait for the write operation to finish
+    if (ready_wait(device, -1) != 0)
+        return -1;
+
+    return 0;
+}
+
+// copy a list of regions through a single staging buffer covering their device span
+static int copy_span(vx_buffer_t *buffer, const vx_copy_desc_t* descs, unsigned count, bool to_dev) {
+    size_t span_start = descs[0].dev_maddr;
+    size_t span_end   = descs[0].dev_maddr + descs[0].size;
+    for (unsigned i = 1; i < count; ++i) {
+        span_start = std::min(span_start, descs[i].dev_maddr);
+        span_end   = std::max(span_end, descs[i].dev_maddr + descs[i].size);
+    }
+    span_start &= ~size_t(CACHE_BLOCK_SIZE - 1);
+    span_end = align_size(span_end, CACHE_BLOCK_SIZE);
+    size_t span_size = span_end - span_start;
+
+    vx_buffer_h hstaging;
+    if (vx_alloc_shared_mem(buffer->hdevice, span_size, &hstaging) != 0)
+        return -1;
+    auto staging = (vx_buffer_t*)hstaging;
+    auto staging_ptr = (uint8_t*)staging->host_ptr;
+    auto buffer_ptr = (uint8_t*)buffer->host_ptr;
+
+    int ret = 0;
+    if (to_dev) {
+        // preserve device bytes not covered by the regions
+        std::vector<vx_copy_desc_t> sorted(descs, descs + count);
+        std::sort(sorted.begin(), sorted.end(), [](const vx_copy_desc_t& a, const vx_copy_desc_t& b) {
+            return a.dev_maddr < b.dev_maddr;
+        });
+        size_t covered = span_start;
+        for (auto& desc : sorted) {
+            if (desc.dev_maddr > covered)
+                break;
+            covered = std::max(covered, desc.dev_maddr + desc.size);
+        }
+        if (covered < span_end) {
+            ret = copy_from_dev(staging, span_start, span_size, 0);
+        }
+        if (0 == ret) {
+            for (unsigned i = 0; i < count; ++i) {
+                memcpy(staging_ptr + (descs[i].dev_maddr - span_start), buffer_ptr + descs[i].offset, descs[i].size);
+            }
+            ret = copy_to_dev(staging, span_start, span_size, 0);
+        }
+    } else {
+        ret = copy_from_dev(staging, span_start, span_size, 0);
+        if (0 == ret) {
+            for (unsigned i = 0; i < count; ++i) {
+                memcpy(buffer_ptr + descs[i].offset, staging_ptr + (descs[i].dev_maddr - span_start), descs[i].size);
+            }
+        }
+    }
+
+    vx_buf_release(hstaging);
+
+    return ret;
+}
+
+static int copy_batch(vx_buffer_t *buffer, const vx_copy_desc_t* descs, unsigned count, bool to_dev) {
+    size_t total_size = 0;
+    size_t span_start = descs[0].dev_maddr;
+    size_t span_end   = descs[0].dev_maddr + descs[0].size;
+    for (unsigned i = 0; i < count; ++i) {
+        total_size += descs[i].size;
+        span_start = std::min(span_start, descs[i].dev_maddr);
+        span_end   = std::max(span_end, descs[i].dev_maddr + descs[i].size);
+    }
+
+    // dense regions are transferred with a single device command (two if partially covered writes)
+    if ((span_end - span_start) <= (total_size * COPY_BATCH_SPAN_RATIO))
+        return copy_span(buffer, descs, count, to_dev);
+
+    // sparse regions are transferred individually
+    for (unsigned i = 0; i < count; ++i) {
+        auto& desc = descs[i];
+        int ret;
+        if (is_aligned(desc.dev_maddr, CACHE_BLOCK_SIZE)
+         && is_aligned(buffer->io_addr + desc.offset, CACHE_BLOCK_SIZE)
+         && is_aligned(desc.size, CACHE_BLOCK_SIZE)) {
+            ret = to_dev ? copy_to_dev(buffer, desc.dev_maddr, desc.size, desc.offset) 
+                         : copy_from_dev(buffer, desc.dev_maddr, desc.size, desc.offset);
+        } else {
+            ret = copy_span(buffer, &desc, 1, to_dev);
+        }
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+// printf header size, the rings follow it
+static size_t print_header_size(size_t num_rings) {
+    return align_size((IO_PRINT_HEADER_WORDS + num_rings) * sizeof(uint32_t), CACHE_BLOCK_SIZE);
+}
+
+// clear the printf ring buffers and enable them, once per device
+// the ring layout is published in the header so the runtime does not depend on the device config
+static int print_init(vx_device_t *device) {
+    size_t num_rings = device->num_cores * device->num_warps * device->num_threads;
+    size_t header_size = print_header_size(num_rings);
+    size_t ring_size = size_t(1) << IO_PRINT_LOG2_SIZE;
+
+    if (device->mem_allocator.reserve(IO_PRINT_ADDR, header_size + num_rings * ring_size) != 0)
+        return -1;
+
+    device->print_counts.assign(num_rings, 0);
+
+    vx_buffer_h hbuffer;
+    if (vx_alloc_shared_mem(device, header_size, &hbuffer) != 0)
         return -1;
+    auto buffer = (vx_buffer_t*)hbuffer;
+
+    auto header = (uint32_t*)buffer->host_ptr;
+    memset(header, 0, header_size);
+    header[0] = IO_PRINT_ENABLE;
+    header[1] = num_rings;
+    header[2] = header_size;
+
+    int ret = copy_to_dev(buffer, IO_PRINT_ADDR, header_size, 0);
+
+    vx_buf_release(hbuffer);
+
+    return ret;
+}
+
+// read back the printf ring buffers in bulk and print their content
+static int print_drain(vx_device_t *device) {
+    size_t num_rings = device->print_counts.size();
+    size_t header_size = print_header_size(num_rings);
+    size_t ring_size = size_t(1) << IO_PRINT_LOG2_SIZE;
+    uint64_t rings_addr = IO_PRINT_ADDR + header_size;
+
+    device->print_pending = false;
+
+    vx_buffer_h hbuffer;
+    if (vx_alloc_shared_mem(device, header_size + num_rings * ring_size, &hbuffer) != 0)
+        return -1;
+    auto buffer = (vx_buffer_t*)hbuffer;
+    auto data = (const uint8_t*)buffer->host_ptr;
+
+    // fetch the write counts, then what each ring received since the last drain
+    int ret = copy_from_dev(buffer, IO_PRINT_ADDR, header_size, 0);
+    auto counts = (const uint32_t*)data + IO_PRINT_HEADER_WORDS;
+    std::vector<vx_copy_desc_t> descs;
+    if (0 == ret) {
+        for (uint32_t tid = 0; tid < num_rings; ++tid) {
+            uint32_t written = counts[tid] - device->print_counts[tid];
+            if (0 == written)
+                continue;
+            size_t offset = header_size + tid * ring_size;
+            descs.push_back({rings_addr + tid * ring_size, offset, std::min<size_t>(written, ring_size)});
+        }
+        if (!descs.empty()) {
+            ret = copy_batch(buffer, descs.data(), descs.size(), false);
+        }
+    }
+
+    if (0 == ret) {
+        for (auto& desc : descs) {
+            uint32_t tid = (desc.dev_maddr - rings_addr) >> IO_PRINT_LOG2_SIZE;
+            uint32_t count = counts[tid];
+            uint32_t written = count - device->print_counts[tid];
+            if (written > ring_size) {
+                std::cout << std::dec << "#" << tid << ": [" << (written - ring_size) << " bytes dropped]" << std::endl;
+            }
+            std::string line;
+            for (uint32_t i = count - desc.size; i != count; ++i) {
+                char c = data[desc.offset + (i & (ring_size - 1))];
+                line += c;
+                if (c == '\n') {
+                    std::cout << std::dec << "#" << tid << ": " << line << std::flush;
+                    line.clear();
+                }
+            }
+            if (!line.empty()) {
+                std::cout << std::dec << "#" << tid << ": " << line << std::endl;
+            }
+            device->print_counts[tid] = count;
+        }
+    }
+
+    vx_buf_release(hbuffer);
+
+    return ret;
+}
+
+static int start(vx_device_t *device) {
+    // Ensure ready for new command
+    if (ready_wait(device, -1) != 0)
+        return -1;    
+
+    // the kernel may overwrite uploaded data
+    device->resident_cache.invalidate_writable();
+
+    // start execution    
+    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_CMD_TYPE, CMD_RUN));
+    device->print_pending = true;
 
     return 0;
 }
 
+extern int vx_ready_wait(vx_device_h hdevice, long long timeout) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+
+    // complete pending commands
+    auto start = std::chrono::steady_clock::now();
+    if (!device->queue.finish(timeout))
+        return VX_EVENT_PENDING;
+
+    return ready_wait(device, vortex::remaining_timeout(timeout, start));
+}
+
+extern int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    if (check_copy_args(buffer, dev_maddr, size, src_offset) != 0)
+        return -1;
+
+    device->queue.finish(-1);
+
+    return copy_to_dev(buffer, dev_maddr, size, src_offset);
+}
+
 extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset) {
     if (nullptr == hbuffer 
      || 0 >= size)
@@ -479,51 +884,110 @@ extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size,
     vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
     vx_device_t *device = ((vx_device_t*)buffer->hdevice);
 
-    size_t dev_mem_size = LOCAL_MEM_SIZE;  
-    size_t asize = align_size(size, CACHE_BLOCK_SIZE);
+    if (check_copy_args(buffer, dev_maddr, size, dest_offset) != 0)
+        return -1;
 
-    // check alignment
-    if (!is_aligned(dev_maddr, CACHE_BLOCK_SIZE))
+    device->queue.finish(-1);
+
+    return copy_from_dev(buffer, dev_maddr, size, dest_offset);
+}
+
+extern int vx_copy_to_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
         return -1;
-    if (!is_aligned(buffer->io_addr + dest_offset, CACHE_BLOCK_SIZE))
-        return -1; 
 
-    // bound checking
-    if (dest_offset + asize > buffer->size)
+    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    if (vx_check_copy_descs(descs, count, buffer->size) != 0)
         return -1;
-    if (dev_maddr + asize > dev_mem_size)
+
+    device->queue.finish(-1);
+
+    return copy_batch(buffer, descs, count, true);
+}
+
+extern int vx_copy_from_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
         return -1;
 
-    // Ensure ready for new command
-    if (vx_ready_wait(buffer->hdevice, -1) != 0)
+    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    if (vx_check_copy_descs(descs, count, buffer->size) != 0)
         return -1;
 
-    auto ls_shift = (int)std::log2(CACHE_BLOCK_SIZE);
+    device->queue.finish(-1);
 
-    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_IO_ADDR, (buffer->io_addr + dest_offset) >> ls_shift));
-    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_MEM_ADDR, dev_maddr >> ls_shift));    
-    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_DATA_SIZE, asize >> ls_shift));   
-    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_CMD_TYPE, CMD_MEM_READ));
+    return copy_batch(buffer, descs, count, false);
+}
 
-    // Wait for the write operation to finish
-    if (vx_ready_wait(buffer->hdevice, -1) != 0)
+extern int vx_start(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return -1;   
+
+    vx_device_t *device = ((vx_device_t*)hdevice);
+
+    device->queue.finish(-1);
+
+    return start(device);
+}
+
+extern int vx_enqueue_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
         return -1;
 
+    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    if (check_copy_args(buffer, dev_maddr, size, src_offset) != 0)
+        return -1;
+
+    auto event = device->queue.enqueue([=]{ 
+        return copy_to_dev(buffer, dev_maddr, size, src_offset); 
+    });
+    vortex::make_event_handle(event, hevent);
+
     return 0;
 }
 
-extern int vx_start(vx_device_h hdevice) {
+extern int vx_enqueue_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    vx_buffer_t *buffer = ((vx_buffer_t*)hbuffer);
+    vx_device_t *device = ((vx_device_t*)buffer->hdevice);
+
+    if (check_copy_args(buffer, dev_maddr, size, dest_offset) != 0)
+        return -1;
+
+    auto event = device->queue.enqueue([=]{ 
+        return copy_from_dev(buffer, dev_maddr, size, dest_offset); 
+    });
+    vortex::make_event_handle(event, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_start(vx_device_h hdevice, vx_event_h* hevent) {
     if (nullptr == hdevice)
         return -1;   
 
     vx_device_t *device = ((vx_device_t*)hdevice);
 
-    // Ensure ready for new command
-    if (vx_ready_wait(hdevice, -1) != 0)
-        return -1;    
-  
-    // start execution    
-    CHECK_RES(fpgaWriteMMIO64(device->fpga, 0, MMIO_CMD_TYPE, CMD_RUN));
+    auto event = device->queue.enqueue([=]{ 
+        int ret = start(device);
+        if (ret != 0)
+            return ret;
+        return ready_wait(device, -1); 
+    });
+    vortex::make_event_handle(event, hevent);
 
     return 0;
 }
\ No newline at end of file
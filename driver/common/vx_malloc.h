@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <assert.h>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+
+namespace vortex {
+
+// Device memory allocator.
+// Allocations are served from per-size-class free lists (one class per
+// power-of-two block size) backed by a buddy system: larger free blocks are
+// split on demand and released blocks are merged back with their buddy.
+// Blocks are at least min_block_size (a cache line) in size and alignment.
+// The lowest suitable free block is always selected first to keep the device
+// heap compact at the bottom of the address range.
+class MemoryAllocator {
+public:
+    struct stats_t {
+        uint64_t capacity;      // total managed bytes
+        uint64_t used;          // bytes held by live blocks
+        uint64_t requested;     // bytes requested by live allocations
+        uint64_t peak;          // high-water mark of used bytes
+        uint64_t allocs;        // number of successful allocations
+        uint64_t frees;         // number of successful releases
+        uint64_t failures;      // number of failed allocations
+    };
+
+    MemoryAllocator(uint64_t base_addr, uint64_t size, uint64_t min_block_size)
+        : base_addr_(base_addr)
+        , min_order_(log2floor(min_block_size)) {
+        assert(0 == (min_block_size & (min_block_size - 1)));
+        free_lists_.resize(64);
+        stats_ = stats_t();
+
+        // carve the address range into maximal aligned power-of-two blocks
+        uint64_t offset = 0;
+        uint64_t end = size & ~(min_block_size - 1);
+        while (offset < end) {
+            uint32_t order = (offset != 0) ? __builtin_ctzll(offset) : 63;
+            while (order > min_order_ 
+                && (offset + (uint64_t(1) << order)) > end) {
+                --order;
+            }
+            free_lists_.at(order).insert(offset);
+            offset += uint64_t(1) << order;
+        }
+        stats_.capacity = end;
+    }
+
+    int allocate(uint64_t size, uint64_t* addr) {
+        if (0 == size || nullptr == addr)
+            return -1;
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        uint32_t order = this->size_to_order(size);
+        if (order >= free_lists_.size()) {
+            ++stats_.failures;
+            return -1;
+        }
+
+        // find the lowest free block large enough for the request
+        uint32_t avail = free_lists_.size();
+        for (uint32_t i = order; i < free_lists_.size(); ++i) {
+            if (free_lists_[i].empty())
+                continue;
+            if (avail == free_lists_.size() 
+             || *free_lists_[i].begin() < *free_lists_[avail].begin()) {
+                avail = i;
+            }
+        }
+        if (avail == free_lists_.size()) {
+            ++stats_.failures;
+            return -1;
+        }
+
+        auto it = free_lists_[avail].begin();
+        uint64_t offset = *it;
+        free_lists_[avail].erase(it);
+
+        // split down to the requested size class, releasing upper halves
+        while (avail > order) {
+            --avail;
+            free_lists_[avail].insert(offset + (uint64_t(1) << avail));
+        }
+
+        allocations_[offset] = {order, size};
+
+        uint64_t block_size = uint64_t(1) << order;
+        stats_.used += block_size;
+        stats_.requested += size;
+        if (stats_.used > stats_.peak) {
+            stats_.peak = stats_.used;
+        }
+        ++stats_.allocs;
+
+        *addr = base_addr_ + offset;
+        return 0;
+    }
+
+    int release(uint64_t addr) {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        if (addr < base_addr_)
+            return -1;
+
+        uint64_t offset = addr - base_addr_;
+        auto it = allocations_.find(offset);
+        if (it == allocations_.end())
+            return -1;
+
+        uint32_t order = it->second.order;
+        stats_.used -= uint64_t(1) << order;
+        stats_.requested -= it->second.size;
+        ++stats_.frees;
+        allocations_.erase(it);
+
+        // merge with free buddies
+        while (order + 1 < free_lists_.size()) {
+            uint64_t buddy = offset ^ (uint64_t(1) << order);
+            auto& free_list = free_lists_[order];
+            auto buddy_it = free_list.find(buddy);
+            if (buddy_it == free_list.end())
+                break;
+            free_list.erase(buddy_it);
+            offset &= ~(uint64_t(1) << order);
+            ++order;
+        }
+        free_lists_[order].insert(offset);
+
+        return 0;
+    }
+
+    // take a fixed address range out of the heap, before any allocation
+    int reserve(uint64_t addr, uint64_t size) {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        if (addr < base_addr_ || !allocations_.empty())
+            return -1;
+
+        uint64_t min_block_size = uint64_t(1) << min_order_;
+        uint64_t start = (addr - base_addr_) & ~(min_block_size - 1);
+        uint64_t end = (addr - base_addr_ + size + min_block_size - 1) & ~(min_block_size - 1);
+
+        // pull the overlapping free blocks
+        std::vector<std::pair<uint64_t, uint32_t>> blocks;
+        for (uint32_t order = min_order_; order < free_lists_.size(); ++order) {
+            auto& free_list = free_lists_[order];
+            for (auto it = free_list.begin(); it != free_list.end();) {
+                if (*it < end && *it + (uint64_t(1) << order) > start) {
+                    blocks.emplace_back(*it, order);
+                    it = free_list.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        // drop the covered blocks, split the others
+        while (!blocks.empty()) {
+            auto block = blocks.back();
+            blocks.pop_back();
+            uint64_t offset = block.first;
+            uint32_t order = block.second;
+            if (offset >= start && offset + (uint64_t(1) << order) <= end) {
+                stats_.capacity -= uint64_t(1) << order;
+                continue;
+            }
+            --order;
+            for (uint64_t half : {offset, offset + (uint64_t(1) << order)}) {
+                if (half < end && half + (uint64_t(1) << order) > start) {
+                    blocks.emplace_back(half, order);
+                } else {
+                    free_lists_[order].insert(half);
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    stats_t stats() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_;
+    }
+
+    uint64_t free_size() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_.capacity - stats_.used;
+    }
+
+    uint64_t used_size() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_.used;
+    }
+
+private:
+
+    struct allocation_t {
+        uint32_t order;
+        uint64_t size;
+    };
+
+    static uint32_t log2floor(uint64_t value) {
+        return 63 - __builtin_clzll(value);
+    }
+
+    uint32_t size_to_order(uint64_t size) const {
+        if (size <= (uint64_t(1) << min_order_))
+            return min_order_;
+        return 64 - __builtin_clzll(size - 1);
+    }
+
+    uint64_t base_addr_;
+    uint32_t min_order_;
+    std::vector<std::set<uint64_t>> free_lists_;
+    std::unordered_map<uint64_t, allocation_t> allocations_;
+    stats_t stats_;
+    mutable std::mutex mutex_;
+};
+
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vortex.h>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace vortex {
+
+// Completion event of an enqueued device command.
+class CommandEvent {
+public:
+    CommandEvent()
+        : complete_(false)
+        , result_(0)
+    {}
+
+    void signal(int result) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            complete_ = true;
+            result_ = result;
+        }
+        cv_.notify_all();
+    }
+
+    bool query(int* result) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (complete_ && result) {
+            *result = result_;
+        }
+        return complete_;
+    }
+
+    // wait for completion with milliseconds timeout (negative = infinite)
+    bool wait(long long timeout, int* result) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto is_complete = [&]{ return complete_; };
+        if (timeout < 0) {
+            cv_.wait(lock, is_complete);
+        } else {
+            cv_.wait_for(lock, std::chrono::milliseconds(timeout), is_complete);
+        }
+        if (complete_ && result) {
+            *result = result_;
+        }
+        return complete_;
+    }
+
+private:
+    bool complete_;
+    int result_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+typedef std::shared_ptr<CommandEvent> CommandEventPtr;
+
+// In-order device command queue.
+// Commands are executed asynchronously by a submission thread that is
+// started on first use. Pending commands are drained on destruction.
+class CommandQueue {
+public:
+    typedef std::function<int()> command_t;
+
+    CommandQueue()
+        : pending_(0)
+        , stop_(false)
+    {}
+
+    ~CommandQueue() {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stop_ = true;
+        }
+        cmd_cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    CommandEventPtr enqueue(const command_t& command) {
+        auto event = std::make_shared<CommandEvent>();
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!thread_.joinable()) {
+                thread_ = std::thread(&CommandQueue::thread_proc, this);
+            }
+            commands_.emplace_back(command, event);
+            ++pending_;
+        }
+        cmd_cv_.notify_one();
+        return event;
+    }
+
+    // wait until all enqueued commands have completed
+    // returns false on timeout (milliseconds, negative = infinite)
+    bool finish(long long timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto is_idle = [&]{ return 0 == pending_; };
+        if (timeout < 0) {
+            idle_cv_.wait(lock, is_idle);
+            return true;
+        }
+        return idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout), is_idle);
+    }
+
+private:
+
+    void thread_proc() {
+        for (;;) {
+            std::pair<command_t, CommandEventPtr> entry;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cmd_cv_.wait(lock, [&]{ return stop_ || !commands_.empty(); });
+                if (commands_.empty())
+                    break; // stopped and drained
+                entry = std::move(commands_.front());
+                commands_.pop_front();
+            }
+
+            int result = entry.first();
+            entry.second->signal(result);
+
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                --pending_;
+            }
+            idle_cv_.notify_all();
+        }
+    }
+
+    std::deque<std::pair<command_t, CommandEventPtr>> commands_;
+    size_t pending_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cmd_cv_;
+    std::condition_variable idle_cv_;
+    std::thread thread_;
+};
+
+// milliseconds left of a timeout started at start (negative = infinite)
+inline long long remaining_timeout(long long timeout, std::chrono::steady_clock::time_point start) {
+    if (timeout <= 0)
+        return timeout;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return (elapsed < timeout) ? (timeout - elapsed) : 0;
+}
+
+// return a user handle for an event (if requested)
+inline void make_event_handle(const CommandEventPtr& event, vx_event_h* hevent) {
+    if (hevent) {
+        *hevent = new CommandEventPtr(event);
+    }
+}
+
+}
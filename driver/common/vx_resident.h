@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vortex.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <iterator>
+#include <mutex>
+
+namespace vortex {
+
+// Host copies of device memory blocks uploaded by the host.
+// Blocks that are still resident with the same content can be skipped on
+// re-upload. Any other host write to a block drops it. The device is not
+// observed, so writable blocks are dropped when a kernel is started and only
+// blocks uploaded as read-only survive a launch. Ranges mapped into host
+// memory are never tracked.
+class ResidentCache {
+public:
+
+    // true if the block holds the same bytes
+    bool lookup(uint64_t addr, const void* data, uint64_t size) const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto it = blocks_.find(addr);
+        return it != blocks_.end()
+            && it->second.bytes.size() == size
+            && 0 == std::memcmp(it->second.bytes.data(), data, size);
+    }
+
+    // record block content after it was written
+    void update(uint64_t addr, const void* data, uint64_t size, bool read_only) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        this->erase(addr, size);
+        for (auto& mapping : mappings_) {
+            if (addr < mapping.first + mapping.second
+             && mapping.first < addr + size)
+                return;
+        }
+        auto bytes = (const uint8_t*)data;
+        auto& block = blocks_[addr];
+        block.bytes.assign(bytes, bytes + size);
+        block.read_only = read_only;
+    }
+
+    // drop blocks overwritten by the host or the device
+    void invalidate(uint64_t addr, uint64_t size) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        this->erase(addr, size);
+    }
+
+    // drop the blocks a kernel may have modified
+    void invalidate_writable() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (auto it = blocks_.begin(); it != blocks_.end();) {
+            if (it->second.read_only) {
+                ++it;
+            } else {
+                it = blocks_.erase(it);
+            }
+        }
+    }
+
+    // exclude a range mapped into host memory
+    void map(uint64_t addr, uint64_t size) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        this->erase(addr, size);
+        mappings_[addr] = size;
+    }
+
+    void unmap(uint64_t addr) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        mappings_.erase(addr);
+    }
+
+private:
+
+    struct block_t {
+        std::vector<uint8_t> bytes;
+        bool read_only;
+    };
+
+    void erase(uint64_t addr, uint64_t size) {
+        // blocks never overlap, so only the previous one can start below addr
+        auto it = blocks_.lower_bound(addr);
+        if (it != blocks_.begin()) {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second.bytes.size() > addr) {
+                it = prev;
+            }
+        }
+        while (it != blocks_.end() && it->first < addr + size) {
+            it = blocks_.erase(it);
+        }
+    }
+
+    std::map<uint64_t, block_t> blocks_;
+    std::map<uint64_t, uint64_t> mappings_;
+    mutable std::mutex mutex_;
+};
+
+}
+
+// per-device resident cache, NULL if the driver does not track uploads
+vortex::ResidentCache* vx_resident_cache(vx_device_h hdevice);
@@ -1,18 +1,26 @@
 #include "vx_scope.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <thread>
 #include <chrono>
 #include <vector>
+#include <deque>
+#include <string>
+#include <memory>
 #include <assert.h>
-#include <chrono>
-#include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <VX_config.h>
 #include <vortex_afu.h>
 #include <scope-defs.h>
 
-#define FRAME_FLUSH_SIZE 100
+// frames read per MMIO batch
+#define FRAME_BATCH_SIZE 4096
+
+// writer buffer flush threshold
+#define WRITE_BUFFER_SIZE (1 << 20)
 
 #define CHECK_RES(_expr)                            \
    do {                                             \
@@ -45,6 +53,8 @@ constexpr int calcFrameWidth(int index = 0) {
 
 static constexpr int fwidth = calcFrameWidth();
 
+static constexpr int frame_words = (fwidth + 63) / 64;
+
 #ifdef HANG_TIMEOUT
 static std::thread g_timeout_thread;
 static std::mutex g_timeout_mutex;
@@ -57,41 +67,378 @@ static void timeout_callback(fpga_handle fpga) {
 }
 #endif
 
-uint64_t print_clock(std::ofstream& ofs, uint64_t delta, uint64_t timestamp) {
-    while (delta != 0) {
-        ofs << '#' << timestamp++ << std::endl;
-        ofs << "b0 0" << std::endl;
-        ofs << '#' << timestamp++ << std::endl;
-        ofs << "b1 0" << std::endl;
-        --delta;
+///////////////////////////////////////////////////////////////////////////////
+
+// extract up to 64 bits starting at bit position pos of a frame
+static uint64_t get_bits(const uint64_t* words, int pos, int count) {
+    int shift = pos % 64;
+    uint64_t value = words[pos / 64] >> shift;
+    if (shift + count > 64) {
+        value |= words[pos / 64 + 1] << (64 - shift);
+    }
+    if (count < 64) {
+        value &= (uint64_t(1) << count) - 1;
     }
-    return timestamp;
+    return value;
 }
 
-void dump_taps(std::ofstream& ofs, int module) {    
-     for (int i = 0; i < num_taps; ++i) {
-        auto& tap = scope_taps[i];
-        if (tap.module != module)
-            continue;
-        ofs << "$var reg " << tap.width << " " << (i + 1) << " " << tap.name << " $end" << std::endl;                
+// Frames pack the taps in reverse order: the last tap starts at bit 0.
+// A tap value is stored as 64-bit chunks, least significant first.
+class FrameDecoder {
+public:
+    FrameDecoder() : offsets_(num_taps), chunks_(num_taps) {
+        int pos = 0;
+        int nchunks = 0;
+        for (int i = num_taps - 1; i >= 0; --i) {
+            offsets_[i] = pos;
+            chunks_[i] = nchunks;
+            pos += scope_taps[i].width;
+            nchunks += (scope_taps[i].width + 63) / 64;
+        }
+        values_.resize(nchunks);
+        prev_values_.resize(nchunks);
+    }
+
+    void decode(const uint64_t* words) {
+        values_.swap(prev_values_);
+        for (int i = 0; i < num_taps; ++i) {
+            auto value = &values_[chunks_[i]];
+            for (int j = 0, w = scope_taps[i].width; w > 0; ++j, w -= 64) {
+                value[j] = get_bits(words, offsets_[i] + j * 64, std::min(w, 64));
+            }
+        }
+    }
+
+    const uint64_t* value(int tap) const {
+        return &values_[chunks_[tap]];
+    }
+
+    bool changed(int tap) const {
+        int nchunks = (scope_taps[tap].width + 63) / 64;
+        for (int j = 0; j < nchunks; ++j) {
+            if (values_[chunks_[tap] + j] != prev_values_[chunks_[tap] + j])
+                return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<int> offsets_;
+    std::vector<int> chunks_;
+    std::vector<uint64_t> values_;
+    std::vector<uint64_t> prev_values_;
+};
+
+class ScopeWriter {
+public:
+    virtual ~ScopeWriter() {}
+
+    // record a frame captured after the given number of clock cycles
+    virtual void frame(uint64_t cycles, const FrameDecoder& decoder, bool first) = 0;
+
+    virtual int close() = 0;
+
+protected:
+
+    void write(const char* data, size_t size) {
+        buffer_.append(data, size);
+        if (buffer_.size() >= WRITE_BUFFER_SIZE) {
+            this->flush();
+        }
+    }
+
+    void write(const std::string& str) {
+        this->write(str.data(), str.size());
+    }
+
+    void flush() {
+        ofs_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+    std::ofstream ofs_;
+    std::string buffer_;
+};
+
+// Value Change Dump export, only changed taps are written after the first frame.
+class VcdWriter : public ScopeWriter {
+public:
+    VcdWriter(const char* filename) : timestamp_(0) {
+        ofs_.open(filename);
+        buffer_.reserve(WRITE_BUFFER_SIZE + 4096);
+        this->write("$version Generated by Vortex Scope $end\n"
+                    "$timescale 1 ns $end\n"
+                    "$scope module TOP $end\n");
+        this->dump_module(-1);
+        this->dump_taps(-1);
+        this->write("$upscope $end\n"
+                    "enddefinitions $end\n");
+    }
+
+    void frame(uint64_t cycles, const FrameDecoder& decoder, bool first) override {
+        char tmp[64];
+        while (cycles != 0) {
+            int len = snprintf(tmp, sizeof(tmp), "#%lu\nb0 0\n#%lu\nb1 0\n",
+                               (unsigned long)timestamp_, (unsigned long)(timestamp_ + 1));
+            this->write(tmp, len);
+            timestamp_ += 2;
+            --cycles;
+        }
+        for (int i = num_taps - 1; i >= 0; --i) {
+            if (!first && !decoder.changed(i))
+                continue;
+            auto value = decoder.value(i);
+            int width = scope_taps[i].width;
+            std::string line(width + 1, 'b');
+            for (int b = 0; b < width; ++b) {
+                line[width - b] = ((value[b / 64] >> (b % 64)) & 0x1) ? '1' : '0';
+            }
+            line += ' ';
+            line += std::to_string(i + 1);
+            line += '\n';
+            this->write(line);
+        }
+    }
+
+    int close() override {
+        this->flush();
+        ofs_.close();
+        std::cout << "scope trace dump done! - " << (timestamp_/2) << " cycles" << std::endl;
+        return 0;
+    }
+
+private:
+
+    void dump_taps(int module) {
+        for (int i = 0; i < num_taps; ++i) {
+            auto& tap = scope_taps[i];
+            if (tap.module != module)
+                continue;
+            this->write("$var reg " + std::to_string(tap.width) + " " + std::to_string(i + 1) + " " + tap.name + " $end\n");
+        }
+    }
+
+    void dump_module(int parent) {
+        for (auto& module : scope_modules) {
+            if (module.parent != parent)
+                continue;
+            if (module.name[0] == '*') {
+                this->write("$var reg 1 0 clk $end\n");
+            } else {
+                this->write(std::string("$scope module ") + module.name + " $end\n");
+            }
+            this->dump_module(module.index);
+            this->dump_taps(module.index);
+            if (module.name[0] != '*') {
+                this->write("$upscope $end\n");
+            }
+        }
+    }
+
+    uint64_t timestamp_;
+};
+
+// Columnar binary trace (little-endian), converted to VCD by hw/scripts/scope2vcd.py
+//   header : "VXSCOPE\0", u32 version
+//   modules: u32 count, {i32 index, i32 parent, u16 length, name}
+//   taps   : u32 count, {i32 module, u32 width, u16 length, name}
+//   frames : u64 count
+//   clocks : u64 size, varint cycles elapsed before each frame (idle clocks run-length)
+//   values : per tap, u64 size, {varint run length, value in (width+7)/8 bytes}
+class BinWriter : public ScopeWriter {
+public:
+    BinWriter(const char* filename)
+        : num_frames_(0)
+        , num_cycles_(0)
+        , columns_(num_taps)
+        , values_(num_taps)
+        , runs_(num_taps, 0) {
+        ofs_.open(filename, std::ios::binary);
+    }
+
+    void frame(uint64_t cycles, const FrameDecoder& decoder, bool first) override {
+        put_varint(clocks_, cycles);
+        num_cycles_ += cycles;
+        for (int i = 0; i < num_taps; ++i) {
+            if (first) {
+                values_[i] = this->bytes(i, decoder.value(i));
+            } else if (decoder.changed(i)) {
+                this->end_run(i);
+                values_[i] = this->bytes(i, decoder.value(i));
+            }
+            ++runs_[i];
+        }
+        ++num_frames_;
+    }
+
+    int close() override {
+        this->write("VXSCOPE", 8);
+        this->put_u32(1);
+        this->put_u32(num_modules);
+        for (auto& module : scope_modules) {
+            this->put_u32(module.index);
+            this->put_u32(module.parent);
+            this->put_name(module.name);
+        }
+        this->put_u32(num_taps);
+        for (auto& tap : scope_taps) {
+            this->put_u32(tap.module);
+            this->put_u32(tap.width);
+            this->put_name(tap.name);
+        }
+        this->put_u64(num_frames_);
+        this->put_u64(clocks_.size());
+        this->write(clocks_.data(), clocks_.size());
+        for (int i = 0; i < num_taps; ++i) {
+            if (num_frames_ != 0) {
+                this->end_run(i);
+            }
+            this->put_u64(columns_[i].size());
+            this->write(columns_[i].data(), columns_[i].size());
+        }
+        this->flush();
+        ofs_.close();
+        std::cout << "scope trace dump done! - " << num_cycles_ << " cycles" << std::endl;
+        return 0;
+    }
+
+private:
+
+    static void put_varint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += char((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out += char(value);
+    }
+
+    void end_run(int tap) {
+        put_varint(columns_[tap], runs_[tap]);
+        columns_[tap] += values_[tap];
+        runs_[tap] = 0;
+    }
+
+    std::string bytes(int tap, const uint64_t* value) const {
+        int nbytes = (scope_taps[tap].width + 7) / 8;
+        std::string out(nbytes, 0);
+        for (int b = 0; b < nbytes; ++b) {
+            out[b] = char(value[b / 8] >> ((b % 8) * 8));
+        }
+        return out;
+    }
+
+    void put_u32(uint32_t value) {
+        char tmp[4];
+        for (int i = 0; i < 4; ++i) tmp[i] = char(value >> (i * 8));
+        this->write(tmp, 4);
+    }
+
+    void put_u64(uint64_t value) {
+        char tmp[8];
+        for (int i = 0; i < 8; ++i) tmp[i] = char(value >> (i * 8));
+        this->write(tmp, 8);
+    }
+
+    void put_name(const char* name) {
+        uint16_t len = strlen(name);
+        char tmp[2] = {char(len), char(len >> 8)};
+        this->write(tmp, 2);
+        this->write(name, len);
+    }
+
+    uint64_t num_frames_;
+    uint64_t num_cycles_;
+    std::string clocks_;
+    std::vector<std::string> columns_;
+    std::vector<std::string> values_;
+    std::vector<uint64_t> runs_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// raw frames handed from the MMIO reader to the decoder thread,
+// each frame is a delta word followed by frame_words data words
+struct FrameQueue {
+    std::deque<std::vector<uint64_t>> batches;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    void push(std::vector<uint64_t>&& batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.emplace_back(std::move(batch));
+        }
+        cv.notify_one();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cv.notify_one();
+    }
+
+    bool pop(std::vector<uint64_t>* batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]{ return done || !batches.empty(); });
+        if (batches.empty())
+            return false;
+        *batch = std::move(batches.front());
+        batches.pop_front();
+        return true;
+    }
+};
+
+static void decode_frames(FrameQueue* queue, ScopeWriter* writer, uint64_t offset) {
+    FrameDecoder decoder;
+    std::vector<uint64_t> batch;
+    bool first = true;
+    while (queue->pop(&batch)) {
+        for (size_t i = 0; i < batch.size(); i += (1 + frame_words)) {
+            uint64_t delta = batch[i];
+            decoder.decode(&batch[i + 1]);
+            writer->frame(first ? (offset + delta + 2) : (delta + 1), decoder, first);
+            first = false;
+        }
     }
 }
 
-void dump_module(std::ofstream& ofs, int parent) {
-    for (auto& module : scope_modules) {
-        if (module.parent != parent)
-            continue;
-        if (module.name[0] == '*') {
-            ofs << "$var reg 1 0 clk $end" << std::endl;
-        } else {
-            ofs << "$scope module " << module.name << " $end" << std::endl;
-        }        
-        dump_module(ofs, module.index);
-        dump_taps(ofs, module.index);
-        if (module.name[0] != '*') {
-            ofs << "$upscope $end" << std::endl;
+static int read_frames(fpga_handle hfpga, uint64_t max_frames, FrameQueue* queue) {
+    std::vector<uint64_t> batch;
+    batch.reserve(FRAME_BATCH_SIZE * (1 + frame_words));
+
+    for (uint64_t frame_no = 0; frame_no < max_frames; ++frame_no) {
+        if (frame_no == (max_frames-1)) {
+            // verify last frame is valid
+            uint64_t data_valid;
+            CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_VALID));
+            CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &data_valid));
+            assert(data_valid == 1);
+            CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_DATA));
+        }
+
+        // delta word followed by the frame data words
+        for (int i = 0; i <= frame_words; ++i) {
+            uint64_t word;
+            CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &word));
+            batch.push_back(word);
+        }
+
+        if (batch.size() == batch.capacity()) {
+            queue->push(std::move(batch));
+            batch = std::vector<uint64_t>();
+            batch.reserve(FRAME_BATCH_SIZE * (1 + frame_words));
+            std::cout << "*** " << (frame_no + 1) << "/" << max_frames << " frames" << std::endl;
         }
     }
+
+    if (!batch.empty()) {
+        queue->push(std::move(batch));
+    }
+
+    return 0;
 }
 
 int vx_scope_start(fpga_handle hfpga, uint64_t start_time, uint64_t stop_time) {    
@@ -133,23 +480,7 @@ int vx_scope_stop(fpga_handle hfpga) {
 
     std::cout << "scope trace dump begin..." << std::endl;
 
-    std::ofstream ofs("trace.vcd");
-
-    ofs << "$version Generated by Vortex Scope $end" << std::endl;
-    ofs << "$timescale 1 ns $end" << std::endl;
-    ofs << "$scope module TOP $end" << std::endl;
-    
-    dump_module(ofs, -1);
-    dump_taps(ofs, -1);
-    ofs << "$upscope $end" << std::endl;
-    ofs << "enddefinitions $end" << std::endl;
-
-    uint64_t frame_width, max_frames, data_valid, offset, delta;   
-    uint64_t timestamp = 0;
-    uint64_t frame_offset = 0;
-    uint64_t frame_no = 0;  
-    int signal_id = 0;
-    int signal_offset = 0; 
+    uint64_t frame_width, max_frames, data_valid, offset;
 
     // wait for recording to terminate
     CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_VALID));
@@ -182,64 +513,22 @@ int vx_scope_stop(fpga_handle hfpga) {
     // get data
     CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_DATA));
 
-    // print clock header
-    CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &delta));
-    timestamp = print_clock(ofs, offset + delta + 2, timestamp);
-    signal_id = num_taps;
-
-    std::vector<char> signal_data(frame_width+1);
-
-    do {
-        if (frame_no == (max_frames-1)) {
-            // verify last frame is valid
-            CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_VALID));
-            CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &data_valid));  
-            assert(data_valid == 1);
-            CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_DATA));
-        }
-
-        // read next data words
-        uint64_t word;
-        CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &word));
-        
-        do {          
-            int signal_width = scope_taps[signal_id-1].width;
-            int word_offset = frame_offset % 64;
-
-            signal_data[signal_width - signal_offset - 1] = ((word >> word_offset) & 0x1) ? '1' : '0';
-
-            ++signal_offset;
-            ++frame_offset;
-
-            if (signal_offset == signal_width) {
-                signal_data[signal_width] = 0; // string null termination
-                ofs << 'b' << signal_data.data() << ' ' << signal_id << std::endl;
-                signal_offset = 0;            
-                --signal_id;
-            }
-
-            if (frame_offset == frame_width) {   
-                assert(0 == signal_offset);   
-                frame_offset = 0;
-                ++frame_no;
-
-                if (frame_no != max_frames) {    
-                    // print clock header
-                    CHECK_RES(fpgaReadMMIO64(hfpga, 0, MMIO_SCOPE_READ, &delta));
-                    timestamp = print_clock(ofs, delta + 1, timestamp);            
-                    signal_id = num_taps;
-                    if (0 == (frame_no % FRAME_FLUSH_SIZE)) {
-                        ofs << std::flush;
-                        std::cout << "*** " << frame_no << "/" << max_frames << " frames" << std::endl;
-                    }
-                }                     
-            }
-            
-        } while ((frame_offset % 64) != 0);
+#ifdef SCOPE_BIN
+    std::unique_ptr<ScopeWriter> writer(new BinWriter("trace.scope"));
+#else
+    std::unique_ptr<ScopeWriter> writer(new VcdWriter("trace.vcd"));
+#endif
 
-    } while (frame_no != max_frames);
+    // decode frames while the next batch is being read
+    FrameQueue queue;
+    std::thread decoder(decode_frames, &queue, writer.get(), offset);
+    int ret = read_frames(hfpga, max_frames, &queue);
+    queue.close();
+    decoder.join();
+    if (ret != 0)
+        return ret;
 
-    std::cout << "scope trace dump done! - " << (timestamp/2) << " cycles" << std::endl;
+    writer->close();
 
     // verify data not valid
     CHECK_RES(fpgaWriteMMIO64(hfpga, 0, MMIO_SCOPE_WRITE, CMD_GET_VALID));
@@ -1,24 +1,53 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include <vortex.h>
 #include <VX_config.h>
+#include "vx_queue.h"
+#include "vx_resident.h"
+#include "vx_utils.h"
+
+// resident cache granularity
+#define UPLOAD_BLOCK_SIZE     1024
+
+// staging buffer size
+#define UPLOAD_BUFFER_SIZE    65536
+
+// append a region, merging it with the previous one if contiguous
+static void add_region(std::vector<vx_copy_desc_t>& descs, size_t dev_maddr, size_t offset, size_t size) {
+  if (!descs.empty()) {
+    auto& last = descs.back();
+    if (last.dev_maddr + last.size == dev_maddr 
+     && last.offset + last.size == offset) {
+      last.size += size;
+      return;
+    }
+  }
+  descs.push_back({dev_maddr, offset, size});
+}
 
-extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_t size) {
+static int upload_bytes(vx_device_h device, size_t dev_maddr, const void* content, size_t size, bool read_only) {
   int err = 0;
 
   if (NULL == content || 0 == size)
     return -1;
 
-  uint32_t buffer_transfer_size = 65536;
-  unsigned kernel_base_addr;
-  err = vx_dev_caps(device, VX_CAPS_KERNEL_BASE_ADDR, &kernel_base_addr);
-  if (err != 0)
-    return -1;
+  auto cache = vx_resident_cache(device);
+  if (cache) {
+    // the cache is only accurate once prior commands have completed
+    err = vx_ready_wait(device, -1);
+    if (err != 0)
+      return -1;
+  }
 
   // allocate device buffer
   vx_buffer_h buffer;
-  err = vx_alloc_shared_mem(device, buffer_transfer_size, &buffer);
+  err = vx_alloc_shared_mem(device, UPLOAD_BUFFER_SIZE, &buffer);
   if (err != 0)
     return -1; 
 
@@ -29,22 +58,51 @@ extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_
   // upload content
   //
 
+  std::vector<vx_copy_desc_t> blocks, writes;
+
   size_t offset = 0;
   while (offset < size) {
-    auto chunk_size = std::min<size_t>(buffer_transfer_size, size - offset);
-    std::memcpy(buf_ptr, (uint8_t*)content + offset, chunk_size);
+    auto chunk_size = std::min<size_t>(UPLOAD_BUFFER_SIZE, size - offset);
+    auto chunk_ptr = (const uint8_t*)content + offset;
+    auto chunk_addr = dev_maddr + offset;
+
+    // split the chunk at device block boundaries and look up each block
+    blocks.clear();
+    writes.clear();
+    for (size_t pos = 0; pos < chunk_size;) {
+      auto addr = chunk_addr + pos;
+      auto block_end = (addr / UPLOAD_BLOCK_SIZE + 1) * UPLOAD_BLOCK_SIZE;
+      auto block_size = std::min<size_t>(block_end - addr, chunk_size - pos);
+      if (nullptr == cache || !cache->lookup(addr, chunk_ptr + pos, block_size)) {
+        add_region(writes, addr, pos, block_size);
+      }
+      blocks.push_back({addr, pos, block_size});
+      pos += block_size;
+    }
 
-    /*printf("***  Upload Kernel to 0x%0x: data=", kernel_base_addr + offset);
-    for (int i = 0, n = ((chunk_size+7)/8); i < n; ++i) {
-      printf("%08x", ((uint64_t*)((uint8_t*)content + offset))[n-1-i]);
+    // write modified blocks
+    if (!writes.empty()) {
+      for (auto& desc : writes) {
+        std::memcpy(buf_ptr + desc.offset, chunk_ptr + desc.offset, desc.size);
+      }
+      if (writes.size() == 1) {
+        err = vx_copy_to_dev(buffer, writes[0].dev_maddr, writes[0].size, writes[0].offset);
+      } else {
+        err = vx_copy_to_dev_sg(buffer, writes.data(), writes.size());
+      }
+      if (err != 0) {
+        vx_buf_release(buffer);
+        return err;
+      }
     }
-    printf("\n");*/
 
-    err = vx_copy_to_dev(buffer, kernel_base_addr + offset, chunk_size, 0);
-    if (err != 0) {
-      vx_buf_release(buffer);
-      return err;
+    // the whole chunk is now resident
+    if (cache) {
+      for (auto& block : blocks) {
+        cache->update(block.dev_maddr, chunk_ptr + block.offset, block.size, read_only);
+      }
     }
+
     offset += chunk_size;
   }
 
@@ -53,8 +111,42 @@ extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_
   return 0;
 }
 
+extern int vx_upload_bytes(vx_device_h device, size_t dev_maddr, const void* content, size_t size) {
+  return upload_bytes(device, dev_maddr, content, size, false);
+}
+
+extern int vx_upload_const_bytes(vx_device_h device, size_t dev_maddr, const void* content, size_t size) {
+  return upload_bytes(device, dev_maddr, content, size, true);
+}
+
+extern int vx_resident_invalidate(vx_device_h device, size_t dev_maddr, size_t size) {
+  if (0 == size)
+    return -1;
+
+  auto cache = vx_resident_cache(device);
+  if (cache) {
+    cache->invalidate(dev_maddr, size);
+  }
+
+  return 0;
+}
+
+extern int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_t size) {
+  int err = 0;
+
+  if (NULL == content || 0 == size)
+    return -1;
+
+  unsigned kernel_base_addr;
+  err = vx_dev_caps(device, VX_CAPS_KERNEL_BASE_ADDR, &kernel_base_addr);
+  if (err != 0)
+    return -1;
+
+  return vx_upload_bytes(device, kernel_base_addr, content, size);
+}
+
 extern int vx_upload_kernel_file(vx_device_h device, const char* filename) {
-  std::ifstream ifs(filename);
+  std::ifstream ifs(filename, std::ios::binary);
   if (!ifs) {
     std::cout << "error: " << filename << " not found" << std::endl;
     return -1;
@@ -76,6 +168,87 @@ extern int vx_upload_kernel_file(vx_device_h device, const char* filename) {
   return err;
 }
 
+extern int vx_check_copy_descs(const vx_copy_desc_t* descs, unsigned count, size_t buffer_size) {
+  for (unsigned i = 0; i < count; ++i) {
+    if (0 == descs[i].size
+     || descs[i].offset + descs[i].size > buffer_size
+     || descs[i].dev_maddr + descs[i].size > LOCAL_MEM_SIZE)
+      return -1;
+  }
+  return 0;
+}
+
+// one region per row
+static void make_2d_descs(std::vector<vx_copy_desc_t>& descs, size_t dev_maddr, size_t dev_pitch, size_t offset, size_t pitch, size_t width, size_t height) {
+  descs.resize(height);
+  for (size_t y = 0; y < height; ++y) {
+    descs[y].dev_maddr = dev_maddr + y * dev_pitch;
+    descs[y].offset    = offset + y * pitch;
+    descs[y].size      = width;
+  }
+}
+
+extern int vx_copy_to_dev_2d(vx_buffer_h hbuffer, size_t dev_maddr, size_t dev_pitch, size_t src_offset, size_t src_pitch, size_t width, size_t height) {
+  if (0 == width 
+   || 0 == height)
+    return -1;
+
+  std::vector<vx_copy_desc_t> descs;
+  make_2d_descs(descs, dev_maddr, dev_pitch, src_offset, src_pitch, width, height);
+
+  return vx_copy_to_dev_sg(hbuffer, descs.data(), descs.size());
+}
+
+extern int vx_copy_from_dev_2d(vx_buffer_h hbuffer, size_t dev_maddr, size_t dev_pitch, size_t dest_offset, size_t dest_pitch, size_t width, size_t height) {
+  if (0 == width 
+   || 0 == height)
+    return -1;
+
+  std::vector<vx_copy_desc_t> descs;
+  make_2d_descs(descs, dev_maddr, dev_pitch, dest_offset, dest_pitch, width, height);
+
+  return vx_copy_from_dev_sg(hbuffer, descs.data(), descs.size());
+}
+
+extern int vx_event_wait(vx_event_h hevent, long long timeout) {
+  if (nullptr == hevent)
+    return -1;
+
+  auto event = *(vortex::CommandEventPtr*)hevent;
+
+  int result;
+  if (!event->wait(timeout, &result))
+    return VX_EVENT_PENDING;
+
+  return (result != 0) ? -1 : 0;
+}
+
+extern int vx_event_poll(vx_event_h hevent, int* status) {
+  if (nullptr == hevent 
+   || nullptr == status)
+    return -1;
+
+  auto event = *(vortex::CommandEventPtr*)hevent;
+
+  int result;
+  if (!event->query(&result)) {
+    *status = VX_EVENT_PENDING;
+    return 0;
+  }
+
+  *status = VX_EVENT_COMPLETE;
+  return (result != 0) ? -1 : 0;
+}
+
+extern int vx_event_release(vx_event_h hevent) {
+  if (nullptr == hevent)
+    return -1;
+
+  delete (vortex::CommandEventPtr*)hevent;
+
+  return 0;
+}
+
 /*static uint32_t get_csr_32(const uint32_t* buffer, int addr) {
   uint32_t value_lo = buffer[addr - CSR_MPM_BASE];
   return value_lo;
@@ -87,45 +260,81 @@ static uint64_t get_csr_64(const uint32_t* buffer, int addr) {
   return (uint64_t(value_hi) << 32) | value_lo;
 }
 
-extern int vx_dump_perf(vx_device_h device, FILE* stream) {
+typedef struct {
+  const char* name;
+  size_t offset;
+  int csr;
+} perf_counter_t;
+
+#define PERF_COUNTER(field, csr) { #field, offsetof(vx_perf_core_t, field), csr }
+
+static const perf_counter_t perf_counters[] = {
+  PERF_COUNTER(instrs,              CSR_MINSTRET),
+  PERF_COUNTER(cycles,              CSR_MCYCLE),
+  PERF_COUNTER(ibuffer_stalls,      CSR_MPM_IBUF_ST),
+  PERF_COUNTER(scoreboard_stalls,   CSR_MPM_SCRB_ST),
+  PERF_COUNTER(alu_stalls,          CSR_MPM_ALU_ST),
+  PERF_COUNTER(lsu_stalls,          CSR_MPM_LSU_ST),
+  PERF_COUNTER(csr_stalls,          CSR_MPM_CSR_ST),
+  PERF_COUNTER(fpu_stalls,          CSR_MPM_FPU_ST),
+  PERF_COUNTER(gpu_stalls,          CSR_MPM_GPU_ST),
+  PERF_COUNTER(icache_reads,        CSR_MPM_ICACHE_READS),
+  PERF_COUNTER(icache_read_misses,  CSR_MPM_ICACHE_MISS_R),
+  PERF_COUNTER(icache_pipe_stalls,  CSR_MPM_ICACHE_PIPE_ST),
+  PERF_COUNTER(icache_rsp_stalls,   CSR_MPM_ICACHE_CRSP_ST),
+  PERF_COUNTER(dcache_reads,        CSR_MPM_DCACHE_READS),
+  PERF_COUNTER(dcache_writes,       CSR_MPM_DCACHE_WRITES),
+  PERF_COUNTER(dcache_read_misses,  CSR_MPM_DCACHE_MISS_R),
+  PERF_COUNTER(dcache_write_misses, CSR_MPM_DCACHE_MISS_W),
+  PERF_COUNTER(dcache_bank_stalls,  CSR_MPM_DCACHE_BANK_ST),
+  PERF_COUNTER(dcache_mshr_stalls,  CSR_MPM_DCACHE_MSHR_ST),
+  PERF_COUNTER(dcache_pipe_stalls,  CSR_MPM_DCACHE_PIPE_ST),
+  PERF_COUNTER(dcache_rsp_stalls,   CSR_MPM_DCACHE_CRSP_ST),
+  PERF_COUNTER(smem_reads,          CSR_MPM_SMEM_READS),
+  PERF_COUNTER(smem_writes,         CSR_MPM_SMEM_WRITES),
+  PERF_COUNTER(smem_bank_stalls,    CSR_MPM_SMEM_BANK_ST),
+  PERF_COUNTER(mem_reads,           CSR_MPM_MEM_READS),
+  PERF_COUNTER(mem_writes,          CSR_MPM_MEM_WRITES),
+  PERF_COUNTER(mem_stalls,          CSR_MPM_MEM_ST),
+  PERF_COUNTER(mem_latency,         CSR_MPM_MEM_LAT),
+};
+
+#ifdef PERF_ENABLE
+#define NUM_PERF_COUNTERS (sizeof(perf_counters) / sizeof(perf_counter_t))
+#else
+#define NUM_PERF_COUNTERS 2 // instrs and cycles only
+#endif
+
+static uint64_t& perf_value(vx_perf_core_t& core, const perf_counter_t& counter) {
+  return *(uint64_t*)((uint8_t*)&core + counter.offset);
+}
+
+static uint64_t perf_value(const vx_perf_core_t& core, const perf_counter_t& counter) {
+  return *(const uint64_t*)((const uint8_t*)&core + counter.offset);
+}
+
+// aggregate the per-core counters
+static void perf_update_total(vx_perf_counters_t* counters) {
+  memset(&counters->total, 0, sizeof(vx_perf_core_t));
+  for (unsigned core_id = 0; core_id < counters->num_cores; ++core_id) {
+    auto& core = counters->cores[core_id];
+    for (auto& counter : perf_counters) {
+      auto& total = perf_value(counters->total, counter);
+      auto value = perf_value(core, counter);
+      if (counter.offset == offsetof(vx_perf_core_t, cycles)) {
+        total = std::max<uint64_t>(total, value);
+      } else {
+        total += value;
+      }
+    }
+  }
+}
+
+extern int vx_perf_query(vx_device_h device, vx_perf_counters_t* counters) {
   int ret = 0;
 
-  uint64_t instrs = 0;
-  uint64_t cycles = 0;
-
-#ifdef PERF_ENABLE    
-  // PERF: pipeline stalls
-  uint64_t ibuffer_stalls = 0;
-  uint64_t scoreboard_stalls = 0;
-  uint64_t lsu_stalls = 0;
-  uint64_t fpu_stalls = 0;
-  uint64_t csr_stalls = 0;
-  uint64_t alu_stalls = 0;
-  uint64_t gpu_stalls = 0;
-  // PERF: Icache 
-  uint64_t icache_reads = 0;
-  uint64_t icache_read_misses = 0;
-  uint64_t icache_pipe_stalls = 0;
-  uint64_t icache_rsp_stalls = 0;
-  // PERF: Dcache 
-  uint64_t dcache_reads = 0;
-  uint64_t dcache_writes = 0;
-  uint64_t dcache_read_misses = 0;
-  uint64_t dcache_write_misses = 0;
-  uint64_t dcache_bank_stalls = 0;  
-  uint64_t dcache_mshr_stalls = 0;
-  uint64_t dcache_pipe_stalls = 0;
-  uint64_t dcache_rsp_stalls = 0;  
-  // PERF: SMEM
-  uint64_t smem_reads = 0;
-  uint64_t smem_writes = 0;
-  uint64_t smem_bank_stalls = 0;
-  // PERF: memory
-  uint64_t mem_reads = 0;
-  uint64_t mem_writes = 0;
-  uint64_t mem_stalls = 0;
-  uint64_t mem_lat = 0;
-#endif     
+  if (nullptr == counters)
+    return -1;
 
   unsigned num_cores;
   ret = vx_dev_caps(device, VX_CAPS_MAX_CORES, &num_cores);
@@ -138,180 +347,234 @@ extern int vx_dump_perf(vx_device_h device, FILE* stream) {
     return ret;
 
   auto staging_ptr = (uint32_t*)vx_host_ptr(staging_buf);
+
+  memset(counters, 0, sizeof(vx_perf_counters_t));
+  counters->num_cores = num_cores;
+  counters->cores = (vx_perf_core_t*)calloc(num_cores, sizeof(vx_perf_core_t));
+  if (nullptr == counters->cores) {
+    vx_buf_release(staging_buf);
+    return -1;
+  }
       
   for (unsigned core_id = 0; core_id < num_cores; ++core_id) {
     ret = vx_copy_from_dev(staging_buf, IO_CSR_ADDR + 64 * sizeof(uint32_t) * core_id, 64 * sizeof(uint32_t), 0);
     if (ret != 0) {
+      vx_perf_release(counters);
       vx_buf_release(staging_buf);
       return ret;
     }
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      auto& counter = perf_counters[i];
+      perf_value(counters->cores[core_id], counter) = get_csr_64(staging_ptr, counter.csr);
+    }
+  }
 
-    uint64_t instrs_per_core = get_csr_64(staging_ptr, CSR_MINSTRET);
-    uint64_t cycles_per_core = get_csr_64(staging_ptr, CSR_MCYCLE);
-    float IPC = (float)(double(instrs_per_core) / double(cycles_per_core));
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: instrs=%ld, cycles=%ld, IPC=%f\n", core_id, instrs_per_core, cycles_per_core, IPC);            
-    instrs += instrs_per_core;
-    cycles = std::max<uint64_t>(cycles_per_core, cycles);
-
-  #ifdef PERF_ENABLE
-    // PERF: pipeline    
-    // ibuffer_stall
-    uint64_t ibuffer_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_IBUF_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: ibuffer stalls=%ld\n", core_id, ibuffer_stalls_per_core);
-    ibuffer_stalls += ibuffer_stalls_per_core;
-    // scoreboard_stall
-    uint64_t scoreboard_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_SCRB_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: scoreboard stalls=%ld\n", core_id, scoreboard_stalls_per_core);
-    scoreboard_stalls += scoreboard_stalls_per_core;
-    // alu_stall
-    uint64_t alu_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_ALU_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: alu unit stalls=%ld\n", core_id, alu_stalls_per_core);
-    alu_stalls += alu_stalls_per_core;      
-    // lsu_stall
-    uint64_t lsu_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_LSU_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: lsu unit stalls=%ld\n", core_id, lsu_stalls_per_core);
-    lsu_stalls += lsu_stalls_per_core;
-    // csr_stall
-    uint64_t csr_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_CSR_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: csr unit stalls=%ld\n", core_id, csr_stalls_per_core);
-    csr_stalls += csr_stalls_per_core;    
-    // fpu_stall
-    uint64_t fpu_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_FPU_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: fpu unit stalls=%ld\n", core_id, fpu_stalls_per_core);
-    fpu_stalls += fpu_stalls_per_core;      
-    // gpu_stall
-    uint64_t gpu_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_GPU_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: gpu unit stalls=%ld\n", core_id, gpu_stalls_per_core);
-    gpu_stalls += gpu_stalls_per_core;  
-
-    // PERF: Icache
-    // total reads
-    uint64_t icache_reads_per_core = get_csr_64(staging_ptr, CSR_MPM_ICACHE_READS);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: icache reads=%ld\n", core_id, icache_reads_per_core);
-    icache_reads += icache_reads_per_core;
-    // read misses
-    uint64_t icache_miss_r_per_core = get_csr_64(staging_ptr, CSR_MPM_ICACHE_MISS_R);
-    int icache_read_hit_ratio = (int)((1.0 - (double(icache_miss_r_per_core) / double(icache_reads_per_core))) * 100);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: icache read misses=%ld (hit ratio=%d%%)\n", core_id, icache_miss_r_per_core, icache_read_hit_ratio);
-    icache_read_misses += icache_miss_r_per_core;
-    // pipeline stalls
-    uint64_t icache_pipe_st_per_core = get_csr_64(staging_ptr, CSR_MPM_ICACHE_PIPE_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: icache pipeline stalls=%ld\n", core_id, icache_pipe_st_per_core);
-    icache_pipe_stalls += icache_pipe_st_per_core;
-    // response stalls
-    uint64_t icache_crsp_st_per_core = get_csr_64(staging_ptr, CSR_MPM_ICACHE_CRSP_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: icache reponse stalls=%ld\n", core_id, icache_crsp_st_per_core);
-    icache_rsp_stalls += icache_crsp_st_per_core;
-
-    // PERF: Dcache
-    // total reads
-    uint64_t dcache_reads_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_READS);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache reads=%ld\n", core_id, dcache_reads_per_core);
-    dcache_reads += dcache_reads_per_core;
-    // total write
-    uint64_t dcache_writes_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_WRITES);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache writes=%ld\n", core_id, dcache_writes_per_core);
-    dcache_writes += dcache_writes_per_core;
-    // read misses
-    uint64_t dcache_miss_r_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_MISS_R);
-    int dcache_read_hit_ratio = (int)((1.0 - (double(dcache_miss_r_per_core) / double(dcache_reads_per_core))) * 100);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache read misses=%ld (hit ratio=%d%%)\n", core_id, dcache_miss_r_per_core, dcache_read_hit_ratio);
-    dcache_read_misses += dcache_miss_r_per_core;
-    // read misses
-    uint64_t dcache_miss_w_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_MISS_W);
-    int dcache_write_hit_ratio = (int)((1.0 - (double(dcache_miss_w_per_core) / double(dcache_writes_per_core))) * 100);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache write misses=%ld (hit ratio=%d%%)\n", core_id, dcache_miss_w_per_core, dcache_write_hit_ratio);
-    dcache_write_misses += dcache_miss_w_per_core;
-    // bank_stalls
-    uint64_t dcache_bank_st_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_BANK_ST);
-    int dcache_bank_utilization = (int)((double(dcache_reads_per_core + dcache_writes_per_core) / double(dcache_reads_per_core + dcache_writes_per_core + dcache_bank_st_per_core)) * 100);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache bank stalls=%ld (utilization=%d%%)\n", core_id, dcache_bank_st_per_core, dcache_bank_utilization);
-    dcache_bank_stalls += dcache_bank_st_per_core;
-    // mshr_stalls
-    uint64_t dcache_mshr_st_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_MSHR_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache mshr stalls=%ld\n", core_id, dcache_mshr_st_per_core);
-    dcache_mshr_stalls += dcache_mshr_st_per_core; 
-     // pipeline stalls
-    uint64_t dcache_pipe_st_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_PIPE_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache pipeline stalls=%ld\n", core_id, dcache_pipe_st_per_core);
-    dcache_pipe_stalls += dcache_pipe_st_per_core;
-   // response stalls
-    uint64_t dcache_crsp_st_per_core = get_csr_64(staging_ptr, CSR_MPM_DCACHE_CRSP_ST);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: dcache reponse stalls=%ld\n", core_id, dcache_crsp_st_per_core);
-    dcache_rsp_stalls += dcache_crsp_st_per_core;
-
-    // PERF: SMEM
-    // total reads
-    uint64_t smem_reads_per_core = get_csr_64(staging_ptr, CSR_MPM_SMEM_READS);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: smem reads=%ld\n", core_id, smem_reads_per_core);
-    smem_reads += smem_reads_per_core;
-    // total write
-    uint64_t smem_writes_per_core = get_csr_64(staging_ptr, CSR_MPM_SMEM_WRITES);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: smem writes=%ld\n", core_id, smem_writes_per_core);
-    smem_writes += smem_writes_per_core;
-    // bank_stalls
-    uint64_t smem_bank_st_per_core = get_csr_64(staging_ptr, CSR_MPM_SMEM_BANK_ST);
-    int smem_bank_utilization = (int)((double(smem_reads_per_core + smem_writes_per_core) / double(smem_reads_per_core + smem_writes_per_core + smem_bank_st_per_core)) * 100);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: smem bank stalls=%ld (utilization=%d%%)\n", core_id, smem_bank_st_per_core, smem_bank_utilization);
-    smem_bank_stalls += smem_bank_st_per_core;
-
-    // PERF: memory
-    uint64_t mem_reads_per_core  = get_csr_64(staging_ptr, CSR_MPM_MEM_READS);
-    uint64_t mem_writes_per_core = get_csr_64(staging_ptr, CSR_MPM_MEM_WRITES);
-    uint64_t mem_stalls_per_core = get_csr_64(staging_ptr, CSR_MPM_MEM_ST);
-    uint64_t mem_lat_per_core    = get_csr_64(staging_ptr, CSR_MPM_MEM_LAT);      
-    int mem_utilization = (int)((double(mem_reads_per_core + mem_writes_per_core) / double(mem_reads_per_core + mem_writes_per_core + mem_stalls_per_core)) * 100);
-    int mem_avg_lat = (int)(double(mem_lat_per_core) / double(mem_reads_per_core));       
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: memory requests=%ld (reads=%ld, writes=%ld)\n", core_id, (mem_reads_per_core + mem_writes_per_core), mem_reads_per_core, mem_writes_per_core);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: memory stalls=%ld (utilization=%d%%)\n", core_id, mem_stalls_per_core, mem_utilization);
-    if (num_cores > 1) fprintf(stream, "PERF: core%d: memory average latency=%d cycles\n", core_id, mem_avg_lat);
-    mem_reads  += mem_reads_per_core;
-    mem_writes += mem_writes_per_core;
-    mem_stalls += mem_stalls_per_core;
-    mem_lat    += mem_lat_per_core;    
-  #endif
-  }  
-  
-  float IPC = (float)(double(instrs) / double(cycles));
-  fprintf(stream, "PERF: instrs=%ld, cycles=%ld, IPC=%f\n", instrs, cycles, IPC);    
-      
-#ifdef PERF_ENABLE
-  int icache_read_hit_ratio = (int)((1.0 - (double(icache_read_misses) / double(icache_reads))) * 100);
-  int dcache_read_hit_ratio = (int)((1.0 - (double(dcache_read_misses) / double(dcache_reads))) * 100);
-  int dcache_write_hit_ratio = (int)((1.0 - (double(dcache_write_misses) / double(dcache_writes))) * 100);
-  int dcache_bank_utilization = (int)((double(dcache_reads + dcache_writes) / double(dcache_reads + dcache_writes + dcache_bank_stalls)) * 100);
-  int smem_bank_utilization = (int)((double(smem_reads + smem_writes) / double(smem_reads + smem_writes + smem_bank_stalls)) * 100);
-  int mem_utilization = (int)((double(mem_reads + mem_writes) / double(mem_reads + mem_writes + mem_stalls)) * 100);
-  int mem_avg_lat = (int)(double(mem_lat) / double(mem_reads));
-  fprintf(stream, "PERF: ibuffer stalls=%ld\n", ibuffer_stalls);
-  fprintf(stream, "PERF: scoreboard stalls=%ld\n", scoreboard_stalls);
-  fprintf(stream, "PERF: alu unit stalls=%ld\n", alu_stalls);
-  fprintf(stream, "PERF: lsu unit stalls=%ld\n", lsu_stalls);
-  fprintf(stream, "PERF: csr unit stalls=%ld\n", csr_stalls);
-  fprintf(stream, "PERF: fpu unit stalls=%ld\n", fpu_stalls);
-  fprintf(stream, "PERF: gpu unit stalls=%ld\n", gpu_stalls);
-  fprintf(stream, "PERF: icache reads=%ld\n", icache_reads);
-  fprintf(stream, "PERF: icache read misses=%ld (hit ratio=%d%%)\n", icache_read_misses, icache_read_hit_ratio);
-  fprintf(stream, "PERF: icache pipeline stalls=%ld\n", icache_pipe_stalls);  
-  fprintf(stream, "PERF: icache reponse stalls=%ld\n", icache_rsp_stalls);
-  fprintf(stream, "PERF: dcache reads=%ld\n", dcache_reads);
-  fprintf(stream, "PERF: dcache writes=%ld\n", dcache_writes);
-  fprintf(stream, "PERF: dcache read misses=%ld (hit ratio=%d%%)\n", dcache_read_misses, dcache_read_hit_ratio);
-  fprintf(stream, "PERF: dcache write misses=%ld (hit ratio=%d%%)\n", dcache_write_misses, dcache_write_hit_ratio);  
-  fprintf(stream, "PERF: dcache bank stalls=%ld (utilization=%d%%)\n", dcache_bank_stalls, dcache_bank_utilization);
-  fprintf(stream, "PERF: dcache mshr stalls=%ld\n", dcache_mshr_stalls);
-  fprintf(stream, "PERF: dcache pipeline stalls=%ld\n", dcache_pipe_stalls);
-  fprintf(stream, "PERF: dcache reponse stalls=%ld\n", dcache_rsp_stalls);
-  fprintf(stream, "PERF: smem reads=%ld\n", smem_reads);
-  fprintf(stream, "PERF: smem writes=%ld\n", smem_writes); 
-  fprintf(stream, "PERF: smem bank stalls=%ld (utilization=%d%%)\n", smem_bank_stalls, smem_bank_utilization);
-  fprintf(stream, "PERF: memory requests=%ld (reads=%ld, writes=%ld)\n", (mem_reads + mem_writes), mem_reads, mem_writes);
-  fprintf(stream, "PERF: memory stalls=%ld (utilization=%d%%)\n", mem_stalls, mem_utilization);
-  fprintf(stream, "PERF: memory average latency=%d cycles\n", mem_avg_lat);
-#endif
+  perf_update_total(counters);
 
   // release allocated resources
   vx_buf_release(staging_buf);
 
   return ret;
-}
\ No newline at end of file
+}
+
+extern int vx_perf_delta(const vx_perf_counters_t* begin, const vx_perf_counters_t* end, vx_perf_counters_t* delta) {
+  if (nullptr == begin 
+   || nullptr == end
+   || nullptr == delta
+   || begin->num_cores != end->num_cores)
+    return -1;
+
+  vx_perf_counters_t result;
+  memset(&result, 0, sizeof(vx_perf_counters_t));
+  result.num_cores = end->num_cores;
+  result.cores = (vx_perf_core_t*)calloc(end->num_cores, sizeof(vx_perf_core_t));
+  if (nullptr == result.cores)
+    return -1;
+
+  for (unsigned core_id = 0; core_id < end->num_cores; ++core_id) {
+    for (auto& counter : perf_counters) {
+      auto value_begin = perf_value(begin->cores[core_id], counter);
+      auto value_end = perf_value(end->cores[core_id], counter);
+      // counters restarted by a device reset only hold the new run
+      perf_value(result.cores[core_id], counter) = (value_end >= value_begin) ? (value_end - value_begin) : value_end;
+    }
+  }
+
+  perf_update_total(&result);
+
+  // replace the counters of an input reused as output
+  if (delta == begin || delta == end) {
+    free(delta->cores);
+  }
+  *delta = result;
+
+  return 0;
+}
+
+extern int vx_perf_release(vx_perf_counters_t* counters) {
+  if (nullptr == counters)
+    return -1;
+
+  free(counters->cores);
+  counters->cores = nullptr;
+  counters->num_cores = 0;
+
+  return 0;
+}
+
+typedef struct {
+  const char* name;
+  double value;
+  bool valid;
+} perf_metric_t;
+
+static void perf_metrics(const vx_perf_core_t& core, std::vector<perf_metric_t>& metrics) {
+  auto ratio = [&](const char* name, double num, double den) {
+    metrics.push_back({name, (den != 0) ? (num / den) : 0.0, (den != 0)});
+  };
+  metrics.clear();
+  ratio("ipc", core.instrs, core.cycles);
+#ifdef PERF_ENABLE
+  ratio("icache_read_hit_ratio", core.icache_reads - core.icache_read_misses, core.icache_reads);
+  ratio("dcache_read_hit_ratio", core.dcache_reads - core.dcache_read_misses, core.dcache_reads);
+  ratio("dcache_write_hit_ratio", core.dcache_writes - core.dcache_write_misses, core.dcache_writes);
+  ratio("dcache_bank_utilization", core.dcache_reads + core.dcache_writes, core.dcache_reads + core.dcache_writes + core.dcache_bank_stalls);
+  ratio("smem_bank_utilization", core.smem_reads + core.smem_writes, core.smem_reads + core.smem_writes + core.smem_bank_stalls);
+  ratio("mem_utilization", core.mem_reads + core.mem_writes, core.mem_reads + core.mem_writes + core.mem_stalls);
+  ratio("mem_avg_latency", core.mem_latency, core.mem_reads);
+#endif
+}
+
+static void perf_emit_json(const vx_perf_core_t& core, FILE* stream) {
+  std::vector<perf_metric_t> metrics;
+  perf_metrics(core, metrics);
+  fprintf(stream, "{");
+  for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+    auto& counter = perf_counters[i];
+    fprintf(stream, "%s\"%s\": %lu", (i ? ", " : ""), counter.name, (unsigned long)perf_value(core, counter));
+  }
+  for (auto& metric : metrics) {
+    if (metric.valid) {
+      fprintf(stream, ", \"%s\": %g", metric.name, metric.value);
+    } else {
+      fprintf(stream, ", \"%s\": null", metric.name);
+    }
+  }
+  fprintf(stream, "}");
+}
+
+static void perf_emit_csv(const char* label, const vx_perf_core_t& core, FILE* stream) {
+  std::vector<perf_metric_t> metrics;
+  perf_metrics(core, metrics);
+  fprintf(stream, "%s", label);
+  for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+    fprintf(stream, ",%lu", (unsigned long)perf_value(core, perf_counters[i]));
+  }
+  for (auto& metric : metrics) {
+    if (metric.valid) {
+      fprintf(stream, ",%g", metric.value);
+    } else {
+      fprintf(stream, ",");
+    }
+  }
+  fprintf(stream, "\n");
+}
+
+extern int vx_perf_emit(const vx_perf_counters_t* counters, int format, FILE* stream) {
+  if (nullptr == counters
+   || nullptr == stream)
+    return -1;
+
+  switch (format) {
+  case VX_PERF_FORMAT_JSON:
+    fprintf(stream, "{\"num_cores\": %u, \"total\": ", counters->num_cores);
+    perf_emit_json(counters->total, stream);
+    fprintf(stream, ", \"cores\": [");
+    for (unsigned core_id = 0; core_id < counters->num_cores; ++core_id) {
+      if (core_id) fprintf(stream, ", ");
+      perf_emit_json(counters->cores[core_id], stream);
+    }
+    fprintf(stream, "]}\n");
+    break;
+  case VX_PERF_FORMAT_CSV: {
+    std::vector<perf_metric_t> metrics;
+    perf_metrics(counters->total, metrics);
+    fprintf(stream, "core");
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      fprintf(stream, ",%s", perf_counters[i].name);
+    }
+    for (auto& metric : metrics) {
+      fprintf(stream, ",%s", metric.name);
+    }
+    fprintf(stream, "\n");
+    for (unsigned core_id = 0; core_id < counters->num_cores; ++core_id) {
+      auto label = std::to_string(core_id);
+      perf_emit_csv(label.c_str(), counters->cores[core_id], stream);
+    }
+    perf_emit_csv("total", counters->total, stream);
+  } break;
+  default:
+    return -1;
+  }
+
+  return 0;
+}
+
+static void dump_perf_core(FILE* stream, const char* prefix, const vx_perf_core_t& core) {
+  float IPC = (float)(double(core.instrs) / double(core.cycles));
+  fprintf(stream, "PERF: %sinstrs=%ld, cycles=%ld, IPC=%f\n", prefix, core.instrs, core.cycles, IPC);
+#ifdef PERF_ENABLE
+  int icache_read_hit_ratio = (int)((1.0 - (double(core.icache_read_misses) / double(core.icache_reads))) * 100);
+  int dcache_read_hit_ratio = (int)((1.0 - (double(core.dcache_read_misses) / double(core.dcache_reads))) * 100);
+  int dcache_write_hit_ratio = (int)((1.0 - (double(core.dcache_write_misses) / double(core.dcache_writes))) * 100);
+  int dcache_bank_utilization = (int)((double(core.dcache_reads + core.dcache_writes) / double(core.dcache_reads + core.dcache_writes + core.dcache_bank_stalls)) * 100);
+  int smem_bank_utilization = (int)((double(core.smem_reads + core.smem_writes) / double(core.smem_reads + core.smem_writes + core.smem_bank_stalls)) * 100);
+  int mem_utilization = (int)((double(core.mem_reads + core.mem_writes) / double(core.mem_reads + core.mem_writes + core.mem_stalls)) * 100);
+  int mem_avg_lat = (int)(double(core.mem_latency) / double(core.mem_reads));
+  fprintf(stream, "PERF: %sibuffer stalls=%ld\n", prefix, core.ibuffer_stalls);
+  fprintf(stream, "PERF: %sscoreboard stalls=%ld\n", prefix, core.scoreboard_stalls);
+  fprintf(stream, "PERF: %salu unit stalls=%ld\n", prefix, core.alu_stalls);
+  fprintf(stream, "PERF: %slsu unit stalls=%ld\n", prefix, core.lsu_stalls);
+  fprintf(stream, "PERF: %scsr unit stalls=%ld\n", prefix, core.csr_stalls);
+  fprintf(stream, "PERF: %sfpu unit stalls=%ld\n", prefix, core.fpu_stalls);
+  fprintf(stream, "PERF: %sgpu unit stalls=%ld\n", prefix, core.gpu_stalls);
+  fprintf(stream, "PERF: %sicache reads=%ld\n", prefix, core.icache_reads);
+  fprintf(stream, "PERF: %sicache read misses=%ld (hit ratio=%d%%)\n", prefix, core.icache_read_misses, icache_read_hit_ratio);
+  fprintf(stream, "PERF: %sicache pipeline stalls=%ld\n", prefix, core.icache_pipe_stalls);  
+  fprintf(stream, "PERF: %sicache reponse stalls=%ld\n", prefix, core.icache_rsp_stalls);
+  fprintf(stream, "PERF: %sdcache reads=%ld\n", prefix, core.dcache_reads);
+  fprintf(stream, "PERF: %sdcache writes=%ld\n", prefix, core.dcache_writes);
+  fprintf(stream, "PERF: %sdcache read misses=%ld (hit ratio=%d%%)\n", prefix, core.dcache_read_misses, dcache_read_hit_ratio);
+  fprintf(stream, "PERF: %sdcache write misses=%ld (hit ratio=%d%%)\n", prefix, core.dcache_write_misses, dcache_write_hit_ratio);  
+  fprintf(stream, "PERF: %sdcache bank stalls=%ld (utilization=%d%%)\n", prefix, core.dcache_bank_stalls, dcache_bank_utilization);
+  fprintf(stream, "PERF: %sdcache mshr stalls=%ld\n", prefix, core.dcache_mshr_stalls);
+  fprintf(stream, "PERF: %sdcache pipeline stalls=%ld\n", prefix, core.dcache_pipe_stalls);
+  fprintf(stream, "PERF: %sdcache reponse stalls=%ld\n", prefix, core.dcache_rsp_stalls);
+  fprintf(stream, "PERF: %ssmem reads=%ld\n", prefix, core.smem_reads);
+  fprintf(stream, "PERF: %ssmem writes=%ld\n", prefix, core.smem_writes); 
+  fprintf(stream, "PERF: %ssmem bank stalls=%ld (utilization=%d%%)\n", prefix, core.smem_bank_stalls, smem_bank_utilization);
+  fprintf(stream, "PERF: %smemory requests=%ld (reads=%ld, writes=%ld)\n", prefix, (core.mem_reads + core.mem_writes), core.mem_reads, core.mem_writes);
+  fprintf(stream, "PERF: %smemory stalls=%ld (utilization=%d%%)\n", prefix, core.mem_stalls, mem_utilization);
+  fprintf(stream, "PERF: %smemory average latency=%d cycles\n", prefix, mem_avg_lat);
+#endif
+}
+
+extern int vx_dump_perf(vx_device_h device, FILE* stream) {
+  vx_perf_counters_t counters;
+  int ret = vx_perf_query(device, &counters);
+  if (ret != 0)
+    return ret;
+
+  if (counters.num_cores > 1) {
+    for (unsigned core_id = 0; core_id < counters.num_cores; ++core_id) {
+      char prefix[16];
+      snprintf(prefix, sizeof(prefix), "core%d: ", core_id);
+      dump_perf_core(stream, prefix, counters.cores[core_id]);
+    }
+  }
+  dump_perf_core(stream, "", counters.total);
+
+  vx_perf_release(&counters);
+
+  return 0;
+}
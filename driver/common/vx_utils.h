@@ -0,0 +1,6 @@
+#pragma once
+
+#include <vortex.h>
+
+// validate scatter-gather copy regions against the host buffer and device memory
+int vx_check_copy_descs(const vx_copy_desc_t* descs, unsigned count, size_t buffer_size);
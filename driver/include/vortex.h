@@ -2,6 +2,7 @@
 #define __VX_DRIVER_H__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -12,6 +13,8 @@ typedef void* vx_device_h;
 
 typedef void* vx_buffer_h;
 
+typedef void* vx_event_h;
+
 // device caps ids
 #define VX_CAPS_VERSION           0x0 
 #define VX_CAPS_MAX_CORES         0x1
@@ -22,6 +25,10 @@ typedef void* vx_buffer_h;
 #define VX_CAPS_ALLOC_BASE_ADDR   0x6
 #define VX_CAPS_KERNEL_BASE_ADDR  0x7
 
+// event status
+#define VX_EVENT_COMPLETE         0x0
+#define VX_EVENT_PENDING          0x1
+
 #define CACHE_BLOCK_SIZE 64
 #define ALLOC_BASE_ADDR  0x00000000
 #define LOCAL_MEM_SIZE   0xffffffff
@@ -38,6 +45,11 @@ int vx_dev_caps(vx_device_h hdevice, unsigned caps_id, unsigned *value);
 // Allocate shared buffer with device
 int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer);
 
+// Map device local memory into a host-visible buffer (zero-copy)
+// Copies between the buffer and its own device range become no-ops.
+// Only supported by simulated devices.
+int vx_map_dev_mem(vx_device_h hdevice, size_t dev_maddr, size_t size, vx_buffer_h* hbuffer);
+
 // Get host pointer address  
 void* vx_host_ptr(vx_buffer_h hbuffer);
 
@@ -47,21 +59,148 @@ int vx_buf_release(vx_buffer_h hbuffer);
 // allocate device memory and return address
 int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr);
 
+// release device memory
+int vx_mem_free(vx_device_h hdevice, size_t dev_maddr);
+
+// get device memory usage
+int vx_mem_info(vx_device_h hdevice, size_t* mem_free, size_t* mem_used);
+
 // Copy bytes from buffer to device local memory
 int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset);
 
 // Copy bytes from device local memory to buffer
 int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dst_offset);
 
+// copy region descriptor
+typedef struct {
+  size_t dev_maddr;   // device local memory address
+  size_t offset;      // buffer offset
+  size_t size;        // size in bytes
+} vx_copy_desc_t;
+
+// Copy a list of regions from buffer to device local memory
+int vx_copy_to_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count);
+
+// Copy a list of regions from device local memory to buffer
+int vx_copy_from_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count);
+
+// Copy a 2D region (height rows of width bytes) from buffer to device local memory, pitches are in bytes
+int vx_copy_to_dev_2d(vx_buffer_h hbuffer, size_t dev_maddr, size_t dev_pitch, size_t src_offset, size_t src_pitch, size_t width, size_t height);
+
+// Copy a 2D region (height rows of width bytes) from device local memory to buffer, pitches are in bytes
+int vx_copy_from_dev_2d(vx_buffer_h hbuffer, size_t dev_maddr, size_t dev_pitch, size_t dst_offset, size_t dst_pitch, size_t width, size_t height);
+
 // Start device execution
 int vx_start(vx_device_h hdevice);
 
 // Wait for device ready with milliseconds timeout
+// returns VX_EVENT_PENDING if enqueued commands are still pending or the device is still busy at timeout
 int vx_ready_wait(vx_device_h hdevice, long long timeout);
 
+////////////////////////////// ASYNC COMMANDS /////////////////////////////////
+
+// Commands are executed in order by a per-device submission queue.
+// Buffers must remain valid until the command's event has completed.
+// Synchronous calls wait for all enqueued commands to complete first.
+// An event handle is returned if hevent is not NULL.
+
+// Enqueue copy from buffer to device local memory
+int vx_enqueue_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent);
+
+// Enqueue copy from device local memory to buffer
+int vx_enqueue_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dst_offset, vx_event_h* hevent);
+
+// Enqueue device execution, the event completes when the device is ready
+int vx_enqueue_start(vx_device_h hdevice, vx_event_h* hevent);
+
+// Wait for event completion with milliseconds timeout
+// returns 0 on success, VX_EVENT_PENDING on timeout, -1 if the command failed
+int vx_event_wait(vx_event_h hevent, long long timeout);
+
+// Query event status (VX_EVENT_COMPLETE or VX_EVENT_PENDING)
+// returns -1 if the command failed
+int vx_event_poll(vx_event_h hevent, int* status);
+
+// release event
+int vx_event_release(vx_event_h hevent);
+
+////////////////////////////// PERF COUNTERS /////////////////////////////////
+
+// perf counters output formats
+#define VX_PERF_FORMAT_JSON       0x0
+#define VX_PERF_FORMAT_CSV        0x1
+
+// raw performance counters of a core
+// stall, cache, smem and memory counters are only available in PERF_ENABLE builds
+typedef struct {
+  uint64_t instrs;
+  uint64_t cycles;
+  // pipeline stalls
+  uint64_t ibuffer_stalls;
+  uint64_t scoreboard_stalls;
+  uint64_t alu_stalls;
+  uint64_t lsu_stalls;
+  uint64_t csr_stalls;
+  uint64_t fpu_stalls;
+  uint64_t gpu_stalls;
+  // icache
+  uint64_t icache_reads;
+  uint64_t icache_read_misses;
+  uint64_t icache_pipe_stalls;
+  uint64_t icache_rsp_stalls;
+  // dcache
+  uint64_t dcache_reads;
+  uint64_t dcache_writes;
+  uint64_t dcache_read_misses;
+  uint64_t dcache_write_misses;
+  uint64_t dcache_bank_stalls;
+  uint64_t dcache_mshr_stalls;
+  uint64_t dcache_pipe_stalls;
+  uint64_t dcache_rsp_stalls;
+  // shared memory
+  uint64_t smem_reads;
+  uint64_t smem_writes;
+  uint64_t smem_bank_stalls;
+  // memory
+  uint64_t mem_reads;
+  uint64_t mem_writes;
+  uint64_t mem_stalls;
+  uint64_t mem_latency;   // accumulated read latency in cycles
+} vx_perf_core_t;
+
+typedef struct {
+  unsigned num_cores;
+  vx_perf_core_t total;   // sum over all cores, cycles is the maximum
+  vx_perf_core_t* cores;  // num_cores entries
+} vx_perf_counters_t;
+
+// read the performance counters of all cores, release them with vx_perf_release
+int vx_perf_query(vx_device_h hdevice, vx_perf_counters_t* counters);
+
+// compute the counters accumulated between two queries (e.g. around a launch),
+// release the delta with vx_perf_release unless it is begin or end
+int vx_perf_delta(const vx_perf_counters_t* begin, const vx_perf_counters_t* end, vx_perf_counters_t* delta);
+
+// release the per-core counters
+int vx_perf_release(vx_perf_counters_t* counters);
+
+// write raw counters and derived metrics (IPC, hit ratios, average memory latency)
+int vx_perf_emit(const vx_perf_counters_t* counters, int format, FILE* stream);
+
 ////////////////////////////// UTILITY FUNCIONS ///////////////////////////////
 
-// upload kernel bytes to device
+// upload bytes to device local memory, unchanged resident blocks are skipped
+// until the next kernel start
+int vx_upload_bytes(vx_device_h device, size_t dev_maddr, const void* content, size_t size);
+
+// upload bytes that kernels never modify, unchanged resident blocks are skipped
+// across kernel starts
+int vx_upload_const_bytes(vx_device_h device, size_t dev_maddr, const void* content, size_t size);
+
+// forget the resident content of a device memory range
+int vx_resident_invalidate(vx_device_h device, size_t dev_maddr, size_t size);
+
+// upload kernel bytes to device, the writable image is uploaded again after a kernel start
 int vx_upload_kernel_bytes(vx_device_h device, const void* content, size_t size);
 
 // upload kernel file to device
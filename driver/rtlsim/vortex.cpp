@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <iostream>
+#include <vector>
+#include <list>
 #include <future>
 #include <chrono>
 
@@ -10,6 +12,10 @@
 #include <VX_config.h>
 #include <mem.h>
 #include <util.h>
+#include "../common/vx_malloc.h"
+#include "../common/vx_queue.h"
+#include "../common/vx_resident.h"
+#include "../common/vx_utils.h"
 #include <simulator.h>
 
 using namespace vortex;
@@ -21,17 +27,41 @@ class vx_buffer {
 public:
     vx_buffer(size_t size, vx_device* device) 
         : size_(size)
-        , device_(device) {
+        , device_(device)
+        , dev_maddr_(0)
+        , mapped_(false) {
         auto aligned_asize = align_size(size, CACHE_BLOCK_SIZE);
         data_ = malloc(aligned_asize);
     }
 
+    // buffer aliasing device local memory
+    vx_buffer(size_t size, vx_device* device, size_t dev_maddr, void* data) 
+        : size_(size)
+        , device_(device)
+        , data_(data)
+        , dev_maddr_(dev_maddr)
+        , mapped_(true) 
+    {}
+
     ~vx_buffer() {
-        if (data_) {
+        if (data_ && !mapped_) {
             free(data_);
         }
     }
 
+    bool is_mapped() const {
+        return mapped_;
+    }
+
+    size_t dev_maddr() const {
+        return dev_maddr_;
+    }
+
+    // check if a copy would be a no-op
+    bool aliases(size_t dev_maddr, size_t offset) const {
+        return mapped_ && (dev_maddr_ + offset) == dev_maddr;
+    }
+
     void* data() const {
         return data_;
     }
@@ -48,29 +78,67 @@ private:
     size_t size_;
     vx_device* device_;
     void* data_;
+    size_t dev_maddr_;
+    bool mapped_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class vx_device {    
 public:
-    vx_device() : ram_((1<<12), (1<<20)) {        
-        mem_allocation_ = ALLOC_BASE_ADDR;        
-    } 
+    vx_device() 
+        : mem_allocator_(ALLOC_BASE_ADDR, IO_BASE_ADDR - ALLOC_BASE_ADDR, CACHE_BLOCK_SIZE)
+        , ram_((1<<12), (1<<20)) {}
 
     ~vx_device() {    
+        // drain pending commands
+        queue_.finish(-1);
         if (future_.valid()) {
             future_.wait();
         }
     }
 
     int alloc_local_mem(size_t size, size_t* dev_maddr) {
-        auto dev_mem_size = LOCAL_MEM_SIZE;
-        size_t asize = align_size(size, CACHE_BLOCK_SIZE);        
-        if (mem_allocation_ + asize > dev_mem_size)
+        uint64_t addr;
+        if (mem_allocator_.allocate(size, &addr) != 0)
             return -1;
-        *dev_maddr = mem_allocation_;
-        mem_allocation_ += asize;
+        *dev_maddr = addr;
+        return 0;
+    }
+
+    int free_local_mem(size_t dev_maddr) {
+        return mem_allocator_.release(dev_maddr);
+    }
+
+    void* map_local_mem(size_t dev_maddr, size_t size) {
+        if (future_.valid() 
+         && future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return nullptr;
+        auto data = ram_.map(dev_maddr, size);
+        if (data) {
+            resident_cache_.map(dev_maddr, size);
+        }
+        return data;
+    }
+
+    void unmap_local_mem(size_t dev_maddr) {
+        ram_.unmap(dev_maddr);
+        resident_cache_.unmap(dev_maddr);
+    }
+
+    CommandQueue& queue() {
+        return queue_;
+    }
+
+    ResidentCache& resident_cache() {
+        return resident_cache_;
+    }
+
+    int mem_info(size_t* mem_free, size_t* mem_used) const {
+        if (mem_free)
+            *mem_free = mem_allocator_.free_size();
+        if (mem_used)
+            *mem_used = mem_allocator_.used_size();
         return 0;
     }
 
@@ -89,6 +157,7 @@ public:
         printf("\n");*/
         
         ram_.write((const uint8_t*)src + src_offset, dest_addr, asize);
+        resident_cache_.invalidate(dest_addr, asize);
         return 0;
     }
 
@@ -111,10 +180,27 @@ public:
         return 0;
     }
 
+    int copy_regions(void* data, const vx_copy_desc_t* descs, unsigned count, bool to_dev) {
+        for (unsigned i = 0; i < count; ++i) {
+            auto& desc = descs[i];
+            if (desc.dev_maddr + desc.size > ram_.size())
+                return -1;
+            if (to_dev) {
+                ram_.write((const uint8_t*)data + desc.offset, desc.dev_maddr, desc.size);
+                resident_cache_.invalidate(desc.dev_maddr, desc.size);
+            } else {
+                ram_.read((uint8_t*)data + desc.offset, desc.dev_maddr, desc.size);
+            }
+        }
+        return 0;
+    }
+
     int start() {   
         if (future_.valid()) {
             future_.wait(); // ensure prior run completed
         }
+        // the kernel may overwrite uploaded data
+        resident_cache_.invalidate_writable();
         simulator_.attach_ram(&ram_);
         future_ = std::async(std::launch::async, [&]{             
             simulator_.reset();        
@@ -128,23 +214,22 @@ public:
     int wait(long long timeout) {
         if (!future_.valid())
             return 0;
-        auto timeout_sec = (timeout < 0) ? timeout : (timeout / 1000);
-        std::chrono::seconds wait_time(1);
-        for (;;) {
-            auto status = future_.wait_for(wait_time); // wait for 1 sec and check status
-            if (status == std::future_status::ready 
-             || 0 == timeout_sec--)
-                break;
+        if (timeout < 0) {
+            future_.wait();
+        } else if (future_.wait_for(std::chrono::milliseconds(timeout)) != std::future_status::ready) {
+            return VX_EVENT_PENDING;
         }
         return 0;
     }
 
 private:
 
-    size_t mem_allocation_;     
+    MemoryAllocator mem_allocator_;     
     RAM ram_;
     Simulator simulator_;
     std::future<void> future_;
+    ResidentCache resident_cache_;
+    CommandQueue queue_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -254,6 +339,30 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
     return device->alloc_local_mem(size, dev_maddr);
 }
 
+extern int vx_mem_free(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->free_local_mem(dev_maddr);
+}
+
+extern int vx_mem_info(vx_device_h hdevice, size_t* mem_free, size_t* mem_used) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->mem_info(mem_free, mem_used);
+}
+
+ResidentCache* vx_resident_cache(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return nullptr;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return &device->resident_cache();
+}
+
 
 extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer) {
     if (nullptr == hdevice 
@@ -274,6 +383,25 @@ extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hb
     return 0;
 }
 
+extern int vx_map_dev_mem(vx_device_h hdevice, size_t dev_maddr, size_t size, vx_buffer_h* hbuffer) {
+    if (nullptr == hdevice 
+     || 0 >= size
+     || nullptr == hbuffer)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    device->queue().finish(-1);
+
+    auto asize = align_size(size, CACHE_BLOCK_SIZE);
+    auto data = device->map_local_mem(dev_maddr, asize);
+    if (nullptr == data)
+        return -1;
+
+    *hbuffer = new vx_buffer(size, device, dev_maddr, data);
+
+    return 0;
+}
+
 extern void* vx_host_ptr(vx_buffer_h hbuffer) {
     if (nullptr == hbuffer)
         return nullptr;
@@ -289,6 +417,10 @@ extern int vx_buf_release(vx_buffer_h hbuffer) {
 
     vx_buffer* buffer = ((vx_buffer*)hbuffer);
 
+    if (buffer->is_mapped()) {
+        buffer->device()->unmap_local_mem(buffer->dev_maddr());
+    }
+
     delete buffer;
 
     return 0;
@@ -304,7 +436,13 @@ extern int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, si
     if (size + src_offset > buffer->size())
         return -1;
 
-    return buffer->device()->upload(buffer->data(), dev_maddr, size, src_offset);
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    if (buffer->aliases(dev_maddr, src_offset))
+        return 0; // zero-copy
+
+    return device->upload(buffer->data(), dev_maddr, size, src_offset);
 }
 
 extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset) {
@@ -317,7 +455,47 @@ extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size,
     if (size + dest_offset > buffer->size())
         return -1;    
 
-    return buffer->device()->download(buffer->data(), dev_maddr, size, dest_offset);
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    if (buffer->aliases(dev_maddr, dest_offset))
+        return 0; // zero-copy
+
+    return device->download(buffer->data(), dev_maddr, size, dest_offset);
+}
+
+extern int vx_copy_to_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (vx_check_copy_descs(descs, count, buffer->size()) != 0)
+        return -1;
+
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    return device->copy_regions(buffer->data(), descs, count, true);
+}
+
+extern int vx_copy_from_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (vx_check_copy_descs(descs, count, buffer->size()) != 0)
+        return -1;
+
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    return device->copy_regions(buffer->data(), descs, count, false);
 }
 
 extern int vx_start(vx_device_h hdevice) {
@@ -325,6 +503,7 @@ extern int vx_start(vx_device_h hdevice) {
         return -1;
 
     vx_device *device = ((vx_device*)hdevice);
+    device->queue().finish(-1);
 
     return device->start();
 }
@@ -334,6 +513,67 @@ extern int vx_ready_wait(vx_device_h hdevice, long long timeout) {
         return -1;
 
     vx_device *device = ((vx_device*)hdevice);
+    auto start = std::chrono::steady_clock::now();
+    if (!device->queue().finish(timeout))
+        return VX_EVENT_PENDING;
+
+    return device->wait(remaining_timeout(timeout, start));
+}
 
-    return device->wait(timeout);
+extern int vx_enqueue_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (size + src_offset > buffer->size())
+        return -1;
+
+    auto device = buffer->device();
+    auto event = device->queue().enqueue([=]{ 
+        if (buffer->aliases(dev_maddr, src_offset))
+            return 0; // zero-copy
+        return device->upload(buffer->data(), dev_maddr, size, src_offset); 
+    });
+    make_event_handle(event, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (size + dest_offset > buffer->size())
+        return -1;
+
+    auto device = buffer->device();
+    auto event = device->queue().enqueue([=]{ 
+        if (buffer->aliases(dev_maddr, dest_offset))
+            return 0; // zero-copy
+        return device->download(buffer->data(), dev_maddr, size, dest_offset); 
+    });
+    make_event_handle(event, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_start(vx_device_h hdevice, vx_event_h* hevent) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    auto event = device->queue().enqueue([=]{ 
+        int ret = device->start();
+        if (ret != 0)
+            return ret;
+        return device->wait(-1); 
+    });
+    make_event_handle(event, hevent);
+
+    return 0;
 }
\ No newline at end of file
@@ -3,14 +3,20 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <iostream>
+#include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 
 #include <vortex.h>
 #include <core.h>
 #include <VX_config.h>
 #include <util.h>
+#include "../common/vx_malloc.h"
+#include "../common/vx_queue.h"
+#include "../common/vx_resident.h"
+#include "../common/vx_utils.h"
 
 #define PAGE_SIZE   4096
 
@@ -24,17 +30,41 @@ class vx_buffer {
 public:
     vx_buffer(size_t size, vx_device* device) 
         : size_(size)
-        , device_(device) {
+        , device_(device)
+        , dev_maddr_(0)
+        , mapped_(false) {
         auto aligned_asize = align_size(size, CACHE_BLOCK_SIZE);
         data_ = malloc(aligned_asize);
     }
 
+    // buffer aliasing device local memory
+    vx_buffer(size_t size, vx_device* device, size_t dev_maddr, void* data) 
+        : size_(size)
+        , device_(device)
+        , data_(data)
+        , dev_maddr_(dev_maddr)
+        , mapped_(true) 
+    {}
+
     ~vx_buffer() {
-        if (data_) {
+        if (data_ && !mapped_) {
             free(data_);
         }
     }
 
+    bool is_mapped() const {
+        return mapped_;
+    }
+
+    size_t dev_maddr() const {
+        return dev_maddr_;
+    }
+
+    // check if a copy would be a no-op
+    bool aliases(size_t dev_maddr, size_t offset) const {
+        return mapped_ && (dev_maddr_ + offset) == dev_maddr;
+    }
+
     void* data() const {
         return data_;
     }
@@ -51,6 +81,8 @@ private:
     size_t size_;
     vx_device* device_;
     void* data_;
+    size_t dev_maddr_;
+    bool mapped_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -64,31 +96,80 @@ public:
         , cores_(arch_.num_cores())
         , is_done_(false)
         , is_running_(false)
-        , thread_(__thread_proc__, this)
-        , ram_((1<<12), (1<<20))  {
+        , mem_allocator_(ALLOC_BASE_ADDR, IO_BASE_ADDR - ALLOC_BASE_ADDR, CACHE_BLOCK_SIZE)
+        , ram_((1<<12), (1<<20))
+        , thread_(__thread_proc__, this) {
 
-        mem_allocation_ = ALLOC_BASE_ADDR;               
         mmu_.attach(ram_, 0, 0xffffffff);  
+        // opt-in DRAM timing, simX has no caches to filter the traffic
+        if (getenv("VORTEX_DRAM_CONFIG")) {
+            DramConfig dram_config;
+            if (0 == dram_config.load_env()) {
+                dram_ = std::make_shared<DramSim>(dram_config);
+            }
+        }
+
         for (int i = 0; i < arch_.num_cores(); ++i) {
             cores_[i] = std::make_shared<Core>(arch_, decoder_, mmu_, i);
+            cores_[i]->attach_dram(dram_.get());
         }
     }
 
     ~vx_device() {
-        mutex_.lock();
-        is_done_ = true;
-        mutex_.unlock();
+        // drain pending commands
+        queue_.finish(-1);
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            is_done_ = true;
+        }
+        run_cv_.notify_one();
         
         thread_.join();
     }
 
     int alloc_local_mem(size_t size, size_t* dev_maddr) {
-        auto dev_mem_size = LOCAL_MEM_SIZE;
-        auto asize = align_size(size, CACHE_BLOCK_SIZE);        
-        if (mem_allocation_ + asize > dev_mem_size)
+        uint64_t addr;
+        if (mem_allocator_.allocate(size, &addr) != 0)
             return -1;
-        *dev_maddr = mem_allocation_;
-        mem_allocation_ += asize;
+        *dev_maddr = addr;
+        return 0;
+    }
+
+    int free_local_mem(size_t dev_maddr) {
+        return mem_allocator_.release(dev_maddr);
+    }
+
+    void* map_local_mem(size_t dev_maddr, size_t size) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (is_running_)
+            return nullptr;
+        auto data = ram_.map(dev_maddr, size);
+        if (data) {
+            resident_cache_.map(dev_maddr, size);
+        }
+        return data;
+    }
+
+    void unmap_local_mem(size_t dev_maddr) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        ram_.unmap(dev_maddr);
+        resident_cache_.unmap(dev_maddr);
+    }
+
+    CommandQueue& queue() {
+        return queue_;
+    }
+
+    ResidentCache& resident_cache() {
+        return resident_cache_;
+    }
+
+    int mem_info(size_t* mem_free, size_t* mem_used) const {
+        if (mem_free)
+            *mem_free = mem_allocator_.free_size();
+        if (mem_used)
+            *mem_used = mem_allocator_.used_size();
         return 0;
     }
 
@@ -98,6 +179,7 @@ public:
             return -1;
 
         ram_.write((const uint8_t*)src + src_offset, dest_addr, asize);
+        resident_cache_.invalidate(dest_addr, asize);
         
         /*printf("VXDRV: upload %d bytes to 0x%x\n", size, dest_addr);
         for (int i = 0; i < size; i += 4) {
@@ -122,29 +204,43 @@ public:
         return 0;
     }
 
-    int start() {  
+    int copy_regions(void* data, const vx_copy_desc_t* descs, unsigned count, bool to_dev) {
+        for (unsigned i = 0; i < count; ++i) {
+            auto& desc = descs[i];
+            if (desc.dev_maddr + desc.size > ram_.size())
+                return -1;
+            if (to_dev) {
+                ram_.write((const uint8_t*)data + desc.offset, desc.dev_maddr, desc.size);
+                resident_cache_.invalidate(desc.dev_maddr, desc.size);
+            } else {
+                ram_.read((uint8_t*)data + desc.offset, desc.dev_maddr, desc.size);
+            }
+        }
+        return 0;
+    }
 
-        mutex_.lock();     
-        for (int i = 0; i < arch_.num_cores(); ++i) {
-            cores_[i]->clear();
+    int start() {  
+        // the kernel may overwrite uploaded data
+        resident_cache_.invalidate_writable();
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (int i = 0; i < arch_.num_cores(); ++i) {
+                cores_[i]->clear();
+            }
+                is_running_ = true;
         }
-        is_running_ = true;        
-        mutex_.unlock();
+        run_cv_.notify_one();
 
         return 0;
     }
 
     int wait(long long timeout) {
-        auto timeout_sec = (timeout < 0) ? timeout : (timeout / 1000);
-        for (;;) {
-            mutex_.lock();
-            bool is_running = is_running_;
-            mutex_.unlock();
-
-            if (!is_running || 0 == timeout_sec--)
-                break;
-
-            std::this_thread::sleep_for(std::chrono::seconds(1));            
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto is_ready = [&]{ return !is_running_; };
+        if (timeout < 0) {
+            done_cv_.wait(lock, is_ready);
+        } else if (!done_cv_.wait_for(lock, std::chrono::milliseconds(timeout), is_ready)) {
+            return VX_EVENT_PENDING;
         }
         return 0;
     }
@@ -177,25 +273,25 @@ private:
         std::cout << "Device ready..." << std::flush << std::endl;
 
         for (;;) {
-            mutex_.lock();
-            bool is_done = is_done_;
-            bool is_running = is_running_;
-            mutex_.unlock();
-
-            if (is_done)
-                break;
+            {
+                // sleep until a new run is requested or the device is closed
+                std::unique_lock<std::mutex> lock(mutex_);
+                run_cv_.wait(lock, [&]{ return is_done_ || is_running_; });
+                if (is_done_)
+                    break;
+            }
 
-            if (is_running) {                                
-                std::cout << "Device running..." << std::flush << std::endl;
-                
-                this->run();
+            std::cout << "Device running..." << std::flush << std::endl;
+            
+            this->run();
 
-                mutex_.lock();
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
                 is_running_ = false;
-                mutex_.unlock();
-
-                std::cout << "Device ready..." << std::flush << std::endl;
             }
+            done_cv_.notify_all();
+
+            std::cout << "Device ready..." << std::flush << std::endl;
         }
 
         std::cout << "Device shutdown..." << std::flush << std::endl;
@@ -209,12 +305,17 @@ private:
     Decoder decoder_;
     MemoryUnit mmu_;
     std::vector<std::shared_ptr<Core>> cores_;
+    std::shared_ptr<DramSim> dram_;
     bool is_done_;
     bool is_running_;   
-    size_t mem_allocation_; 
-    std::thread thread_;   
+    MemoryAllocator mem_allocator_; 
     RAM ram_;
+    ResidentCache resident_cache_;
     std::mutex mutex_;
+    std::condition_variable run_cv_;
+    std::condition_variable done_cv_;
+    CommandQueue queue_;
+    std::thread thread_; // must be initialized last
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -324,6 +425,30 @@ extern int vx_alloc_dev_mem(vx_device_h hdevice, size_t size, size_t* dev_maddr)
     return device->alloc_local_mem(size, dev_maddr);
 }
 
+extern int vx_mem_free(vx_device_h hdevice, size_t dev_maddr) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->free_local_mem(dev_maddr);
+}
+
+extern int vx_mem_info(vx_device_h hdevice, size_t* mem_free, size_t* mem_used) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return device->mem_info(mem_free, mem_used);
+}
+
+ResidentCache* vx_resident_cache(vx_device_h hdevice) {
+    if (nullptr == hdevice)
+        return nullptr;
+
+    vx_device *device = ((vx_device*)hdevice);
+    return &device->resident_cache();
+}
+
 extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hbuffer) {
     if (nullptr == hdevice 
      || 0 >= size
@@ -343,6 +468,25 @@ extern int vx_alloc_shared_mem(vx_device_h hdevice, size_t size, vx_buffer_h* hb
     return 0;
 }
 
+extern int vx_map_dev_mem(vx_device_h hdevice, size_t dev_maddr, size_t size, vx_buffer_h* hbuffer) {
+    if (nullptr == hdevice 
+     || 0 >= size
+     || nullptr == hbuffer)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    device->queue().finish(-1);
+
+    auto asize = align_size(size, CACHE_BLOCK_SIZE);
+    auto data = device->map_local_mem(dev_maddr, asize);
+    if (nullptr == data)
+        return -1;
+
+    *hbuffer = new vx_buffer(size, device, dev_maddr, data);
+
+    return 0;
+}
+
 extern void* vx_host_ptr(vx_buffer_h hbuffer) {
     if (nullptr == hbuffer)
         return nullptr;
@@ -358,6 +502,10 @@ extern int vx_buf_release(vx_buffer_h hbuffer) {
 
     vx_buffer* buffer = ((vx_buffer*)hbuffer);
 
+    if (buffer->is_mapped()) {
+        buffer->device()->unmap_local_mem(buffer->dev_maddr());
+    }
+
     delete buffer;
 
     return 0;
@@ -373,7 +521,13 @@ extern int vx_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, si
     if (size + src_offset > buffer->size())
         return -1;
 
-    return buffer->device()->upload(buffer->data(), dev_maddr, size, src_offset);
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    if (buffer->aliases(dev_maddr, src_offset))
+        return 0; // zero-copy
+
+    return device->upload(buffer->data(), dev_maddr, size, src_offset);
 }
 
 extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset) {
@@ -386,7 +540,47 @@ extern int vx_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size,
     if (size + dest_offset > buffer->size())
         return -1;    
 
-    return buffer->device()->download(buffer->data(), dev_maddr, size, dest_offset);
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    if (buffer->aliases(dev_maddr, dest_offset))
+        return 0; // zero-copy
+
+    return device->download(buffer->data(), dev_maddr, size, dest_offset);
+}
+
+extern int vx_copy_to_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (vx_check_copy_descs(descs, count, buffer->size()) != 0)
+        return -1;
+
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    return device->copy_regions(buffer->data(), descs, count, true);
+}
+
+extern int vx_copy_from_dev_sg(vx_buffer_h hbuffer, const vx_copy_desc_t* descs, unsigned count) {
+    if (nullptr == hbuffer 
+     || nullptr == descs
+     || 0 == count)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (vx_check_copy_descs(descs, count, buffer->size()) != 0)
+        return -1;
+
+    auto device = buffer->device();
+    device->queue().finish(-1);
+
+    return device->copy_regions(buffer->data(), descs, count, false);
 }
 
 extern int vx_start(vx_device_h hdevice) {
@@ -394,6 +588,7 @@ extern int vx_start(vx_device_h hdevice) {
         return -1;
 
     vx_device *device = ((vx_device*)hdevice);
+    device->queue().finish(-1);
 
     return device->start();
 }
@@ -403,6 +598,67 @@ extern int vx_ready_wait(vx_device_h hdevice, long long timeout) {
         return -1;
 
     vx_device *device = ((vx_device*)hdevice);
+    auto start = std::chrono::steady_clock::now();
+    if (!device->queue().finish(timeout))
+        return VX_EVENT_PENDING;
+
+    return device->wait(remaining_timeout(timeout, start));
+}
+
+extern int vx_enqueue_copy_to_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t src_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (size + src_offset > buffer->size())
+        return -1;
+
+    auto device = buffer->device();
+    auto event = device->queue().enqueue([=]{ 
+        if (buffer->aliases(dev_maddr, src_offset))
+            return 0; // zero-copy
+        return device->upload(buffer->data(), dev_maddr, size, src_offset); 
+    });
+    make_event_handle(event, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_copy_from_dev(vx_buffer_h hbuffer, size_t dev_maddr, size_t size, size_t dest_offset, vx_event_h* hevent) {
+    if (nullptr == hbuffer 
+     || 0 >= size)
+        return -1;
+
+    auto buffer = (vx_buffer*)hbuffer;
+
+    if (size + dest_offset > buffer->size())
+        return -1;
+
+    auto device = buffer->device();
+    auto event = device->queue().enqueue([=]{ 
+        if (buffer->aliases(dev_maddr, dest_offset))
+            return 0; // zero-copy
+        return device->download(buffer->data(), dev_maddr, size, dest_offset); 
+    });
+    make_event_handle(event, hevent);
+
+    return 0;
+}
+
+extern int vx_enqueue_start(vx_device_h hdevice, vx_event_h* hevent) {
+    if (nullptr == hdevice)
+        return -1;
+
+    vx_device *device = ((vx_device*)hdevice);
+    auto event = device->queue().enqueue([=]{ 
+        int ret = device->start();
+        if (ret != 0)
+            return ret;
+        return device->wait(-1); 
+    });
+    make_event_handle(event, hevent);
 
-    return device->wait(timeout);
+    return 0;
 }
\ No newline at end of file
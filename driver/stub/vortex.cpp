@@ -1,4 +1,5 @@
 #include <vortex.h>
+#include "../common/vx_resident.h"
 
 extern int vx_dev_open(vx_device_h* /*hdevice*/) {
     return -1;
@@ -16,10 +17,26 @@ extern int vx_alloc_dev_mem(vx_device_h /*hdevice*/, size_t /*size*/, size_t* /*
     return -1;
 }
 
+extern int vx_mem_free(vx_device_h /*hdevice*/, size_t /*dev_maddr*/) {
+    return -1;
+}
+
+extern int vx_mem_info(vx_device_h /*hdevice*/, size_t* /*mem_free*/, size_t* /*mem_used*/) {
+    return -1;
+}
+
+vortex::ResidentCache* vx_resident_cache(vx_device_h /*hdevice*/) {
+    return nullptr;
+}
+
 extern int vx_alloc_shared_mem(vx_device_h /*hdevice*/, size_t /*size*/, vx_buffer_h* /*hbuffer*/) {
     return -1;
 }
 
+extern int vx_map_dev_mem(vx_device_h /*hdevice*/, size_t /*dev_maddr*/, size_t /*size*/, vx_buffer_h* /*hbuffer*/) {
+    return -1;
+}
+
 extern void* vx_host_ptr(vx_buffer_h /*hbuffer*/) {
     return nullptr;
 }
@@ -36,10 +53,30 @@ extern int vx_copy_from_dev(vx_buffer_h /*hbuffer*/, size_t /*dev_maddr*/, size_
      return -1;
 }
 
+extern int vx_copy_to_dev_sg(vx_buffer_h /*hbuffer*/, const vx_copy_desc_t* /*descs*/, unsigned /*count*/) {
+    return -1;
+}
+
+extern int vx_copy_from_dev_sg(vx_buffer_h /*hbuffer*/, const vx_copy_desc_t* /*descs*/, unsigned /*count*/) {
+    return -1;
+}
+
 extern int vx_start(vx_device_h /*hdevice*/) {
     return -1;
 }
 
 extern int vx_ready_wait(vx_device_h /*hdevice*/, long long /*timeout*/) {
     return -1;
-}
\ No newline at end of file
+}
+
+extern int vx_enqueue_copy_to_dev(vx_buffer_h /*hbuffer*/, size_t /*dev_maddr*/, size_t /*size*/, size_t /*src_offset*/, vx_event_h* /*hevent*/) {
+    return -1;
+}
+
+extern int vx_enqueue_copy_from_dev(vx_buffer_h /*hbuffer*/, size_t /*dev_maddr*/, size_t /*size*/, size_t /*dst_offset*/, vx_event_h* /*hevent*/) {
+    return -1;
+}
+
+extern int vx_enqueue_start(vx_device_h /*hdevice*/, vx_event_h* /*hevent*/) {
+    return -1;
+}
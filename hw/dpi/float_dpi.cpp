@@ -36,8 +36,19 @@ extern "C" {
   void dpi_feq(bool enable, int a, int b, int* result, svBitVecVal* fflags);
   void dpi_fmin(bool enable, int a, int b, int* result, svBitVecVal* fflags);
   void dpi_fmax(bool enable, int a, int b, int* result, svBitVecVal* fflags);
+
+  void dpi_fpu_v(bool enable, int op, int lanes, int mask, const svBitVecVal* a, const svBitVecVal* b, const svBitVecVal* c, const svBitVecVal* frm, svBitVecVal* result, svBitVecVal* fflags);
 }
 
+// warp-wide operations, must match the FPU_DPI_* definitions in float_dpi.vh
+enum {
+  FPU_DPI_ADD, FPU_DPI_SUB, FPU_DPI_MUL, FPU_DPI_MADD, FPU_DPI_MSUB, FPU_DPI_NMADD, FPU_DPI_NMSUB,
+  FPU_DPI_DIV, FPU_DPI_SQRT,
+  FPU_DPI_FTOI, FPU_DPI_FTOU, FPU_DPI_ITOF, FPU_DPI_UTOF,
+  FPU_DPI_CLASS, FPU_DPI_LT, FPU_DPI_LE, FPU_DPI_EQ, FPU_DPI_MIN, FPU_DPI_MAX,
+  FPU_DPI_SGNJ, FPU_DPI_SGNJN, FPU_DPI_SGNJX, FPU_DPI_MV
+};
+
 void dpi_fadd(bool enable, int a, int b, const svBitVecVal* frm, int* result, svBitVecVal* fflags) {
   if (!enable) 
     return;
@@ -168,4 +179,79 @@ void dpi_fsgnjx(bool enable, int a, int b, int* result) {
   if (!enable) 
     return;
   *result = rv_fsgnjx(a, b);
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// apply f to the active lanes and pack their 5-bit fflags
+template <typename F>
+static void fpu_lanes(int lanes, int mask, svBitVecVal* result, svBitVecVal* fflags, F f) {
+  for (int w = 0, n = (lanes * 5 + 31) / 32; w < n; ++w) {
+    fflags[w] = 0;
+  }
+  for (int i = 0; i < lanes; ++i) {
+    if (0 == ((mask >> i) & 1)) {
+      result[i] = 0;
+      continue;
+    }
+    uint32_t flags = 0;
+    result[i] = f(i, &flags);
+    int bit = i * 5;
+    fflags[bit / 32] |= flags << (bit % 32);
+    if ((bit % 32) > 27) {
+      fflags[bit / 32 + 1] |= flags >> (32 - (bit % 32));
+    }
+  }
+}
+
+void dpi_fpu_v(bool enable, int op, int lanes, int mask, const svBitVecVal* a, const svBitVecVal* b, const svBitVecVal* c, const svBitVecVal* frm, svBitVecVal* result, svBitVecVal* fflags) {
+  if (!enable) 
+    return;
+  
+  uint32_t rm = (*frm & 0x7);
+
+  switch (op) {
+  case FPU_DPI_ADD:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fadd(a[i], b[i], rm, f); }); break;
+  case FPU_DPI_SUB:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fsub(a[i], b[i], rm, f); }); break;
+  case FPU_DPI_MUL:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fmul(a[i], b[i], rm, f); }); break;
+  case FPU_DPI_MADD:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fmadd(a[i], b[i], c[i], rm, f); }); break;
+  case FPU_DPI_MSUB:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fmsub(a[i], b[i], c[i], rm, f); }); break;
+  case FPU_DPI_NMADD: fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fnmadd(a[i], b[i], c[i], rm, f); }); break;
+  case FPU_DPI_NMSUB: fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fnmsub(a[i], b[i], c[i], rm, f); }); break;
+  case FPU_DPI_DIV:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fdiv(a[i], b[i], rm, f); }); break;
+  case FPU_DPI_SQRT:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fsqrt(a[i], rm, f); }); break;
+  case FPU_DPI_FTOI:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_ftoi(a[i], rm, f); }); break;
+  case FPU_DPI_FTOU:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_ftou(a[i], rm, f); }); break;
+  case FPU_DPI_ITOF:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_itof(a[i], rm, f); }); break;
+  case FPU_DPI_UTOF:  fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_utof(a[i], rm, f); }); break;
+  case FPU_DPI_LT:    fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_flt(a[i], b[i], f); }); break;
+  case FPU_DPI_LE:    fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fle(a[i], b[i], f); }); break;
+  case FPU_DPI_EQ:    fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_feq(a[i], b[i], f); }); break;
+  case FPU_DPI_MIN:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fmin(a[i], b[i], f); }); break;
+  case FPU_DPI_MAX:   fpu_lanes(lanes, mask, result, fflags, [&](int i, uint32_t* f) { return rv_fmax(a[i], b[i], f); }); break;
+  default: {
+    // flag-free bit manipulations, computed on all lanes without branches
+    // so that the host compiler can vectorize them
+    for (int w = 0, n = (lanes * 5 + 31) / 32; w < n; ++w) {
+      fflags[w] = 0;
+    }
+    switch (op) {
+    case FPU_DPI_CLASS:
+      for (int i = 0; i < lanes; ++i) result[i] = rv_fclss(a[i]);
+      break;
+    case FPU_DPI_SGNJ:
+      for (int i = 0; i < lanes; ++i) result[i] = (a[i] & 0x7fffffff) | (b[i] & 0x80000000);
+      break;
+    case FPU_DPI_SGNJN:
+      for (int i = 0; i < lanes; ++i) result[i] = (a[i] & 0x7fffffff) | (~b[i] & 0x80000000);
+      break;
+    case FPU_DPI_SGNJX:
+      for (int i = 0; i < lanes; ++i) result[i] = a[i] ^ (b[i] & 0x80000000);
+      break;
+    default:
+      for (int i = 0; i < lanes; ++i) result[i] = a[i];
+      break;
+    }
+  } break;
+  }
+}
@@ -28,4 +28,33 @@ import "DPI-C" function void dpi_feq(input logic enable, input int a, input int
 import "DPI-C" function void dpi_fmin(input logic enable, input int a, input int b, output int result, output bit[4:0] fflags);
 import "DPI-C" function void dpi_fmax(input logic enable, input int a, input int b, output int result, output bit[4:0] fflags);
 
+// warp-wide models, one call per request: lanes are packed 32-bit words,
+// fflags are packed 5 bits per lane, lanes outside the mask are skipped
+
+`define FPU_DPI_ADD     0
+`define FPU_DPI_SUB     1
+`define FPU_DPI_MUL     2
+`define FPU_DPI_MADD    3
+`define FPU_DPI_MSUB    4
+`define FPU_DPI_NMADD   5
+`define FPU_DPI_NMSUB   6
+`define FPU_DPI_DIV     7
+`define FPU_DPI_SQRT    8
+`define FPU_DPI_FTOI    9
+`define FPU_DPI_FTOU    10
+`define FPU_DPI_ITOF    11
+`define FPU_DPI_UTOF    12
+`define FPU_DPI_CLASS   13
+`define FPU_DPI_LT      14
+`define FPU_DPI_LE      15
+`define FPU_DPI_EQ      16
+`define FPU_DPI_MIN     17
+`define FPU_DPI_MAX     18
+`define FPU_DPI_SGNJ    19
+`define FPU_DPI_SGNJN   20
+`define FPU_DPI_SGNJX   21
+`define FPU_DPI_MV      22
+
+import "DPI-C" function void dpi_fpu_v(input logic enable, input int op, input int lanes, input int mask, input bit[`NUM_THREADS*32-1:0] a, input bit[`NUM_THREADS*32-1:0] b, input bit[`NUM_THREADS*32-1:0] c, input bit[2:0] frm, output bit[`NUM_THREADS*32-1:0] result, output bit[`NUM_THREADS*5-1:0] fflags);
+
 `endif
\ No newline at end of file
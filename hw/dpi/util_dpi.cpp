@@ -1,28 +1,43 @@
 #include <stdio.h>
 #include <math.h>
 #include <unordered_map>
+#include <string>
 #include <vector>
 #include <mutex>
 #include <iostream>
 #include "svdpi.h"
 #include "verilated_vpi.h"
 #include "VX_config.h"
+#include "util.h"
+#include "perf_trace.h"
+#include "pipe_trace.h"
 
 extern "C" {
   void dpi_imul(bool enable, int a, int b, bool is_signed_a, bool is_signed_b, int* resultl, int* resulth);
   void dpi_idiv(bool enable, int a, int b, bool is_signed, int* quotient, int* remainder);
 
+  void dpi_imul_v(bool enable, int lanes, const svBitVecVal* a, const svBitVecVal* b, bool is_signed_a, bool is_signed_b, bool is_mulh, svBitVecVal* result);
+  void dpi_idiv_v(bool enable, int lanes, int mask, const svBitVecVal* a, const svBitVecVal* b, bool is_signed, bool is_rem, svBitVecVal* result);
+
   int dpi_register();
   void dpi_assert(int inst, bool cond, int delay);
 
   void dpi_trace(const char* format, ...);
   void dpi_trace_start();
   void dpi_trace_stop();
+
+  void dpi_perf_sample(int core_id, long long cycles, long long instrs, int active_warps, int active_threads, long long ibf_stalls, long long scb_stalls, long long alu_stalls, long long lsu_stalls, long long csr_stalls, long long fpu_stalls, long long gpu_stalls, long long mem_reads, long long mem_writes, long long mem_latency);
+
+  void dpi_trace_pipe(int core_id, int stage, int wid, int PC, int arg);
 }
 
 bool sim_trace_enabled();
 void sim_trace_enable(bool enable);
 
+vortex::PerfTrace* sim_perf_trace();
+
+vortex::PipeTrace* sim_pipe_trace();
+
 class ShiftRegister {
 public:
   ShiftRegister() : init_(false), depth_(0) {}
@@ -58,14 +73,14 @@ private:
 class Instances {
 public:
   ShiftRegister& get(int inst) {
+    std::lock_guard<std::mutex> guard(mutex_);
     return instances_.at(inst);
   }
 
   int allocate() {
-    mutex_.lock();   
+    std::lock_guard<std::mutex> guard(mutex_);
     int inst = instances_.size();
     instances_.resize(inst + 1); 
-    mutex_.unlock();
     return inst;
   }
 
@@ -148,6 +163,75 @@ void dpi_idiv(bool enable, int a, int b, bool is_signed, int* quotient, int* rem
   }
 }
 
+void dpi_imul_v(bool enable, int lanes, const svBitVecVal* a, const svBitVecVal* b, bool is_signed_a, bool is_signed_b, bool is_mulh, svBitVecVal* result) {
+  if (!enable)
+    return;
+
+  // branch-free over all lanes so that the host compiler can vectorize it,
+  // inactive lanes are discarded by the pipeline
+  uint64_t sext_a = is_signed_a ? 0xFFFFFFFF00000000 : 0;
+  uint64_t sext_b = is_signed_b ? 0xFFFFFFFF00000000 : 0;
+  int shift = is_mulh ? 32 : 0;
+  for (int i = 0; i < lanes; ++i) {
+    uint64_t first  = a[i] | ((a[i] & 0x80000000) ? sext_a : 0);
+    uint64_t second = b[i] | ((b[i] & 0x80000000) ? sext_b : 0);
+    result[i] = (uint32_t)((first * second) >> shift);
+  }
+}
+
+void dpi_idiv_v(bool enable, int lanes, int mask, const svBitVecVal* a, const svBitVecVal* b, bool is_signed, bool is_rem, svBitVecVal* result) {
+  if (!enable)
+    return;
+
+  for (int i = 0; i < lanes; ++i) {
+    if (0 == ((mask >> i) & 1)) {
+      result[i] = 0;
+      continue;
+    }
+    int quotient, remainder;
+    dpi_idiv(true, a[i], b[i], is_signed, &quotient, &remainder);
+    result[i] = is_rem ? remainder : quotient;
+  }
+}
+
+#ifdef VL_THREADED
+
+// trace lines are written in fragments, buffer them per worker thread
+// and print whole lines so that concurrent modules do not interleave
+static thread_local std::string trace_buf;
+static std::mutex trace_mutex;
+
+void dpi_trace(const char* format, ...) { 
+  if (!sim_trace_enabled())
+    return;
+  char tmp[256];
+  va_list va;
+  va_start(va, format);
+  int len = vsnprintf(tmp, sizeof(tmp), format, va);
+  va_end(va);
+  if (len < 0)
+    return;
+  if ((size_t)len < sizeof(tmp)) {
+    trace_buf.append(tmp, len);
+  } else {
+    std::vector<char> str(len + 1);
+    va_start(va, format);
+    vsnprintf(str.data(), str.size(), format, va);
+    va_end(va);
+    trace_buf.append(str.data(), len);
+  }
+  auto eol = trace_buf.rfind('\n');
+  if (eol == std::string::npos)
+    return;
+  {
+    std::lock_guard<std::mutex> guard(trace_mutex);
+    fwrite(trace_buf.data(), 1, eol + 1, stdout);
+  }
+  trace_buf.erase(0, eol + 1);
+}
+
+#else
+
 void dpi_trace(const char* format, ...) { 
   if (!sim_trace_enabled())
     return;
@@ -157,10 +241,56 @@ void dpi_trace(const char* format, ...) {
 	va_end(va);		  
 }
 
+#endif
+
 void dpi_trace_start() { 
   sim_trace_enable(true);
 }
 
 void dpi_trace_stop() { 
   sim_trace_enable(false);
-}
\ No newline at end of file
+}
+
+void dpi_perf_sample(int core_id, long long cycles, long long instrs, int active_warps, int active_threads, long long ibf_stalls, long long scb_stalls, long long alu_stalls, long long lsu_stalls, long long csr_stalls, long long fpu_stalls, long long gpu_stalls, long long mem_reads, long long mem_writes, long long mem_latency) {
+  auto perf_trace = sim_perf_trace();
+  if (nullptr == perf_trace)
+    return;
+
+  // two evaluations per clock cycle
+  uint64_t cycle = (uint64_t)sc_time_stamp() / 2;
+  if (0 != (cycle % perf_trace->interval()))
+    return;
+
+  auto d_cycles = perf_trace->delta(core_id, "cycles", cycles);
+  auto d_instrs = perf_trace->delta(core_id, "instrs", instrs);
+
+  perf_trace->counter(core_id, cycle, "ipc", {{"ipc", d_cycles ? double(d_instrs) / d_cycles : 0}});
+  perf_trace->counter(core_id, cycle, "warps", {{"active", active_warps}, 
+                                                {"threads", active_threads}});
+#ifdef PERF_ENABLE
+  perf_trace->counter(core_id, cycle, "stalls", {{"ibuffer", perf_trace->delta(core_id, "ibf_stalls", ibf_stalls)},
+                                                 {"scoreboard", perf_trace->delta(core_id, "scb_stalls", scb_stalls)},
+                                                 {"alu", perf_trace->delta(core_id, "alu_stalls", alu_stalls)},
+                                                 {"lsu", perf_trace->delta(core_id, "lsu_stalls", lsu_stalls)},
+                                                 {"csr", perf_trace->delta(core_id, "csr_stalls", csr_stalls)},
+                                                 {"fpu", perf_trace->delta(core_id, "fpu_stalls", fpu_stalls)},
+                                                 {"gpu", perf_trace->delta(core_id, "gpu_stalls", gpu_stalls)}});
+  auto d_reads   = perf_trace->delta(core_id, "mem_reads", mem_reads);
+  auto d_writes  = perf_trace->delta(core_id, "mem_writes", mem_writes);
+  auto d_latency = perf_trace->delta(core_id, "mem_latency", mem_latency);
+  perf_trace->counter(core_id, cycle, "memory", {{"reads", d_reads}, 
+                                                 {"writes", d_writes}, 
+                                                 {"latency", d_reads ? double(d_latency) / d_reads : 0}});
+#else
+  __unused(ibf_stalls, scb_stalls, alu_stalls, lsu_stalls, csr_stalls, fpu_stalls, gpu_stalls);
+  __unused(mem_reads, mem_writes, mem_latency);
+#endif
+}
+
+void dpi_trace_pipe(int core_id, int stage, int wid, int PC, int arg) {
+  auto pipe_trace = sim_pipe_trace();
+  if (nullptr == pipe_trace)
+    return;
+  uint64_t cycle = (uint64_t)sc_time_stamp() / 2;
+  pipe_trace->event(cycle, core_id, stage, wid, (uint32_t)PC, arg);
+}
@@ -4,6 +4,11 @@
 import "DPI-C" function void dpi_imul(input logic enable, input int a, input int b, input logic is_signed_a, input logic is_signed_b, output int resultl, output int resulth);
 import "DPI-C" function void dpi_idiv(input logic enable, input int a, input int b, input logic is_signed, output int quotient, output int remainder);
 
+// warp-wide models, one call per request: lanes are packed 32-bit words
+`include "VX_config.vh"
+import "DPI-C" function void dpi_imul_v(input logic enable, input int lanes, input bit[`NUM_THREADS*32-1:0] a, input bit[`NUM_THREADS*32-1:0] b, input logic is_signed_a, input logic is_signed_b, input logic is_mulh, output bit[`NUM_THREADS*32-1:0] result);
+import "DPI-C" function void dpi_idiv_v(input logic enable, input int lanes, input int mask, input bit[`NUM_THREADS*32-1:0] a, input bit[`NUM_THREADS*32-1:0] b, input logic is_signed, input logic is_rem, output bit[`NUM_THREADS*32-1:0] result);
+
 import "DPI-C" function int dpi_register();
 import "DPI-C" function void dpi_assert(int inst, input logic cond, input int delay);
 
@@ -11,4 +16,16 @@ import "DPI-C" function void dpi_trace(input string format /*verilator sformat*/
 import "DPI-C" function void dpi_trace_start();
 import "DPI-C" function void dpi_trace_stop();
 
+import "DPI-C" function void dpi_perf_sample(input int core_id, input longint cycles, input longint instrs, input int active_warps, input int active_threads, input longint ibf_stalls, input longint scb_stalls, input longint alu_stalls, input longint lsu_stalls, input longint csr_stalls, input longint fpu_stalls, input longint gpu_stalls, input longint mem_reads, input longint mem_writes, input longint mem_latency);
+
+`define PIPE_FETCH      0
+`define PIPE_DECODE     1
+`define PIPE_IBUFFER    2
+`define PIPE_ISSUE      3
+`define PIPE_STALL      4
+`define PIPE_EXECUTE    5
+`define PIPE_COMMIT     6
+
+import "DPI-C" function void dpi_trace_pipe(input int core_id, input int stage, input int wid, input int PC, input int arg);
+
 `endif
\ No newline at end of file
@@ -85,6 +85,33 @@ module VX_commit #(
     // store and gpu commits don't writeback  
     assign st_commit_if.ready  = 1'b1;
 
+`ifdef PIPE_TRACE_ENABLE
+    always @(posedge clk) begin
+        if (!reset) begin
+            if (alu_commit_fire && alu_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(alu_commit_if.wid), alu_commit_if.PC, 0);
+            end
+            if (ld_commit_fire && ld_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(ld_commit_if.wid), ld_commit_if.PC, 0);
+            end
+            if (st_commit_fire && st_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(st_commit_if.wid), st_commit_if.PC, 0);
+            end
+            if (csr_commit_fire && csr_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(csr_commit_if.wid), csr_commit_if.PC, 0);
+            end
+        `ifdef EXT_F_ENABLE
+            if (fpu_commit_fire && fpu_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(fpu_commit_if.wid), fpu_commit_if.PC, 0);
+            end
+        `endif
+            if (gpu_commit_fire && gpu_commit_if.eop) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_COMMIT, 32'(gpu_commit_if.wid), gpu_commit_if.PC, 0);
+            end
+        end
+    end
+`endif
+
 `ifdef DBG_TRACE_PIPELINE
     always @(posedge clk) begin
         if (alu_commit_if.valid && alu_commit_if.ready) begin
@@ -61,6 +61,21 @@
 `define IO_COUT_SIZE `MEM_BLOCK_SIZE
 `endif
 
+// printf ring buffers drained by the driver (header, per-thread write counts, per-thread rings)
+`ifndef IO_PRINT_ADDR
+`define IO_PRINT_ADDR 32'hFE000000
+`endif
+
+`ifndef IO_PRINT_LOG2_SIZE
+`define IO_PRINT_LOG2_SIZE 12
+`endif
+
+// enable word value, any other content keeps printf on IO_COUT
+`define IO_PRINT_ENABLE 32'h50524E54
+
+// header words written by the driver: enable word, ring count, rings offset, reserved
+`define IO_PRINT_HEADER_WORDS 4
+
 `ifndef IO_CSR_ADDR
 `define IO_CSR_ADDR `IO_BASE_ADDR
 `endif
@@ -229,6 +244,7 @@
 `define CSR_NT          12'hFC0
 `define CSR_NW          12'hFC1
 `define CSR_NC          12'hFC2
+`define CSR_SMEM_SIZE   12'hFC3     // per-core shared memory size, 0 without shared memory
 
 ////////// Texture Units //////////////////////////////////////////////////////
 
@@ -344,9 +360,15 @@
 `endif
 `define STACK_SIZE (1 << `STACK_LOG2_SIZE)
 
+// group local memory below the stacks, one stack size per thread
+`ifndef LMEM_ENABLE
+`define LMEM_ENABLE 0
+`endif
+`define LMEM_SIZE (`LMEM_ENABLE ? (`STACK_SIZE * `NUM_WARPS * `NUM_THREADS) : 0)
+
 // Size of cache in bytes
 `ifndef SMEM_SIZE
-`define SMEM_SIZE (`STACK_SIZE * `NUM_WARPS * `NUM_THREADS)
+`define SMEM_SIZE ((`STACK_SIZE * `NUM_WARPS * `NUM_THREADS) + `LMEM_SIZE)
 `endif
 
 // Number of banks
@@ -105,6 +105,40 @@ module VX_csr_data #(
         end
     end
 
+`ifdef PERF_TRACE_ENABLE
+    // periodic performance samples, the harness selects the sampling cycles
+    wire [`NUM_WARPS-1:0] perf_active_warps;
+    for (genvar i = 0; i < `NUM_WARPS; ++i) begin
+        assign perf_active_warps[i] = (fetch_to_csr_if.thread_masks[i] != 0);
+    end
+
+    always @(posedge clk) begin
+        if (!reset) begin
+            dpi_perf_sample(CORE_ID,
+                            csr_cycle,
+                            csr_instret,
+                            $countones(perf_active_warps),
+                            $countones(fetch_to_csr_if.thread_masks),
+                        `ifdef PERF_ENABLE
+                            64'(perf_pipeline_if.ibf_stalls),
+                            64'(perf_pipeline_if.scb_stalls),
+                            64'(perf_pipeline_if.alu_stalls),
+                            64'(perf_pipeline_if.lsu_stalls),
+                            64'(perf_pipeline_if.csr_stalls),
+                            64'(perf_pipeline_if.fpu_stalls),
+                            64'(perf_pipeline_if.gpu_stalls),
+                            64'(perf_memsys_if.mem_reads),
+                            64'(perf_memsys_if.mem_writes),
+                            64'(perf_memsys_if.mem_latency)
+                        `else
+                            64'(0), 64'(0), 64'(0), 64'(0), 64'(0), 64'(0), 64'(0),
+                            64'(0), 64'(0), 64'(0)
+                        `endif
+                            );
+        end
+    end
+`endif
+
     reg [31:0] read_data_r;
     reg read_addr_valid_r;
 
@@ -129,6 +163,7 @@ module VX_csr_data #(
             `CSR_NT         : read_data_r = `NUM_THREADS;
             `CSR_NW         : read_data_r = `NUM_WARPS;
             `CSR_NC         : read_data_r = `NUM_CORES * `NUM_CLUSTERS;
+            `CSR_SMEM_SIZE  : read_data_r = 32'(`SM_ENABLE ? `SMEM_SIZE : 0);
             
             `CSR_MCYCLE     : read_data_r = csr_cycle[31:0];
             `CSR_MCYCLE_H   : read_data_r = 32'(csr_cycle[`PERF_CTR_BITS-1:32]);
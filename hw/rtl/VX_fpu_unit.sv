@@ -76,6 +76,8 @@ module VX_fpu_unit #(
         .ready_in   (ready_in),        
 
         .tag_in     (tag_in),
+
+        .tmask_in   (fpu_req_if.tmask),
         
         .op_type    (fpu_req_if.op_type),
         .frm        (fpu_frm),
@@ -88,6 +88,19 @@ module VX_icache_stage #(
     `SCOPE_ASSIGN (icache_rsp_data, icache_rsp_if.data);
     `SCOPE_ASSIGN (icache_rsp_tag,  rsp_tag);
 
+`ifdef PIPE_TRACE_ENABLE
+    always @(posedge clk) begin
+        if (!reset) begin
+            if (icache_req_fire) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_FETCH, 32'(ifetch_req_if.wid), ifetch_req_if.PC, 0);
+            end
+            if (ifetch_rsp_if.valid && ifetch_rsp_if.ready) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_DECODE, 32'(ifetch_rsp_if.wid), ifetch_rsp_if.PC, 0);
+            end
+        end
+    end
+`endif
+
 `ifdef DBG_TRACE_CORE_ICACHE
     always @(posedge clk) begin
         if (icache_req_if.valid && icache_req_if.ready) begin
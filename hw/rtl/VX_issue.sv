@@ -208,6 +208,24 @@ module VX_issue #(
 `endif
 `endif
 
+`ifdef PIPE_TRACE_ENABLE
+    always @(posedge clk) begin
+        if (!reset) begin
+            if (decode_if.valid && decode_if.ready) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_IBUFFER, 32'(decode_if.wid), decode_if.PC, 0);
+            end
+            if (ibuffer_if.valid) begin
+                dpi_trace_pipe(CORE_ID, `PIPE_ISSUE, 32'(ibuffer_if.wid), ibuffer_if.PC, 0);
+                if (ibuffer_if.ready) begin
+                    dpi_trace_pipe(CORE_ID, `PIPE_EXECUTE, 32'(ibuffer_if.wid), ibuffer_if.PC, 32'(ibuffer_if.ex_type));
+                end else begin
+                    dpi_trace_pipe(CORE_ID, `PIPE_STALL, 32'(ibuffer_if.wid), ibuffer_if.PC, scoreboard_if.ready ? 2 : 1);
+                end
+            end
+        end
+    end
+`endif
+
 `ifdef DBG_TRACE_PIPELINE
     always @(posedge clk) begin
         if (alu_req_if.valid && alu_req_if.ready) begin
@@ -54,12 +54,8 @@ module VX_muldiv (
 
     wire mul_fire_in = mul_valid_in && mul_ready_in;
 
-    for (genvar i = 0; i < `NUM_THREADS; i++) begin
-        wire [31:0] mul_resultl, mul_resulth;
-        always @(*) begin        
-            dpi_imul (mul_fire_in, alu_in1[i], alu_in2[i], is_signed_mul_a, is_signed_mul_b, mul_resultl, mul_resulth);
-        end
-        assign mul_result_tmp[i] = is_mulh_in ? mul_resulth : mul_resultl;
+    always @(*) begin        
+        dpi_imul_v (mul_fire_in, `NUM_THREADS, alu_in1, alu_in2, is_signed_mul_a, is_signed_mul_b, is_mulh_in, mul_result_tmp);
     end
 
     VX_shift_register #(
@@ -138,12 +134,8 @@ module VX_muldiv (
 
     wire div_fire_in = div_valid_in && div_ready_in;
     
-    for (genvar i = 0; i < `NUM_THREADS; i++) begin
-        wire [31:0] div_quotient, div_remainder;
-        always @(*) begin        
-            dpi_idiv (div_fire_in, alu_in1[i], alu_in2[i], is_signed_div, div_quotient, div_remainder);
-        end
-        assign div_result_tmp[i] = is_rem_op_in ? div_remainder : div_quotient;
+    always @(*) begin        
+        dpi_idiv_v (div_fire_in, `NUM_THREADS, 32'(tmask_in), alu_in1, alu_in2, is_signed_div, is_rem_op_in, div_result_tmp);
     end
 
     VX_shift_register #(
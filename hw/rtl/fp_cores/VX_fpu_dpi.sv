@@ -10,6 +10,8 @@ module VX_fpu_dpi #(
     output wire ready_in,
 
     input wire [TAGW-1:0] tag_in,
+
+    input wire [`NUM_THREADS-1:0] tmask_in,
     
     input wire [`INST_FPU_BITS-1:0] op_type,
     input wire [`INST_MOD_BITS-1:0] frm,
@@ -46,82 +48,52 @@ module VX_fpu_dpi #(
 
     reg [FPC_BITS-1:0] core_select;
 
-    reg is_fadd, is_fsub, is_fmul, is_fmadd, is_fmsub, is_fnmadd, is_fnmsub;
-    reg is_itof, is_utof, is_ftoi, is_ftou;
-    reg is_fclss, is_flt, is_fle, is_feq, is_fmin, is_fmax, is_fsgnj, is_fsgnjn, is_fsgnjx;
+    reg [4:0] dpi_op;
 
     always @(*) begin
-        is_fadd   = 0;
-        is_fsub   = 0;        
-        is_fmul   = 0;        
-        is_fmadd  = 0;
-        is_fmsub  = 0;
-        is_fnmadd = 0;           
-        is_fnmsub = 0;        
-        is_itof   = 0;
-        is_utof   = 0;
-        is_ftoi   = 0;
-        is_ftou   = 0;
-        is_fclss  = 0;
-        is_flt    = 0;
-        is_fle    = 0;
-        is_feq    = 0;
-        is_fmin   = 0;
-        is_fmax   = 0;
-        is_fsgnj  = 0;
-        is_fsgnjn = 0;
-        is_fsgnjx = 0;
-
         case (op_type)
-            `INST_FPU_ADD:   begin core_select = FPU_FMA; is_fadd = 1; end
-            `INST_FPU_SUB:   begin core_select = FPU_FMA; is_fsub = 1; end
-            `INST_FPU_MUL:   begin core_select = FPU_FMA; is_fmul = 1; end
-            `INST_FPU_MADD:  begin core_select = FPU_FMA; is_fmadd = 1; end
-            `INST_FPU_MSUB:  begin core_select = FPU_FMA; is_fmsub = 1; end
-            `INST_FPU_NMADD: begin core_select = FPU_FMA; is_fnmadd = 1; end
-            `INST_FPU_NMSUB: begin core_select = FPU_FMA; is_fnmsub = 1; end
-            `INST_FPU_DIV:   begin core_select = FPU_DIV; end
-            `INST_FPU_SQRT:  begin core_select = FPU_SQRT; end
-            `INST_FPU_CVTWS: begin core_select = FPU_CVT; is_ftoi = 1; end
-            `INST_FPU_CVTWUS:begin core_select = FPU_CVT; is_ftou = 1; end
-            `INST_FPU_CVTSW: begin core_select = FPU_CVT; is_itof = 1; end
-            `INST_FPU_CVTSWU:begin core_select = FPU_CVT; is_utof = 1; end
-            `INST_FPU_CLASS: begin core_select = FPU_NCP; is_fclss = 1; end  
+            `INST_FPU_ADD:   begin core_select = FPU_FMA; dpi_op = `FPU_DPI_ADD; end
+            `INST_FPU_SUB:   begin core_select = FPU_FMA; dpi_op = `FPU_DPI_SUB; end
+            `INST_FPU_MUL:   begin core_select = FPU_FMA; dpi_op = `FPU_DPI_MUL; end
+            `INST_FPU_MADD:  begin core_select = FPU_FMA; dpi_op = `FPU_DPI_MADD; end
+            `INST_FPU_MSUB:  begin core_select = FPU_FMA; dpi_op = `FPU_DPI_MSUB; end
+            `INST_FPU_NMADD: begin core_select = FPU_FMA; dpi_op = `FPU_DPI_NMADD; end
+            `INST_FPU_NMSUB: begin core_select = FPU_FMA; dpi_op = `FPU_DPI_NMSUB; end
+            `INST_FPU_DIV:   begin core_select = FPU_DIV; dpi_op = `FPU_DPI_DIV; end
+            `INST_FPU_SQRT:  begin core_select = FPU_SQRT; dpi_op = `FPU_DPI_SQRT; end
+            `INST_FPU_CVTWS: begin core_select = FPU_CVT; dpi_op = `FPU_DPI_FTOI; end
+            `INST_FPU_CVTWUS:begin core_select = FPU_CVT; dpi_op = `FPU_DPI_FTOU; end
+            `INST_FPU_CVTSW: begin core_select = FPU_CVT; dpi_op = `FPU_DPI_ITOF; end
+            `INST_FPU_CVTSWU:begin core_select = FPU_CVT; dpi_op = `FPU_DPI_UTOF; end
+            `INST_FPU_CLASS: begin core_select = FPU_NCP; dpi_op = `FPU_DPI_CLASS; end  
             `INST_FPU_CMP:   begin core_select = FPU_NCP; 
-                            is_fle = (frm == 0); 
-                            is_flt = (frm == 1); 
-                            is_feq = (frm == 2); 
+                            case (frm)
+                            0:       dpi_op = `FPU_DPI_LE;
+                            1:       dpi_op = `FPU_DPI_LT;
+                            2:       dpi_op = `FPU_DPI_EQ;
+                            default: dpi_op = `FPU_DPI_MV;
+                            endcase
                          end  
             default:   begin core_select = FPU_NCP; 
-                            is_fsgnj  = (frm == 0);
-                            is_fsgnjn = (frm == 1);
-                            is_fsgnjx = (frm == 2);
-                            is_fmin   = (frm == 3);
-                            is_fmax   = (frm == 4);
+                            case (frm)
+                            0:       dpi_op = `FPU_DPI_SGNJ;
+                            1:       dpi_op = `FPU_DPI_SGNJN;
+                            2:       dpi_op = `FPU_DPI_SGNJX;
+                            3:       dpi_op = `FPU_DPI_MIN;
+                            4:       dpi_op = `FPU_DPI_MAX;
+                            default: dpi_op = `FPU_DPI_MV;
+                            endcase
                         end
         endcase
     end
 
+    // each unit evaluates the whole warp in a single DPI call
+
     generate 
     begin : fma
         
         wire [`NUM_THREADS-1:0][31:0] result_fma;
-        wire [`NUM_THREADS-1:0][31:0] result_fadd;
-        wire [`NUM_THREADS-1:0][31:0] result_fsub;
-        wire [`NUM_THREADS-1:0][31:0] result_fmul;
-        wire [`NUM_THREADS-1:0][31:0] result_fmadd;
-        wire [`NUM_THREADS-1:0][31:0] result_fmsub;
-        wire [`NUM_THREADS-1:0][31:0] result_fnmadd;
-        wire [`NUM_THREADS-1:0][31:0] result_fnmsub;
-        
         fflags_t [`NUM_THREADS-1:0] fflags_fma;
-        fflags_t [`NUM_THREADS-1:0] fflags_fadd;
-        fflags_t [`NUM_THREADS-1:0] fflags_fsub;
-        fflags_t [`NUM_THREADS-1:0] fflags_fmul;
-        fflags_t [`NUM_THREADS-1:0] fflags_fmadd;
-        fflags_t [`NUM_THREADS-1:0] fflags_fmsub;
-        fflags_t [`NUM_THREADS-1:0] fflags_fnmadd;
-        fflags_t [`NUM_THREADS-1:0] fflags_fnmsub;
 
         wire fma_valid = (valid_in && core_select == FPU_FMA);
         wire fma_ready = per_core_ready_out[FPU_FMA] || ~per_core_valid_out[FPU_FMA];
@@ -129,35 +101,9 @@ module VX_fpu_dpi #(
         wire fma_fire = fma_valid && fma_ready;
 
         always @(*) begin        
-            for (integer i = 0; i < `NUM_THREADS; i++) begin
-                dpi_fadd   (fma_fire, dataa[i], datab[i], frm, result_fadd[i], fflags_fadd[i]);
-                dpi_fsub   (fma_fire, dataa[i], datab[i], frm, result_fsub[i], fflags_fsub[i]);
-                dpi_fmul   (fma_fire, dataa[i], datab[i], frm, result_fmul[i], fflags_fmul[i]);
-                dpi_fmadd  (fma_fire, dataa[i], datab[i], datac[i], frm, result_fmadd[i], fflags_fmadd[i]);
-                dpi_fmsub  (fma_fire, dataa[i], datab[i], datac[i], frm, result_fmsub[i], fflags_fmsub[i]);
-                dpi_fnmadd (fma_fire, dataa[i], datab[i], datac[i], frm, result_fnmadd[i], fflags_fnmadd[i]);
-                dpi_fnmsub (fma_fire, dataa[i], datab[i], datac[i], frm, result_fnmsub[i], fflags_fnmsub[i]);
-            end
+            dpi_fpu_v (fma_fire, 32'(dpi_op), `NUM_THREADS, 32'(tmask_in), dataa, datab, datac, frm, result_fma, fflags_fma);
         end
 
-        assign result_fma = is_fadd   ? result_fadd :
-                            is_fsub   ? result_fsub :
-                            is_fmul   ? result_fmul :
-                            is_fmadd  ? result_fmadd :               
-                            is_fmsub  ? result_fmsub :
-                            is_fnmadd ? result_fnmadd :               
-                            is_fnmsub ? result_fnmsub :
-                                        0;
-
-        assign fflags_fma = is_fadd   ? fflags_fadd :
-                            is_fsub   ? fflags_fsub :
-                            is_fmul   ? fflags_fmul :
-                            is_fmadd  ? fflags_fmadd :               
-                            is_fmsub  ? fflags_fmsub :
-                            is_fnmadd ? fflags_fnmadd :               
-                            is_fnmsub ? fflags_fnmsub : 
-                                        0;                
-
         VX_shift_register #(
             .DATAW  (1 + TAGW + `NUM_THREADS * (32 + $bits(fflags_t))),
             .DEPTH  (`LATENCY_FMA),
@@ -188,9 +134,7 @@ module VX_fpu_dpi #(
         wire fdiv_fire = fdiv_valid && fdiv_ready;
         
         always @(*) begin        
-            for (integer i = 0; i < `NUM_THREADS; i++) begin
-                dpi_fdiv (fdiv_fire, dataa[i], datab[i], frm, result_fdiv[i], fflags_fdiv[i]);
-            end
+            dpi_fpu_v (fdiv_fire, `FPU_DPI_DIV, `NUM_THREADS, 32'(tmask_in), dataa, datab, datac, frm, result_fdiv, fflags_fdiv);
         end
 
         VX_shift_register #(
@@ -223,9 +167,7 @@ module VX_fpu_dpi #(
         wire fsqrt_fire = fsqrt_valid && fsqrt_ready;
         
         always @(*) begin        
-            for (integer i = 0; i < `NUM_THREADS; i++) begin
-                dpi_fsqrt (fsqrt_fire, dataa[i], frm, result_fsqrt[i], fflags_fsqrt[i]);
-            end
+            dpi_fpu_v (fsqrt_fire, `FPU_DPI_SQRT, `NUM_THREADS, 32'(tmask_in), dataa, datab, datac, frm, result_fsqrt, fflags_fsqrt);
         end
 
         VX_shift_register #(
@@ -250,16 +192,7 @@ module VX_fpu_dpi #(
     begin : fcvt
 
         wire [`NUM_THREADS-1:0][31:0] result_fcvt;
-        wire [`NUM_THREADS-1:0][31:0] result_itof;
-        wire [`NUM_THREADS-1:0][31:0] result_utof;
-        wire [`NUM_THREADS-1:0][31:0] result_ftoi;
-        wire [`NUM_THREADS-1:0][31:0] result_ftou;
-        
         fflags_t [`NUM_THREADS-1:0] fflags_fcvt;
-        fflags_t [`NUM_THREADS-1:0] fflags_itof;
-        fflags_t [`NUM_THREADS-1:0] fflags_utof;
-        fflags_t [`NUM_THREADS-1:0] fflags_ftoi;
-        fflags_t [`NUM_THREADS-1:0] fflags_ftou;
 
         wire fcvt_valid = (valid_in && core_select == FPU_CVT);
         wire fcvt_ready = per_core_ready_out[FPU_CVT] || ~per_core_valid_out[FPU_CVT];
@@ -267,26 +200,9 @@ module VX_fpu_dpi #(
         wire fcvt_fire = fcvt_valid && fcvt_ready;
                 
         always @(*) begin        
-            for (integer i = 0; i < `NUM_THREADS; i++) begin
-                dpi_itof (fcvt_fire, dataa[i], frm, result_itof[i], fflags_itof[i]);
-                dpi_utof (fcvt_fire, dataa[i], frm, result_utof[i], fflags_utof[i]);
-                dpi_ftoi (fcvt_fire, dataa[i], frm, result_ftoi[i], fflags_ftoi[i]);
-                dpi_ftou (fcvt_fire, dataa[i], frm, result_ftou[i], fflags_ftou[i]);
-            end
+            dpi_fpu_v (fcvt_fire, 32'(dpi_op), `NUM_THREADS, 32'(tmask_in), dataa, datab, datac, frm, result_fcvt, fflags_fcvt);
         end
 
-        assign result_fcvt = is_itof ? result_itof :
-                             is_utof ? result_utof :
-                             is_ftoi ? result_ftoi :
-                             is_ftou ? result_ftou : 
-                                       0;
-
-        assign fflags_fcvt = is_itof ? fflags_itof :
-                             is_utof ? fflags_utof :
-                             is_ftoi ? fflags_ftoi :
-                             is_ftou ? fflags_ftou : 
-                                       0;
-
         VX_shift_register #(
             .DATAW  (1 + TAGW + `NUM_THREADS * (32 + $bits(fflags_t))),
             .DEPTH  (`LATENCY_FCVT),
@@ -309,23 +225,7 @@ module VX_fpu_dpi #(
     begin : fncp
 
         wire [`NUM_THREADS-1:0][31:0] result_fncp;
-        wire [`NUM_THREADS-1:0][31:0] result_fclss;
-        wire [`NUM_THREADS-1:0][31:0] result_flt;
-        wire [`NUM_THREADS-1:0][31:0] result_fle;
-        wire [`NUM_THREADS-1:0][31:0] result_feq;
-        wire [`NUM_THREADS-1:0][31:0] result_fmin;
-        wire [`NUM_THREADS-1:0][31:0] result_fmax;
-        wire [`NUM_THREADS-1:0][31:0] result_fsgnj;
-        wire [`NUM_THREADS-1:0][31:0] result_fsgnjn;
-        wire [`NUM_THREADS-1:0][31:0] result_fsgnjx;
-        reg [`NUM_THREADS-1:0][31:0] result_fmv;
-
         fflags_t [`NUM_THREADS-1:0] fflags_fncp;
-        fflags_t [`NUM_THREADS-1:0] fflags_flt;
-        fflags_t [`NUM_THREADS-1:0] fflags_fle;
-        fflags_t [`NUM_THREADS-1:0] fflags_feq;
-        fflags_t [`NUM_THREADS-1:0] fflags_fmin;
-        fflags_t [`NUM_THREADS-1:0] fflags_fmax;
 
         wire fncp_valid = (valid_in && core_select == FPU_NCP);
         wire fncp_ready = per_core_ready_out[FPU_NCP] || ~per_core_valid_out[FPU_NCP];
@@ -333,39 +233,10 @@ module VX_fpu_dpi #(
         wire fncp_fire = fncp_valid && fncp_ready;
                 
         always @(*) begin        
-            for (integer i = 0; i < `NUM_THREADS; i++) begin
-                dpi_fclss  (fncp_fire, dataa[i], result_fclss[i]);
-                dpi_flt    (fncp_fire, dataa[i], datab[i], result_flt[i], fflags_flt[i]);
-                dpi_fle    (fncp_fire, dataa[i], datab[i], result_fle[i], fflags_fle[i]);
-                dpi_feq    (fncp_fire, dataa[i], datab[i], result_feq[i], fflags_feq[i]);
-                dpi_fmin   (fncp_fire, dataa[i], datab[i], result_fmin[i], fflags_fmin[i]);
-                dpi_fmax   (fncp_fire, dataa[i], datab[i], result_fmax[i], fflags_fmax[i]);            
-                dpi_fsgnj  (fncp_fire, dataa[i], datab[i], result_fsgnj[i]);
-                dpi_fsgnjn (fncp_fire, dataa[i], datab[i], result_fsgnjn[i]);
-                dpi_fsgnjx (fncp_fire, dataa[i], datab[i], result_fsgnjx[i]);
-                result_fmv[i] = dataa[i];
-            end
+            dpi_fpu_v (fncp_fire, 32'(dpi_op), `NUM_THREADS, 32'(tmask_in), dataa, datab, datac, frm, result_fncp, fflags_fncp);
         end
 
-        assign result_fncp = is_fclss  ? result_fclss :
-                             is_flt    ? result_flt :
-                             is_fle    ? result_fle :
-                             is_feq    ? result_feq :
-                             is_fmin   ? result_fmin :
-                             is_fmax   ? result_fmax :
-                             is_fsgnj  ? result_fsgnj :
-                             is_fsgnjn ? result_fsgnjn :
-                             is_fsgnjx ? result_fsgnjx :
-                                         result_fmv;
-
-        wire has_fflags_fncp = (is_flt || is_fle || is_feq || is_fmin || is_fmax);
-
-        assign fflags_fncp = is_flt  ? fflags_flt :
-                             is_fle  ? fflags_fle :
-                             is_feq  ? fflags_feq :
-                             is_fmin ? fflags_fmin :
-                             is_fmax ? fflags_fmax : 
-                                       0;
+        wire has_fflags_fncp = (dpi_op >= `FPU_DPI_LT && dpi_op <= `FPU_DPI_MAX);
 
         VX_shift_register #(
             .DATAW  (1 + TAGW + 1 + `NUM_THREADS * (32 + $bits(fflags_t))),
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+import struct
+import argparse
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def bytes(self, n):
+        b = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return b
+
+    def u16(self):
+        return struct.unpack('<H', self.bytes(2))[0]
+
+    def u32(self):
+        return struct.unpack('<I', self.bytes(4))[0]
+
+    def i32(self):
+        return struct.unpack('<i', self.bytes(4))[0]
+
+    def u64(self):
+        return struct.unpack('<Q', self.bytes(8))[0]
+
+    def name(self):
+        return self.bytes(self.u16()).decode()
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7f) << shift
+            if b < 0x80:
+                return value
+            shift += 7
+
+def load_trace(filename):
+    with open(filename, 'rb') as f:
+        r = Reader(f.read())
+
+    if r.bytes(8) != b'VXSCOPE\0':
+        raise Exception("invalid scope trace: " + filename)
+    version = r.u32()
+    if version != 1:
+        raise Exception("unsupported scope trace version: " + str(version))
+
+    modules = []
+    for i in range(r.u32()):
+        modules.append((r.i32(), r.i32(), r.name()))
+
+    taps = []
+    for i in range(r.u32()):
+        module = r.i32()
+        width = r.u32()
+        taps.append((module, width, r.name()))
+
+    num_frames = r.u64()
+
+    end = r.u64() + r.pos
+    clocks = []
+    while r.pos < end:
+        clocks.append(r.varint())
+
+    # expand each tap's (run, value) column into a value per frame
+    columns = []
+    for tap in taps:
+        nbytes = (tap[1] + 7) // 8
+        end = r.u64() + r.pos
+        values = []
+        while r.pos < end:
+            run = r.varint()
+            value = int.from_bytes(r.bytes(nbytes), 'little')
+            values.extend([value] * run)
+        columns.append(values)
+
+    return modules, taps, num_frames, clocks, columns
+
+def write_vcd(filename, modules, taps, num_frames, clocks, columns):
+    with open(filename, 'w') as f:
+        def dump_taps(module):
+            for i, tap in enumerate(taps):
+                if tap[0] == module:
+                    f.write("$var reg %d %d %s $end\n" % (tap[1], i + 1, tap[2]))
+
+        def dump_module(parent):
+            for module in modules:
+                if module[1] != parent:
+                    continue
+                if module[2][0] == '*':
+                    f.write("$var reg 1 0 clk $end\n")
+                else:
+                    f.write("$scope module %s $end\n" % module[2])
+                dump_module(module[0])
+                dump_taps(module[0])
+                if module[2][0] != '*':
+                    f.write("$upscope $end\n")
+
+        f.write("$version Generated by Vortex Scope $end\n")
+        f.write("$timescale 1 ns $end\n")
+        f.write("$scope module TOP $end\n")
+        dump_module(-1)
+        dump_taps(-1)
+        f.write("$upscope $end\n")
+        f.write("enddefinitions $end\n")
+
+        timestamp = 0
+        for n in range(num_frames):
+            for c in range(clocks[n]):
+                f.write("#%d\nb0 0\n#%d\nb1 0\n" % (timestamp, timestamp + 1))
+                timestamp += 2
+            for i in reversed(range(len(taps))):
+                value = columns[i][n]
+                if n != 0 and value == columns[i][n - 1]:
+                    continue
+                f.write("b%s %d\n" % (format(value, '0%db' % taps[i][1]), i + 1))
+
+    print("scope trace converted - %d cycles" % (timestamp // 2))
+
+def main():
+    parser = argparse.ArgumentParser(description='Scope binary trace to VCD converter.')
+    parser.add_argument('-o', nargs='?', default='trace.vcd', metavar='file', help='Output VCD file')
+    parser.add_argument('trace', help='Scope binary trace (trace.scope)')
+    args = parser.parse_args()
+
+    write_vcd(args.o, *load_trace(args.trace))
+
+if __name__ == '__main__':
+    main()
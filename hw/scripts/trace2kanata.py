@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+import re
+import argparse
+
+# pipeline stages, in program order
+FETCH   = 0
+DECODE  = 1
+IBUFFER = 2
+EXECUTE = 3
+
+# run.log lines emitted by DBG_TRACE_CORE_ICACHE and DBG_TRACE_PIPELINE
+patterns = [
+    (FETCH,   "F",  re.compile(r'^\s*(\d+): I\$(\d+) req: wid=(\d+), PC=([0-9a-fA-F]+)')),
+    (DECODE,  "D",  re.compile(r'^\s*(\d+): I\$(\d+) rsp: wid=(\d+), PC=([0-9a-fA-F]+)')),
+    (IBUFFER, "Ib", re.compile(r'^\s*(\d+): core(\d+)-decode: wid=(\d+), PC=([0-9a-fA-F]+)')),
+    (EXECUTE, "X",  re.compile(r'^\s*(\d+): core(\d+)-issue: wid=(\d+), PC=([0-9a-fA-F]+), ex=(\w+)')),
+    (None,    None, re.compile(r'^\s*(\d+): core(\d+)-commit: wid=(\d+), PC=([0-9a-fA-F]+)')),
+]
+
+class KanataWriter:
+    def __init__(self, f):
+        self.f = f
+        self.cycle = None
+        self.next_id = 0
+        self.retired = 0
+        # in-flight instances per (core, wid, PC), oldest first
+        self.instrs = {}
+        self.f.write("Kanata\t0004\n")
+
+    def set_cycle(self, cycle):
+        if self.cycle is None:
+            self.f.write("C=\t%d\n" % cycle)
+            self.cycle = cycle
+        elif cycle > self.cycle:
+            self.f.write("C\t%d\n" % (cycle - self.cycle))
+            self.cycle = cycle
+
+    def start_stage(self, instr, stage, name):
+        self.end_stage(instr)
+        self.f.write("S\t%d\t0\t%s\n" % (instr['id'], name))
+        instr['stage'] = stage
+        instr['name'] = name
+
+    def end_stage(self, instr):
+        if instr['name']:
+            self.f.write("E\t%d\t0\t%s\n" % (instr['id'], instr['name']))
+            instr['name'] = None
+
+    def fetch(self, key):
+        instr = { 'id': self.next_id, 'stage': FETCH, 'name': None }
+        self.next_id += 1
+        self.f.write("I\t%d\t%d\t%d\n" % (instr['id'], instr['id'], key[0]))
+        self.f.write("L\t%d\t0\t%x core%d wid=%d\n" % (instr['id'], key[2], key[0], key[1]))
+        self.start_stage(instr, FETCH, "F")
+        self.instrs.setdefault(key, []).append(instr)
+
+    def advance(self, key, stage, name):
+        for instr in self.instrs.get(key, []):
+            if instr['stage'] == stage - 1:
+                self.start_stage(instr, stage, name)
+                return
+
+    def commit(self, key):
+        # multi-cycle commits (e.g. partial load responses) retire on the first one
+        queue = self.instrs.get(key, [])
+        for i, instr in enumerate(queue):
+            if instr['stage'] == EXECUTE:
+                self.end_stage(instr)
+                self.f.write("R\t%d\t%d\t0\n" % (instr['id'], self.retired))
+                self.retired += 1
+                del queue[i]
+                return
+
+    def close(self):
+        # close instructions still in flight as flushed
+        for queue in self.instrs.values():
+            for instr in queue:
+                self.f.write("R\t%d\t%d\t1\n" % (instr['id'], instr['id']))
+
+def convert(log, output):
+    with open(log, 'r') as fi, open(output, 'w') as fo:
+        writer = KanataWriter(fo)
+        for line in fi:
+            for stage, name, pattern in patterns:
+                m = pattern.match(line)
+                if not m:
+                    continue
+                # two evaluations per clock cycle
+                writer.set_cycle(int(m.group(1)) // 2)
+                key = (int(m.group(2)), int(m.group(3)), int(m.group(4), 16))
+                if stage == FETCH:
+                    writer.fetch(key)
+                elif stage == EXECUTE:
+                    writer.advance(key, stage, name + ":" + m.group(5))
+                elif stage is not None:
+                    writer.advance(key, stage, name)
+                else:
+                    writer.commit(key)
+                break
+        writer.close()
+        print("pipeline trace converted - %d instructions retired" % writer.retired)
+
+def main():
+    parser = argparse.ArgumentParser(description='Debug trace to Kanata pipeline trace converter.')
+    parser.add_argument('-o', nargs='?', default='trace.kanata', metavar='file', help='Output Kanata file')
+    parser.add_argument('log', help='Simulation log with DBG_TRACE_PIPELINE enabled (run.log)')
+    args = parser.parse_args()
+
+    convert(args.log, args.o)
+
+if __name__ == '__main__':
+    main()
@@ -1,40 +1,243 @@
 #include "cachesim.h"
-#include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <vector>
-#include <bitset> 
+#include <iomanip>
+#include <algorithm>
+#include <type_traits>
+#include <string.h>
+
+static constexpr uint32_t log2i(uint32_t x) {
+  return (x > 1) ? (1 + log2i(x >> 1)) : 0;
+}
+
+#define LINE_BITS       log2i(CACHE_LINE_SIZE)
+#define WORD_ADDR_WIDTH (32 - log2i(WORD_SIZE))
+#define NUM_TAGS        (1u << CORE_TAG_WIDTH)
+
+// quiet cycles after the last transfer before a run completes
+#define IDLE_CYCLES     64
+
+// cycles without any transfer before a busy cache is reported as stalled
+#define STALL_CYCLES    100000
+
+// load data errors printed per run
+#define MAX_ERRORS      10
+
+static_assert(WORD_SIZE == 4, "the testbench uses 32-bit words");
+static_assert(NUM_REQS <= 32, "lane masks are 32-bit");
+static_assert(CORE_TAG_WIDTH <= 16, "tag space too large");
 
 uint64_t timestamp = 0;
 
-double sc_time_stamp() { 
+double sc_time_stamp() {
   return timestamp;
 }
 
-CacheSim::CacheSim() {
-  // force random values for uninitialized signals  
+// Verilator packs port arrays into an integer or a 32-bit word array
+// depending on their width
+
+template <typename T>
+static typename std::enable_if<std::is_integral<T>::value, uint32_t>::type
+get_bits(const T& sig, uint32_t lsb, uint32_t width) {
+  return uint32_t((uint64_t(sig) >> lsb) & ((1ull << width) - 1));
+}
+
+template <typename T>
+static typename std::enable_if<!std::is_integral<T>::value, uint32_t>::type
+get_bits(const T& sig, uint32_t lsb, uint32_t width) {
+  uint32_t word  = lsb / 32;
+  uint32_t shift = lsb % 32;
+  uint64_t value = uint64_t(sig[word]) >> shift;
+  if (shift + width > 32) {
+    value |= uint64_t(sig[word + 1]) << (32 - shift);
+  }
+  return uint32_t(value & ((1ull << width) - 1));
+}
+
+template <typename T>
+static typename std::enable_if<std::is_integral<T>::value>::type
+set_bits(T& sig, uint32_t lsb, uint32_t width, uint32_t value) {
+  uint64_t mask = ((1ull << width) - 1) << lsb;
+  sig = T((uint64_t(sig) & ~mask) | ((uint64_t(value) << lsb) & mask));
+}
+
+template <typename T>
+static typename std::enable_if<!std::is_integral<T>::value>::type
+set_bits(T& sig, uint32_t lsb, uint32_t width, uint32_t value) {
+  uint32_t word  = lsb / 32;
+  uint32_t shift = lsb % 32;
+  uint64_t mask  = ((1ull << width) - 1) << shift;
+  uint64_t bits  = (uint64_t(value) << shift) & mask;
+  sig[word] = uint32_t((sig[word] & ~mask) | bits);
+  if (shift + width > 32) {
+    sig[word + 1] = uint32_t((sig[word + 1] & ~(mask >> 32)) | (bits >> 32));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BenchConfig::BenchConfig()
+  : pattern(PATTERN_SEQ)
+  , requests(10000)
+  , base(0)
+  , footprint(CACHE_SIZE / 2)
+  , stride(CACHE_LINE_SIZE)
+  , write_ratio(0)
+  , lane_ratio(100)
+  , max_pending(0)
+  , seed(1)
+{}
+
+static const char* pattern_names[] = {"seq", "stride", "random", "conflict"};
+
+int BenchConfig::set_pattern(const char* name) {
+  for (int i = 0; i <= PATTERN_CONFLICT; ++i) {
+    if (0 == strcmp(name, pattern_names[i])) {
+      pattern = pattern_t(i);
+      return 0;
+    }
+  }
+  std::cerr << "*** error: unknown access pattern " << name << std::endl;
+  return -1;
+}
+
+const char* BenchConfig::pattern_name() const {
+  return pattern_names[pattern];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+LatencyHist::LatencyHist() : bins_(MAX_LATENCY + 1) {
+  this->clear();
+}
+
+void LatencyHist::clear() {
+  std::fill(bins_.begin(), bins_.end(), 0);
+  count_ = 0;
+  total_ = 0;
+  min_   = -1ull;
+  max_   = 0;
+}
+
+void LatencyHist::add(uint64_t latency) {
+  ++bins_[std::min<uint64_t>(latency, MAX_LATENCY)];
+  ++count_;
+  total_ += latency;
+  min_ = std::min(min_, latency);
+  max_ = std::max(max_, latency);
+}
+
+uint64_t LatencyHist::percentile(uint32_t p) const {
+  uint64_t target = (count_ * p + 99) / 100;
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < MAX_LATENCY; ++i) {
+    sum += bins_[i];
+    if (sum >= target && sum != 0)
+      return i;
+  }
+  return max_;
+}
+
+void LatencyHist::print(std::ostream& out, const char* name) const {
+  std::string prefix(name);
+  if (0 == count_) {
+    out << std::setw(28) << (prefix + " latency:") << "-" << std::endl;
+    return;
+  }
+  out << std::setw(28) << (prefix + " latency min/avg/max:")
+      << min_ << "/" << (total_ / count_) << "/" << max_ << std::endl;
+  out << std::setw(28) << (prefix + " latency p50/p90/p99:")
+      << this->percentile(50) << "/" << this->percentile(90) << "/" << this->percentile(99) << std::endl;
+
+  // up to 16 buckets over [min, max], exact for narrow ranges
+  uint64_t first = std::min<uint64_t>(min_, MAX_LATENCY);
+  uint64_t last  = std::min<uint64_t>(max_, MAX_LATENCY);
+  uint64_t width = (last - first + 16) / 16;
+  for (uint64_t lo = first; lo <= last; lo += width) {
+    uint64_t end = std::min(lo + width - 1, last);
+    uint64_t count = 0;
+    for (uint64_t i = lo; i <= end; ++i) {
+      count += bins_[i];
+    }
+    if (0 == count)
+      continue;
+    std::string label = "  " + std::to_string(lo);
+    if (end != lo) {
+      label += "-" + std::to_string(end);
+    }
+    if (end == MAX_LATENCY) {
+      label += "+";
+    }
+    out << std::setw(28) << (label + ":") << count
+        << " (" << (count * 100 / count_) << "%)" << std::endl;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CacheStats::CacheStats() {
+  this->clear();
+}
+
+void CacheStats::clear() {
+  cycles     = 0;
+  requests   = 0;
+  reads      = 0;
+  writes     = 0;
+  stalls     = 0;
+  errors     = 0;
+  mem_reads  = 0;
+  mem_writes = 0;
+  fills      = 0;
+  fills_max  = 0;
+  mshr_full  = 0;
+  loads      = 0;
+  hit_latency.clear();
+  miss_latency.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CacheSim::CacheSim()
+  : core_req_lanes_(0)
+  , core_req_tag_(-1)
+  , pending_(NUM_TAGS)
+  , max_pending_(NUM_TAGS)
+  , mem_rsp_active_(false)
+  , mem_rsp_addr_(0)
+  , cycle_(0)
+  , start_cycle_(0)
+  , last_active_(0)
+  , rand_(1)
+  , ram_(nullptr) {
+  // force random values for uninitialized signals
   Verilated::randReset(2);
 
-  ram_ = nullptr;
   cache_ = new VVX_cache();
 
-  mem_rsp_active_ = false;
-  snp_req_active_ = false;
+  for (auto& fills : bank_fills_) {
+    fills = 0;
+  }
+
+  vortex::DramConfig dram_config;
+  if (0 == dram_config.load_env()) {
+    dram_ = vortex::DramSim(dram_config);
+  }
 
-//#ifdef VCD_OUTPUT
+#ifdef VM_TRACE
   Verilated::traceEverOn(true);
   trace_ = new VerilatedVcdC;
   cache_->trace(trace_, 99);
   trace_->open("trace.vcd");
-//#endif
+#endif
 }
 
 CacheSim::~CacheSim() {
-//#ifdef VCD_OUTPUT
+#ifdef VM_TRACE
   trace_->close();
-//#endif
+  delete trace_;
+#endif
+  cache_->final();
   delete cache_;
-  //need to delete the req and rsp vectors
 }
 
 void CacheSim::attach_ram(RAM* ram) {
@@ -47,274 +250,461 @@ void CacheSim::reset() {
   std::cout << timestamp << ": [sim] reset()" << std::endl;
 #endif
 
+  std::queue<core_req_t>().swap(core_req_vec_);
+  core_req_lanes_ = 0;
+  core_req_tag_ = -1;
+  free_tags_.clear();
+  for (uint32_t tag = NUM_TAGS; tag-- > 0;) {
+    free_tags_.push_back(tag);
+  }
+  for (auto& entry : pending_) {
+    entry.tmask = 0;
+  }
+  max_pending_ = NUM_TAGS;
+
+  mem_rsp_vec_.clear();
+  mem_rsp_active_ = false;
+  for (auto& fills : bank_fills_) {
+    fills = 0;
+  }
+  shadow_.clear();
+  fill_cycle_.clear();
+  dram_.reset();
+
+  cache_->core_req_valid = 0;
+  cache_->core_rsp_ready = 1;
+  cache_->mem_req_ready  = 0;
+  cache_->mem_rsp_valid  = 0;
+
   cache_->reset = 1;
   this->step();
-  cache_->reset = 0;
   this->step();
+  cache_->reset = 0;
 
-  mem_rsp_vec_.clear();
-  //clear req and rsp vecs
-  
+  // wait for the tag flush after reset
+  for (uint32_t i = 0; i < (CACHE_SIZE / CACHE_LINE_SIZE) + 16; ++i) {
+    this->step();
+    if (get_bits(cache_->core_req_ready, 0, NUM_REQS) == ((1ull << NUM_REQS) - 1))
+      break;
+  }
+
+  stats_.clear();
+  start_cycle_ = cycle_;
+  last_active_ = cycle_;
 }
 
 void CacheSim::step() {
-  //std::cout << timestamp << ": [sim] step()" << std::endl;
-  //toggle clock
   cache_->clk = 0;
   this->eval();
 
-  cache_->clk = 1;
-  this->eval();
-
-  //handle core and memory reqs and rsps
+  // transfers complete on the rising edge
   this->eval_reqs();
   this->eval_rsps();
   this->eval_mem_bus();
-  timestamp++;
+
+  cache_->clk = 1;
+  this->eval();
+  ++cycle_;
+
+  this->drive_reqs();
+  this->drive_mem_bus();
 }
 
 void CacheSim::eval() {
   cache_->eval();
-//#ifdef VCD_OUTPUT
+#ifdef VM_TRACE
   trace_->dump(timestamp);
-//#endif
+#endif
   ++timestamp;
 }
 
-void CacheSim::run(){
-//#ifndef NDEBUG
-  
-//#endif
-  this->step();
-
-  int valid = 300; 
-  int stalls = 20 + 10; 
-  
-  while (valid > -1) {
+void CacheSim::send_req(const core_req_t& req) {
+  core_req_vec_.push(req);
+}
 
-      this->step();
-      display_miss(); 
-      if(cache_->core_rsp_valid){
-        get_core_rsp();
-      }
-      
-      if(!cache_->core_req_valid && !cache_->core_rsp_valid){
-        valid--; 
-       
-      }
-      stalls--; 
-      if (stalls == 20){
-          //stall_mem(); 
-          //send_snoop_req(); 
-          stalls--; 
-      }
-  }
+int CacheSim::run() {
+  return this->simulate(nullptr);
 }
 
-void CacheSim::clear_req(){
-  cache_->core_req_valid = 0; 
+int CacheSim::run(const BenchConfig& config) {
+  this->reset();
+  this->fill_ram(config.base, config.footprint);
+  max_pending_ = config.max_pending ? std::min<uint32_t>(config.max_pending, NUM_TAGS) : NUM_TAGS;
+  rand_ = config.seed ? config.seed : 1;
+  return this->simulate(&config);
 }
 
+int CacheSim::simulate(const BenchConfig* config) {
+  uint32_t generated = 0;
+  for (;;) {
+    // keep the request queue fed without building the whole stream
+    while (config
+        && generated < config->requests
+        && core_req_vec_.size() < 2) {
+      core_req_t req;
+      this->generate(*config, generated++, &req);
+      this->send_req(req);
+    }
 
-void CacheSim::send_req(core_req_t *req){
-  core_req_vec_.push(req);
-  unsigned int *data = new unsigned int[4];
-  core_rsp_vec_.insert(std::pair<unsigned int, unsigned int*>(req->tag, data));
+    this->step();
+
+    if (this->idle()) {
+      if (cycle_ - last_active_ >= IDLE_CYCLES)
+        break;
+    } else if (cycle_ - last_active_ >= STALL_CYCLES) {
+      std::cout << "*** error: cache stalled at cycle " << std::dec << cycle_
+                << ", pending loads=" << (NUM_TAGS - free_tags_.size())
+                << ", pending fills=" << (mem_rsp_vec_.size() + mem_rsp_active_) << std::endl;
+      stats_.cycles = last_active_ - start_cycle_;
+      return -1;
+    }
+  }
+  stats_.cycles = last_active_ - start_cycle_;
+  return stats_.errors ? -1 : 0;
 }
 
-bool CacheSim::get_core_req_ready(){
-  return cache_->core_req_ready; 
+bool CacheSim::idle() const {
+  return core_req_vec_.empty()
+      && free_tags_.size() == NUM_TAGS
+      && mem_rsp_vec_.empty()
+      && !mem_rsp_active_
+      && !cache_->mem_req_valid;
 }
 
-bool CacheSim::get_core_rsp_ready(){
-  return cache_->core_rsp_ready; 
+uint32_t CacheSim::word_value(uint32_t addr) {
+  uint32_t x = (addr >> 2) * 0x9e3779b1;
+  return x ^ (x >> 15);
 }
 
-void CacheSim::eval_reqs(){
-  //check to see if cache is accepting reqs
-  if(!core_req_vec_.empty() && cache_->core_req_ready){
-    core_req_t *req = core_req_vec_.front();
+void CacheSim::fill_ram(uint32_t addr, uint32_t size) {
+  for (uint32_t a = addr & ~3u; a < addr + size; a += 4) {
+    uint32_t value = word_value(a);
+    ram_->write(a, 4, (const uint8_t*)&value);
+  }
+}
 
-    cache_->core_req_valid = req->valid;
-    cache_->core_req_rw = req->rw; 
-    cache_->core_req_byteen = req->byteen;
+uint32_t CacheSim::expected(uint32_t addr) const {
+  auto it = shadow_.find(addr >> 2);
+  if (it != shadow_.end())
+    return it->second;
+  return word_value(addr);
+}
 
-    cache_->core_req_addr[0] = req->addr[0];
-    cache_->core_req_addr[1] = req->addr[1];
-    cache_->core_req_addr[2] = req->addr[2];
-    cache_->core_req_addr[3] = req->addr[3];
+bool CacheSim::line_pending(const core_req_t& req) const {
+  for (auto& entry : pending_) {
+    for (uint32_t i = 0; i < NUM_REQS; ++i) {
+      if (0 == ((entry.tmask >> i) & 1))
+        continue;
+      for (uint32_t j = 0; j < NUM_REQS; ++j) {
+        if (((req.tmask >> j) & 1)
+         && (req.addr[j] >> LINE_BITS) == (entry.addr[i] >> LINE_BITS))
+          return true;
+      }
+    }
+  }
+  return false;
+}
 
-    cache_->core_req_data[0] = req->data[0];
-    cache_->core_req_data[1] = req->data[1];
-    cache_->core_req_data[2] = req->data[2];
-    cache_->core_req_data[3] = req->data[3];
+uint32_t CacheSim::random() {
+  // xorshift64*
+  rand_ ^= rand_ >> 12;
+  rand_ ^= rand_ << 25;
+  rand_ ^= rand_ >> 27;
+  return uint32_t((rand_ * 0x2545F4914F6CDD1Dull) >> 32);
+}
 
-    cache_->core_req_tag = req->tag; 
+void CacheSim::generate(const BenchConfig& config, uint32_t index, core_req_t* req) {
+  uint32_t words = std::max<uint32_t>(config.footprint / 4, 1);
+  uint32_t bank_lines = std::max<uint32_t>(config.footprint / CACHE_LINE_SIZE / NUM_BANKS, 1);
+  uint32_t bank = this->random() % NUM_BANKS;
 
-    core_req_vec_.pop();
-   
-  } else {
-    clear_req();
+  req->rw = (this->random() % 100) < config.write_ratio;
+  req->tmask = 0;
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    if ((this->random() % 100) < config.lane_ratio) {
+      req->tmask |= (1u << i);
+    }
   }
-}
-
-void CacheSim::eval_rsps(){
-  //check to see if a request has been responded to
-  if (cache_->core_rsp_valid){
-      core_rsp_vec_.at(cache_->core_rsp_tag)[0] = cache_->core_rsp_data[0];
-      core_rsp_vec_.at(cache_->core_rsp_tag)[1] = cache_->core_rsp_data[1];
-      core_rsp_vec_.at(cache_->core_rsp_tag)[2] = cache_->core_rsp_data[2];
-      core_rsp_vec_.at(cache_->core_rsp_tag)[3] = cache_->core_rsp_data[3];
+  if (0 == req->tmask) {
+    req->tmask = 1u << (this->random() % NUM_REQS);
   }
-}
 
-void CacheSim::stall_mem(){
-  cache_->mem_req_ready = 0;
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    uint64_t lane = uint64_t(index) * NUM_REQS + i;
+    uint32_t offset;
+    switch (config.pattern) {
+    default:
+    case PATTERN_SEQ:
+      offset = (lane % words) * 4;
+      break;
+    case PATTERN_STRIDE:
+      offset = uint32_t((lane * config.stride) % (words * 4)) & ~3u;
+      break;
+    case PATTERN_RANDOM:
+      offset = (this->random() % words) * 4;
+      break;
+    case PATTERN_CONFLICT:
+      offset = uint32_t(((lane % bank_lines) * NUM_BANKS + bank) * CACHE_LINE_SIZE)
+             + (this->random() % (CACHE_LINE_SIZE / 4)) * 4;
+      break;
+    }
+    req->addr[i] = config.base + offset;
+    if (req->rw) {
+      // stores write fresh data, recorded in shadow_ when accepted; lanes
+      // of a request that hit the same word write the same bytes so the
+      // result does not depend on the order the cache applies them in
+      req->byteen[i] = this->random() & 0xf;
+      if (0 == req->byteen[i]) {
+        req->byteen[i] = 0xf;
+      }
+      req->data[i] = this->random();
+      for (uint32_t j = 0; j < i; ++j) {
+        if ((req->addr[j] >> 2) == (req->addr[i] >> 2)) {
+          req->byteen[i] = req->byteen[j];
+          req->data[i] = req->data[j];
+          break;
+        }
+      }
+    } else {
+      req->byteen[i] = 0xf;
+      req->data[i] = 0;
+    }
+  }
 }
 
-void CacheSim::send_snoop_req(){
-    /*cache_->snp_req_valid = 1;
-    cache_->snp_req_addr = 0x12222222;
-    cache_->snp_req_invalidate = 1; 
-    cache_->snp_req_tag = 0xff; */
-}
+void CacheSim::eval_reqs() {
+  stats_.loads += NUM_TAGS - free_tags_.size();
 
-void CacheSim::eval_mem_bus() {
-  if (ram_ == nullptr) {
-    cache_->mem_req_ready = 0;
+  if (0 == core_req_lanes_)
     return;
+
+  auto& req = core_req_vec_.front();
+  uint32_t fire = core_req_lanes_ & get_bits(cache_->core_req_ready, 0, NUM_REQS);
+  if (fire != core_req_lanes_) {
+    ++stats_.stalls;
   }
+  if (0 == fire)
+    return;
 
-  // schedule memory responses
-  int dequeue_index = -1;
-  for (int i = 0; i < mem_rsp_vec_.size(); i++) {
-    if (mem_rsp_vec_[i].cycles_left > 0) {
-      mem_rsp_vec_[i].cycles_left -= 1;
-    }
-    if ((dequeue_index == -1) 
-     && (mem_rsp_vec_[i].cycles_left == 0)) {
-      dequeue_index = i;
+  last_active_ = cycle_;
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    if (0 == ((fire >> i) & 1))
+      continue;
+    uint32_t addr = req.addr[i];
+    if (req.rw) {
+      uint32_t value = this->expected(addr);
+      for (uint32_t b = 0; b < 4; ++b) {
+        if ((req.byteen[i] >> b) & 1) {
+          uint32_t mask = 0xffu << (b * 8);
+          value = (value & ~mask) | (req.data[i] & mask);
+        }
+      }
+      shadow_[addr >> 2] = value;
+      ++stats_.writes;
+    } else {
+      auto& entry = pending_[core_req_tag_];
+      entry.tmask |= (1u << i);
+      entry.addr[i] = addr;
+      entry.expected[i] = this->expected(addr);
+      entry.cycle[i] = cycle_;
+      ++stats_.reads;
     }
   }
 
-  // send memory response  
-  if (mem_rsp_active_
-   && cache_->mem_rsp_valid 
-   && cache_->mem_rsp_ready) {
-    mem_rsp_active_ = false;
+  core_req_lanes_ &= ~fire;
+  if (0 == core_req_lanes_) {
+    if (core_req_tag_ != -1
+     && 0 == pending_[core_req_tag_].tmask) {
+      free_tags_.push_back(core_req_tag_);
+    }
+    core_req_tag_ = -1;
+    core_req_vec_.pop();
+    ++stats_.requests;
   }
-  if (!mem_rsp_active_) {
-    if (dequeue_index != -1) { //time to respond to the request
-      cache_->mem_rsp_valid = 1;
+}
+
+void CacheSim::eval_rsps() {
+  if (0 == (cache_->core_rsp_valid & 1))
+    return;
 
-      //copy data from the rsp queue to the cache module
-      memcpy((uint8_t*)cache_->mem_rsp_data, mem_rsp_vec_[dequeue_index].data, MEM_BLOCK_SIZE);
+  last_active_ = cycle_;
 
-      cache_->mem_rsp_tag = mem_rsp_vec_[dequeue_index].tag;    
-      free(mem_rsp_vec_[dequeue_index].data); //take data out of the queue
-      mem_rsp_vec_.erase(mem_rsp_vec_.begin() + dequeue_index);
-      mem_rsp_active_ = true;
+  uint32_t tag = get_bits(cache_->core_rsp_tag, 0, CORE_TAG_WIDTH);
+  uint32_t tmask = get_bits(cache_->core_rsp_tmask, 0, NUM_REQS);
+  auto& entry = pending_[tag];
+  if (tmask & ~entry.tmask) {
+    if (stats_.errors++ < MAX_ERRORS) {
+      std::cout << "*** error: unexpected response: tag=" << std::dec << tag
+                << ", tmask=" << std::hex << tmask << std::dec << std::endl;
+    }
+    tmask &= entry.tmask;
+  }
+
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    if (0 == ((tmask >> i) & 1))
+      continue;
+    uint32_t data = get_bits(cache_->core_rsp_data, i * 32, 32);
+    if (data != entry.expected[i]) {
+      if (stats_.errors++ < MAX_ERRORS) {
+        std::cout << "*** error: load mismatch: addr=" << std::hex << entry.addr[i]
+                  << ", expected=" << entry.expected[i] << ", actual=" << data << std::dec << std::endl;
+      }
+    }
+    // a load that was waiting for a fill of its line missed
+    uint64_t latency = cycle_ - entry.cycle[i];
+    auto it = fill_cycle_.find(entry.addr[i] >> LINE_BITS);
+    if (it != fill_cycle_.end() && it->second >= entry.cycle[i]) {
+      stats_.miss_latency.add(latency);
     } else {
-      cache_->mem_rsp_valid = 0;
+      stats_.hit_latency.add(latency);
     }
   }
 
-  // handle memory stalls
-  bool mem_stalled = false;
-#ifdef ENABLE_MEM_STALLS
-  if (0 == ((timestamp/2) % MEM_STALLS_MODULO)) { 
-    mem_stalled = true;
-  } else
-  if (mem_rsp_vec_.size() >= MEM_RQ_SIZE) {
-    mem_stalled = true;
+  entry.tmask &= ~tmask;
+  if (0 == entry.tmask && int(tag) != core_req_tag_) {
+    free_tags_.push_back(tag);
   }
-#endif
+}
 
-  // process memory requests
-  if (!mem_stalled) {
-    if (cache_->mem_req_valid) {
-      if (cache_->mem_req_rw) { //write = 1
-        uint64_t byteen = cache_->mem_req_byteen;
-        unsigned base_addr = (cache_->mem_req_addr * MEM_BLOCK_SIZE);
-        uint8_t* data = (uint8_t*)(cache_->mem_req_data);
-        for (int i = 0; i < MEM_BLOCK_SIZE; i++) {
-          if ((byteen >> i) & 0x1) {            
-            (*ram_)[base_addr + i] = data[i];
-          }
+void CacheSim::eval_mem_bus() {
+  // memory response
+  if (mem_rsp_active_ && cache_->mem_rsp_ready) {
+    uint32_t line = mem_rsp_addr_ >> LINE_BITS;
+    fill_cycle_[line] = cycle_;
+    --bank_fills_[line % NUM_BANKS];
+    mem_rsp_active_ = false;
+    last_active_ = cycle_;
+  }
+
+  // memory request
+  if (ram_ && cache_->mem_req_valid && cache_->mem_req_ready) {
+    uint32_t addr = uint32_t(cache_->mem_req_addr) << LINE_BITS;
+    if (cache_->mem_req_rw) {
+      for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i) {
+        if (get_bits(cache_->mem_req_byteen, i, 1)) {
+          (*ram_)[addr + i] = get_bits(cache_->mem_req_data, i * 8, 8);
         }
-      } else {
-        mem_req_t mem_req;
-        mem_req.cycles_left = MEM_LATENCY;     
-        mem_req.data = (uint8_t*)malloc(MEM_BLOCK_SIZE);
-        mem_req.tag = cache_->mem_req_tag;
-        ram_->read(cache_->mem_req_addr * MEM_BLOCK_SIZE, MEM_BLOCK_SIZE, mem_req.data);
-        mem_rsp_vec_.push_back(mem_req);
-      } 
-    }    
-  }
-
-  cache_->mem_req_ready = ~mem_stalled;
-}
-
-bool CacheSim::assert_equal(unsigned int* data, unsigned int tag){
-  int check = 0;
-  unsigned int *rsp = core_rsp_vec_.at(tag);
-  for (int i = 0; i < 4; ++i){
-    for (int j = 0; j < 4; ++j){
-      if (data[i] == rsp[j]){
-        check++;
       }
+      dram_.access(addr, true, cycle_);
+      ++stats_.mem_writes;
+    } else {
+      mem_rsp_t rsp;
+      rsp.ready = dram_.access(addr, false, cycle_);
+      rsp.addr  = addr;
+      rsp.tag   = cache_->mem_req_tag;
+      ram_->read(addr, CACHE_LINE_SIZE, rsp.data);
+      mem_rsp_vec_.push_back(rsp);
+      ++bank_fills_[(addr >> LINE_BITS) % NUM_BANKS];
+      ++stats_.mem_reads;
     }
+    last_active_ = cycle_;
   }
 
-  return check; 
-
+  // MSHR occupancy, counted as fills in flight per bank
+  uint64_t fills = 0;
+  bool full = false;
+  for (auto bank_fills : bank_fills_) {
+    fills += bank_fills;
+    full |= (bank_fills >= MSHR_SIZE);
+  }
+  stats_.fills += fills;
+  stats_.fills_max = std::max(stats_.fills_max, fills);
+  stats_.mshr_full += full;
 }
 
-//DEBUG
+void CacheSim::drive_reqs() {
+  // start the next request, loads wait for a free tag
+  while (0 == core_req_lanes_ && !core_req_vec_.empty()) {
+    auto& req = core_req_vec_.front();
+    if (0 == req.tmask) {
+      core_req_vec_.pop();
+      continue;
+    }
+    if (req.rw) {
+      // a store missing on a line with a fill in flight is not merged into
+      // the fill, so stores wait for the pending loads of their lines
+      if (this->line_pending(req))
+        break;
+    } else {
+      if (free_tags_.empty()
+       || (NUM_TAGS - free_tags_.size()) >= max_pending_)
+        break;
+      core_req_tag_ = free_tags_.back();
+      free_tags_.pop_back();
+      pending_[core_req_tag_].tmask = 0;
+    }
+    core_req_lanes_ = req.tmask;
+  }
 
-void CacheSim::display_miss(){
-  //int i = (unsigned int)cache_->miss_vec; 
-  //std::bitset<8> x(i); 
-  //if (i) std::cout << "Miss Vec " << x << std::endl;
-  //std::cout << "Miss Vec 0" << cache_->miss_vec[0] << std::endl;
+  uint32_t lanes = core_req_lanes_;
+  uint32_t rw = 0;
+  if (lanes) {
+    auto& req = core_req_vec_.front();
+    uint32_t tag = (core_req_tag_ != -1) ? core_req_tag_ : 0;
+    for (uint32_t i = 0; i < NUM_REQS; ++i) {
+      set_bits(cache_->core_req_addr, i * WORD_ADDR_WIDTH, WORD_ADDR_WIDTH, req.addr[i] >> 2);
+      set_bits(cache_->core_req_byteen, i * 4, 4, req.byteen[i]);
+      set_bits(cache_->core_req_data, i * 32, 32, req.data[i]);
+      set_bits(cache_->core_req_tag, i * CORE_TAG_WIDTH, CORE_TAG_WIDTH, tag);
+    }
+    rw = req.rw ? lanes : 0;
+  }
+  set_bits(cache_->core_req_valid, 0, NUM_REQS, lanes);
+  set_bits(cache_->core_req_rw, 0, NUM_REQS, rw);
+  cache_->core_rsp_ready = 1;
 }
 
-void CacheSim::get_core_req(unsigned int (&rsp)[4]){
-  rsp[0] = cache_->core_rsp_data[0];
-  rsp[1] = cache_->core_rsp_data[1];
-  rsp[2] = cache_->core_rsp_data[2];
-  rsp[3] = cache_->core_rsp_data[3];
-
-  //std::cout << std::hex << "core_rsp_valid: " << cache_->core_rsp_valid << std::endl;
-  //std::cout << std::hex << "core_rsp_data: " << cache_->core_rsp_data << std::endl;
-  //std::cout << std::hex << "core_rsp_tag: " << cache_->core_rsp_tag << std::endl; 
-}
+void CacheSim::drive_mem_bus() {
+  if (nullptr == ram_) {
+    cache_->mem_req_ready = 0;
+    cache_->mem_rsp_valid = 0;
+    return;
+  }
 
-void CacheSim::get_core_rsp(){
-  //std::cout << cache_->genblk5_BRA_0_KET_->bank->is_fill_in_pipe<< std::endl; 
-  char check = cache_->core_rsp_valid;
-  std::cout << std::hex << "core_rsp_valid: " << (unsigned int) check << std::endl;
-  std::cout << std::hex << "core_rsp_data[0]: " << cache_->core_rsp_data[0] << std::endl;
-  std::cout << std::hex << "core_rsp_data[1]: " << cache_->core_rsp_data[1] << std::endl;
-  std::cout << std::hex << "core_rsp_data[2]: " << cache_->core_rsp_data[2] << std::endl;
-  std::cout << std::hex << "core_rsp_data[3]: " << cache_->core_rsp_data[3] << std::endl;
-  std::cout << std::hex << "core_rsp_tag: " << cache_->core_rsp_tag << std::endl; 
-}
+  // send the first ready memory response
+  if (!mem_rsp_active_) {
+    auto it = std::find_if(mem_rsp_vec_.begin(), mem_rsp_vec_.end(),
+      [&](const mem_rsp_t& rsp) { return rsp.ready <= cycle_; });
+    if (it != mem_rsp_vec_.end()) {
+      for (uint32_t i = 0; i < CACHE_LINE_SIZE; ++i) {
+        set_bits(cache_->mem_rsp_data, i * 8, 8, it->data[i]);
+      }
+      cache_->mem_rsp_tag = it->tag;
+      cache_->mem_rsp_valid = 1;
+      mem_rsp_addr_ = it->addr;
+      mem_rsp_vec_.erase(it);
+      mem_rsp_active_ = true;
+    } else {
+      cache_->mem_rsp_valid = 0;
+    }
+  }
 
-void CacheSim::get_mem_req(){
-  std::cout << std::hex << "mem_req_valid: " << cache_->mem_req_valid << std::endl;
-  std::cout << std::hex << "mem_req_rw: " << cache_->mem_req_rw << std::endl;
-  std::cout << std::hex << "mem_req_byteen: " << cache_->mem_req_byteen << std::endl;
-  std::cout << std::hex << "mem_req_addr: " << cache_->mem_req_addr << std::endl;
-  std::cout << std::hex << "mem_req_data: " << cache_->mem_req_data << std::endl; 
-  std::cout << std::hex << "mem_req_tag: " << cache_->mem_req_tag << std::endl;
+  // handle memory stalls
+  uint32_t req_addr = uint32_t(cache_->mem_req_addr) << LINE_BITS;
+  bool mem_stalled = (mem_rsp_vec_.size() >= MEM_RQ_SIZE)
+                  || !dram_.ready(req_addr, cycle_);
+  cache_->mem_req_ready = !mem_stalled;
 }
 
-void CacheSim::get_mem_rsp(){
-  std::cout << std::hex << "mem_rsp_valid: " << cache_->mem_rsp_valid << std::endl;
-  std::cout << std::hex << "mem_rsp_data: " << cache_->mem_rsp_data << std::endl; 
-  std::cout << std::hex << "mem_rsp_tag: " << cache_->mem_rsp_tag << std::endl;
-  std::cout << std::hex << "mem_rsp_ready: " << cache_->mem_rsp_ready << std::endl;
+void CacheSim::print_stats(std::ostream& out) const {
+  uint64_t cycles = std::max<uint64_t>(stats_.cycles, 1);
+  uint64_t loads = stats_.hit_latency.count() + stats_.miss_latency.count();
+  out << std::left << std::fixed << std::setprecision(2);
+  out << std::setw(28) << "# of requests:" << std::dec << stats_.requests << std::endl;
+  out << std::setw(28) << "# of loads/stores:" << stats_.reads << "/" << stats_.writes << std::endl;
+  out << std::setw(28) << "# of cycles:" << stats_.cycles << std::endl;
+  out << std::setw(28) << "requests per cycle:" << (double(stats_.requests) / cycles) << std::endl;
+  out << std::setw(28) << "words per cycle:" << (double(stats_.reads + stats_.writes) / cycles) << std::endl;
+  out << std::setw(28) << "# of request stalls:" << stats_.stalls << std::endl;
+  out << std::setw(28) << "# of memory reads/writes:" << stats_.mem_reads << "/" << stats_.mem_writes << std::endl;
+  out << std::setw(28) << "load hit rate:" << (loads ? (stats_.hit_latency.count() * 100.0 / loads) : 0.0) << "%" << std::endl;
+  out << std::setw(28) << "average pending loads:" << (double(stats_.loads) / cycles) << std::endl;
+  out << std::setw(28) << "average MSHR occupancy:" << (double(stats_.fills) / cycles) << std::endl;
+  out << std::setw(28) << "max MSHR occupancy:" << stats_.fills_max << std::endl;
+  out << std::setw(28) << "# of MSHR full cycles:" << stats_.mshr_full << std::endl;
+  stats_.hit_latency.print(out, "hit");
+  stats_.miss_latency.print(out, "miss");
+  if (stats_.errors) {
+    out << std::setw(28) << "# of load errors:" << stats_.errors << std::endl;
+  }
 }
-
@@ -1,92 +1,223 @@
 #pragma once
 
 #include "VVX_cache.h"
-#include "VVX_cache__Syms.h"
 #include "verilated.h"
 
-//#ifdef VCD_OUTPUT
+#ifdef VM_TRACE
 #include <verilated_vcd_c.h>
-//#endif
+#endif
 
-//#include <VX_config.h>
 #include "ram.h"
+#include <dram.h>
 #include <ostream>
 #include <vector>
 #include <queue>
+#include <unordered_map>
+
+// cache parameters, the Makefile passes the same values to the RTL
+#ifndef NUM_REQS
+#define NUM_REQS 4
+#endif
+#ifndef CACHE_SIZE
+#define CACHE_SIZE 4096
+#endif
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 16
+#endif
+#ifndef NUM_BANKS
+#define NUM_BANKS 4
+#endif
+#ifndef WORD_SIZE
+#define WORD_SIZE 4
+#endif
+#ifndef MSHR_SIZE
+#define MSHR_SIZE 8
+#endif
+#ifndef CORE_TAG_WIDTH
+#define CORE_TAG_WIDTH 8
+#endif
 
-#define ENABLE_MEM_STALLS
-#define MEM_LATENCY 100
 #define MEM_RQ_SIZE 16
-#define MEM_STALLS_MODULO 16
-#define MEM_BLOCK_SIZE 16
-
-typedef struct {
-  int cycles_left;
-  uint8_t *data;
-  unsigned tag;
-} mem_req_t;
-
-typedef struct {
-  char valid;
-  char rw; 
-  unsigned byteen;
-  unsigned *addr;
-  unsigned *data;
-  unsigned int tag;
-} core_req_t;
+
+// one request per lane, all lanes share the same tag like a warp access
+struct core_req_t {
+  bool     rw;
+  uint32_t tmask;
+  uint32_t addr[NUM_REQS];    // byte address
+  uint32_t byteen[NUM_REQS];
+  uint32_t data[NUM_REQS];
+};
+
+enum pattern_t {
+  PATTERN_SEQ,        // consecutive words
+  PATTERN_STRIDE,     // fixed stride between lanes
+  PATTERN_RANDOM,     // uniform over the footprint
+  PATTERN_CONFLICT,   // all lanes in one bank, different lines
+};
+
+struct BenchConfig {
+  pattern_t pattern;
+  uint32_t  requests;     // warp requests to issue
+  uint32_t  base;         // first byte address
+  uint32_t  footprint;    // bytes covered by the generator
+  uint32_t  stride;       // PATTERN_STRIDE lane stride in bytes
+  uint32_t  write_ratio;  // percent of stores
+  uint32_t  lane_ratio;   // percent of active lanes
+  uint32_t  max_pending;  // outstanding loads, 0 uses every tag
+  uint32_t  seed;
+
+  BenchConfig();
+
+  // "seq", "stride", "random" or "conflict"
+  int set_pattern(const char* name);
+
+  const char* pattern_name() const;
+};
+
+// latencies in cycles, exact up to MAX_LATENCY
+class LatencyHist {
+public:
+  enum { MAX_LATENCY = 4096 };
+
+  LatencyHist();
+
+  void clear();
+
+  void add(uint64_t latency);
+
+  uint64_t count() const {
+    return count_;
+  }
+
+  // latency at the given percentile
+  uint64_t percentile(uint32_t p) const;
+
+  void print(std::ostream& out, const char* name) const;
+
+private:
+  std::vector<uint64_t> bins_;
+  uint64_t count_;
+  uint64_t total_;
+  uint64_t min_;
+  uint64_t max_;
+};
+
+struct CacheStats {
+  uint64_t cycles;        // first request to last response
+  uint64_t requests;      // warp requests
+  uint64_t reads;         // lane loads
+  uint64_t writes;        // lane stores
+  uint64_t stalls;        // cycles with a lane not accepted
+  uint64_t errors;        // wrong load data
+  uint64_t mem_reads;
+  uint64_t mem_writes;
+  uint64_t fills;         // sum of in-flight fills per cycle
+  uint64_t fills_max;
+  uint64_t mshr_full;     // cycles with MSHR_SIZE fills in flight on a bank
+  uint64_t loads;         // sum of outstanding load requests per cycle
+  LatencyHist hit_latency;
+  LatencyHist miss_latency;
+
+  CacheStats();
+  void clear();
+};
 
 class CacheSim {
 public:
-  
+
   CacheSim();
   virtual ~CacheSim();
-  
-  bool busy();  
+
+  void attach_ram(RAM* ram);
 
   void reset();
+
   void step();
-  void wait(uint32_t cycles); 
-  void attach_ram(RAM* ram);
-  void run();  //run until all reqs are empty
- 
-  //req/rsp
-  void send_req(core_req_t *req);
-  void clear_req(); 
-  void stall_mem();
-  void send_snoop_req();
-  void send_snp_fwd_in(); 
-
-  //assert funcs
-  bool assert_equal(unsigned int* data, unsigned int tag);
-
-  //debug funcs
-  void get_mem_req();
-  void get_core_req(unsigned int (&rsp)[4]);
-  void get_core_rsp();
-  bool get_core_req_ready();
-  bool get_core_rsp_ready();
-  void get_mem_rsp();
-  void display_miss();
-
-private:  
-
-  void eval();  
-  void eval_reqs(); 
+
+  // queue a request, stores update the expected load values and loads
+  // expect word_value() elsewhere, see fill_ram()
+  void send_req(const core_req_t& req);
+
+  // step until the queued requests have completed, returns -1 on a
+  // load data error or a stalled cache
+  int run();
+
+  // reset, then issue config.requests generated requests
+  int run(const BenchConfig& config);
+
+  // initialize memory with word_value()
+  void fill_ram(uint32_t addr, uint32_t size);
+
+  // initial memory contents
+  static uint32_t word_value(uint32_t addr);
+
+  const CacheStats& stats() const {
+    return stats_;
+  }
+
+  void print_stats(std::ostream& out) const;
+
+private:
+
+  struct pending_t {
+    uint32_t tmask;       // lanes waiting for a response
+    uint32_t addr[NUM_REQS];
+    uint32_t expected[NUM_REQS];
+    uint64_t cycle[NUM_REQS];
+  };
+
+  struct mem_rsp_t {
+    uint64_t ready;
+    uint32_t addr;
+    uint32_t tag;
+    uint8_t  data[CACHE_LINE_SIZE];
+  };
+
+  void eval();
+  void eval_reqs();
   void eval_rsps();
   void eval_mem_bus();
-  
-  std::queue<core_req_t*> core_req_vec_; 
-  std::vector<mem_req_t> mem_rsp_vec_;
-  std::map<unsigned int, unsigned int*> core_rsp_vec_;
-  int mem_rsp_active_;
+  void drive_reqs();
+  void drive_mem_bus();
+
+  bool idle() const;
+
+  int simulate(const BenchConfig* config);
+
+  void generate(const BenchConfig& config, uint32_t index, core_req_t* req);
+
+  uint32_t random();
+
+  uint32_t expected(uint32_t addr) const;
+
+  // true if a pending load targets a line the request touches
+  bool line_pending(const core_req_t& req) const;
+
+  std::queue<core_req_t> core_req_vec_;
+  uint32_t core_req_lanes_;     // lanes of the head request not yet accepted
+  int      core_req_tag_;       // tag of the head request, -1 if none
+  std::vector<pending_t> pending_;
+  std::vector<uint32_t> free_tags_;
+  uint32_t max_pending_;
+
+  std::vector<mem_rsp_t> mem_rsp_vec_;
+  bool     mem_rsp_active_;
+  uint32_t mem_rsp_addr_;
+  uint32_t bank_fills_[NUM_BANKS];
+
+  std::unordered_map<uint32_t, uint32_t> shadow_;     // stored words
+  std::unordered_map<uint32_t, uint64_t> fill_cycle_; // last fill per line
 
-  uint32_t snp_req_active_;
-  uint32_t snp_req_size_;
-  uint32_t pending_snp_reqs_;
+  uint64_t cycle_;
+  uint64_t start_cycle_;
+  uint64_t last_active_;
+  uint64_t rand_;
+  CacheStats stats_;
 
   VVX_cache *cache_;
   RAM *ram_;
-//#ifdef VCD_OUTPUT
+  vortex::DramSim dram_;
+#ifdef VM_TRACE
   VerilatedVcdC *trace_;
-//#endif
+#endif
 };
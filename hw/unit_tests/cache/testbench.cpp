@@ -2,234 +2,138 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <unistd.h>
+
+static const uint32_t test_addrs[4] = {0x12222220, 0xabbbbbb8, 0xcdddddd0, 0xe4444444};
+
+static core_req_t make_req(bool rw, const uint32_t* addr, const uint32_t* data) {
+  core_req_t req;
+  req.rw = rw;
+  req.tmask = (1u << NUM_REQS) - 1;
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    req.addr[i]   = addr[i % 4] + (i / 4) * CACHE_LINE_SIZE;
+    req.byteen[i] = 0xf;
+    req.data[i]   = data ? data[i % 4] : 0;
+  }
+  return req;
+}
 
-#define VCD_OUTPUT 1
-
-
-int REQ_RSP(CacheSim *sim){ //verified
-  unsigned int addr[4] = {0x12222222, 0xabbbbbbb, 0xcddddddd, 0xe4444444};
-  unsigned int data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
-  unsigned int rsp[4] = {0,0,0,0};
-  char responded = 0;
-  //write req
-  core_req_t* write = new core_req_t;
-  write->valid = 0xf;
-  write->rw = 0xf;
-  write->byteen = 0xffff;
-  write->addr = addr; 
-  write->data = data;
-  write->tag = 0xff;
-
-  //read req
-  core_req_t* read = new core_req_t;
-  read->valid = 0xf;
-  read->rw = 0;
-  read->byteen = 0xffff;
-  read->addr = addr;
-  read->data = addr; 
-  read->tag = 0xff;
-  
-  // reset the device
-  sim->reset();
-
-  //queue reqs
-  sim->send_req(write);
-  sim->send_req(read);
-
-  sim->run();
-
-  int check = sim->assert_equal(data, write->tag);
-  
-  if (check == 4) return 1; 
+static void fill_lines(CacheSim* sim, const core_req_t& req) {
+  for (uint32_t i = 0; i < NUM_REQS; ++i) {
+    sim->fill_ram(req.addr[i] & ~(CACHE_LINE_SIZE - 1), CACHE_LINE_SIZE);
+  }
 }
 
-int HIT_1(CacheSim *sim){
-  unsigned int addr[4] = {0x12222222, 0xabbbbbbb, 0xcddddddd, 0xe4444444};
-  unsigned int data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
-  unsigned int rsp[4] = {0,0,0,0};
-  char responded = 0;
-  //write req
-  core_req_t* write = new core_req_t;
-  write->valid = 0xf;
-  write->rw = 0xf;
-  write->byteen = 0xffff;
-  write->addr = addr; 
-  write->data = data;
-  write->tag = 0x11;
-
-  //read req
-  core_req_t* read = new core_req_t;
-  read->valid = 0xf;
-  read->rw = 0;
-  read->byteen = 0xffff;
-  read->addr = addr;
-  read->data = addr; 
-  read->tag = 0x22;
-  
-  // reset the device
+// stores followed by loads of the same words
+int REQ_RSP(CacheSim *sim) {
+  uint32_t data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
+  auto write = make_req(true, test_addrs, data);
+  auto read = make_req(false, test_addrs, nullptr);
+
   sim->reset();
+  fill_lines(sim, read);
 
-  //queue reqs
   sim->send_req(write);
   sim->send_req(read);
+  if (sim->run())
+    return -1;
 
-  sim->run();
-
-  bool check = sim->assert_equal(data, write->tag);
-  
-  return check;
+  return (sim->stats().hit_latency.count() + sim->stats().miss_latency.count() == NUM_REQS) ? 0 : -1;
 }
 
-int MISS_1(CacheSim *sim){
-  unsigned int addr1[4] = {0x12222222, 0xabbbbbbb, 0xcddddddd, 0xe4444444};
-  unsigned int addr2[4] = {0x12229222, 0xabbbb4bb, 0xcddd47dd, 0xe4423544};
-  unsigned int addr3[4] = {0x12223332, 0xabb454bb, 0xcdddeefd, 0xe4447744};
-  unsigned int data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
-  unsigned int rsp[4] = {0,0,0,0};
-  char responded = 0;
-  //write req
-  core_req_t* write = new core_req_t;
-  write->valid = 0xf;
-  write->rw = 0xf;
-  write->byteen = 0xffff;
-  write->addr = addr1; 
-  write->data = data;
-  write->tag = 0xff;
-
-  //read req
-  core_req_t* read1 = new core_req_t;
-  read1->valid = 0xf;
-  read1->rw = 0;
-  read1->byteen = 0xffff;
-  read1->addr = addr1;
-  read1->data = data; 
-  read1->tag = 0xff;
-
-  core_req_t* read2 = new core_req_t;
-  read2->valid = 0xf;
-  read2->rw = 0;
-  read2->byteen = 0xffff;
-  read2->addr = addr2;
-  read2->data = data; 
-  read2->tag = 0xff;
-  
-  core_req_t* read3 = new core_req_t;
-  read3->valid = 0xf;
-  read3->rw = 0;
-  read3->byteen = 0xffff;
-  read3->addr = addr3;
-  read3->data = data; 
-  read3->tag = 0xff;
-  
-  // reset the device
-  sim->reset();
-
-  //queue reqs
-  sim->send_req(write);
-  sim->send_req(read1);
-  sim->send_req(read2);
-  sim->send_req(read3);
-
-  sim->run();
+// loading the same lines twice, the second load hits
+int HIT_1(CacheSim *sim) {
+  auto read = make_req(false, test_addrs, nullptr);
 
-  bool check = sim->assert_equal(data, write->tag);
-  
-  return check;
-}
-int FLUSH(CacheSim *sim){
-  unsigned int addr[4] = {0x12222222, 0xabbbbbbb, 0xcddddddd, 0xe4444444};
-  unsigned int data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
-  unsigned int rsp[4] = {0,0,0,0};
-  char responded = 0;
-  //write req
-  core_req_t* write = new core_req_t;
-  write->valid = 0xf;
-  write->rw = 0xf;
-  write->byteen = 0xffff;
-  write->addr = addr; 
-  write->data = data;
-  write->tag = 0xff;
-
-  //read req
-  core_req_t* read = new core_req_t;
-  read->valid = 0xf;
-  read->rw = 0;
-  read->byteen = 0xffff;
-  read->addr = addr;
-  read->data = addr; 
-  read->tag = 0xff;
-  
-  // reset the device
   sim->reset();
+  fill_lines(sim, read);
 
-  //queue reqs
-  sim->send_req(write);
   sim->send_req(read);
+  if (sim->run())
+    return -1;
+  auto hits = sim->stats().hit_latency.count();
 
-  sim->run();
+  sim->send_req(read);
+  if (sim->run())
+    return -1;
 
-  bool check = sim->assert_equal(data, write->tag);
-  
-  return check;
+  return (sim->stats().hit_latency.count() - hits == NUM_REQS) ? 0 : -1;
 }
 
-
-int BACK_PRESSURE(CacheSim *sim){
-  //happens whenever the core is stalled or memory is stalled
-  unsigned int addr[4] = {0x12222222, 0xabbbbbbb, 0xcddddddd, 0xe4444444};
-  unsigned int data[4] = {0xffffffff, 0x11111111, 0x22222222, 0x33333333};
-  unsigned int rsp[4] = {0,0,0,0};
-  char responded = 0;
-  
-  //write req
-  core_req_t* write = new core_req_t;
-  write->valid = 0xf;
-  write->rw = 0xf;
-  write->byteen = 0xffff;
-  write->addr = addr; 
-  write->data = data;
-  write->tag = 0xff;
-
-  //read req
-  core_req_t* read = new core_req_t;
-  read->valid = 0xf;
-  read->rw = 0;
-  read->byteen = 0xffff;
-  read->addr = addr;
-  read->data = addr; 
-  read->tag = 0xff;
-  
-  // reset the device
-  sim->reset();
-
-  //queue reqs
-  for (int i = 0; i < 10; i++){
-    sim->send_req(write);
-  }
-  sim->send_req(read); 
-
-  sim->run();
-
-  bool check = sim->assert_equal(data, write->tag);
-  
-  return check;
+static void show_usage() {
+  std::cout << "Usage: [-p <pattern>: seq|stride|random|conflict] [-n <requests>] [-f <footprint>]"
+               " [-s <stride>] [-w <store %>] [-m <active lanes %>] [-q <max pending loads>]"
+               " [-r <seed>] [-h: help]" << std::endl;
 }
 
+int main(int argc, char **argv) {
+  BenchConfig config;
+  bool bench = false;
+  int c;
+  while ((c = getopt(argc, argv, "p:n:f:s:w:m:q:r:h?")) != -1) {
+    switch (c) {
+    case 'p':
+      if (config.set_pattern(optarg))
+        return -1;
+      bench = true;
+      break;
+    case 'n': config.requests    = strtoul(optarg, nullptr, 0); break;
+    case 'f': config.footprint   = strtoul(optarg, nullptr, 0); break;
+    case 's': config.stride      = strtoul(optarg, nullptr, 0); break;
+    case 'w': config.write_ratio = strtoul(optarg, nullptr, 0); break;
+    case 'm': config.lane_ratio  = strtoul(optarg, nullptr, 0); break;
+    case 'q': config.max_pending = strtoul(optarg, nullptr, 0); break;
+    case 'r': config.seed        = strtoul(optarg, nullptr, 0); break;
+    case 'h':
+    case '?':
+      show_usage();
+      return 0;
+    default:
+      show_usage();
+      return -1;
+    }
+  }
 
-int main(int argc, char **argv)
-{
-  //init
   RAM ram;
-	CacheSim cachesim;
+  CacheSim cachesim;
   cachesim.attach_ram(&ram);
-  int check = REQ_RSP(&cachesim);
-  if(check){
-    std::cout << "PASSED" << std::endl;
-  } else {
-    std::cout << "FAILED" << std::endl;
+
+  std::cout << "cache: NUM_REQS=" << NUM_REQS
+            << ", CACHE_SIZE=" << CACHE_SIZE
+            << ", CACHE_LINE_SIZE=" << CACHE_LINE_SIZE
+            << ", NUM_BANKS=" << NUM_BANKS
+            << ", MSHR_SIZE=" << MSHR_SIZE << std::endl;
+
+  int failed = 0;
+
+  if (!bench) {
+    if (REQ_RSP(&cachesim)) {
+      std::cout << "REQ_RSP FAILED" << std::endl;
+      ++failed;
+    }
+    if (HIT_1(&cachesim)) {
+      std::cout << "HIT_1 FAILED" << std::endl;
+      ++failed;
+    }
+  }
+
+  // run every pattern unless one is selected
+  for (int p = PATTERN_SEQ; p <= PATTERN_CONFLICT; ++p) {
+    if (bench && p != config.pattern)
+      continue;
+    BenchConfig run_config(config);
+    run_config.pattern = pattern_t(p);
+    std::cout << "pattern: " << run_config.pattern_name()
+              << ", requests=" << run_config.requests
+              << ", footprint=" << run_config.footprint
+              << ", stores=" << run_config.write_ratio << "%" << std::endl;
+    if (cachesim.run(run_config)) {
+      ++failed;
+    }
+    cachesim.print_stats(std::cout);
   }
-  
 
+  std::cout << (failed ? "FAILED" : "PASSED") << std::endl;
 
-	return 0;
+  return failed ? 1 : 0;
 }
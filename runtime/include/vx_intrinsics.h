@@ -224,6 +224,13 @@ inline int vx_num_cores() {
     return result;   
 }
 
+// Return the shared memory size of a core (0 without shared memory)
+inline int vx_smem_size() {
+    int result;
+    asm volatile ("csrr %0, %1" : "=r"(result) : "i"(CSR_SMEM_SIZE));
+    return result;   
+}
+
 inline void vx_fence() {
     asm volatile ("fence iorw, iorw");
 }
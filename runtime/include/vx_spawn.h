@@ -26,14 +26,45 @@ typedef void (*vx_spawn_kernel_cb) (
 	uint32_t /* group_z */
 );
 
+typedef void (*vx_spawn_group_cb) (
+  const void * /* arg */,
+  const context_t * /* context */,
+  uint32_t /* group_x */,
+  uint32_t /* group_y */,
+  uint32_t /* group_z */,
+  uint32_t /* local_x */,
+  uint32_t /* local_y */,
+  uint32_t /* local_z */,
+  void * /* local_mem */
+);
+
 typedef void (*vx_spawn_tasks_cb)(int task_id, void *arg);
 
+typedef enum {
+  VX_SCHED_STATIC = 0,  // contiguous split across cores, warps and threads
+  VX_SCHED_DYNAMIC,     // warps claim chunks from a per-core counter
+  VX_SCHED_STEAL        // per-warp ranges, idle warps steal from busy ones
+} vx_sched_t;
+
 typedef void (*vx_serial_cb)(void *arg);
 
 void vx_spawn_kernel(context_t * ctx, vx_spawn_kernel_cb callback, void * arg);
 
+// runs each workgroup on the warps of one core, one work-item per thread,
+// with local_mem_size bytes of shared memory per group (requires a device
+// built with LMEM_ENABLE).
+// Returns -1 if a group does not fit on a core.
+int vx_spawn_kernel_groups(context_t * ctx, vx_spawn_group_cb callback, void * arg, int local_mem_size);
+
+// barrier across the work-items of the calling group
+void vx_group_barrier();
+
 void vx_spawn_tasks(int num_tasks, vx_spawn_tasks_cb callback, void * arg);
 
+// chunk is the number of tasks a warp takes at a time, rounded up to a
+// multiple of the warp size (0 selects a default)
+void vx_spawn_tasks_sched(int num_tasks, vx_spawn_tasks_cb callback, void * arg, vx_sched_t sched, int chunk);
+
 void vx_serial(vx_serial_cb callback, void * arg);
 
 #ifdef __cplusplus
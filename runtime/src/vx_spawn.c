@@ -9,6 +9,7 @@ extern "C" {
 #define NUM_CORES_MAX 32
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 typedef struct {
 	vx_spawn_tasks_cb callback;
@@ -118,7 +119,7 @@ void vx_spawn_tasks(int num_tasks, vx_spawn_tasks_cb callback , void * arg) {
   // number of tasks per core
   int tasks_per_core = num_tasks / nc;
   int tasks_per_core0 = tasks_per_core;  
-  if (core_id == (NC-1)) {    
+  if (core_id == (nc-1)) {    
     int QC_r = num_tasks - (nc * tasks_per_core0); 
     tasks_per_core0 += QC_r; // last core executes remaining tasks
   }
@@ -153,6 +154,255 @@ void vx_spawn_tasks(int num_tasks, vx_spawn_tasks_cb callback , void * arg) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Cores do not share a coherent memory and there are no atomic instructions,
+// so the dynamic modes balance the warps within a core. Each core takes an
+// even share of the tasks. Its warps coordinate through a bakery lock on
+// warp0's stack, which maps to a single shared memory bank, so every warp's
+// accesses to it are performed in program order. All threads of a warp run
+// the protocol in lockstep with the same values, acting as one agent.
+// Without shared memory the stacks go through the banked data cache, which
+// does not keep that order, so the dynamic modes fall back to static. This is
+// checked on the device at run time since the runtime is built only once.
+
+#define SCHED_WARPS_MAX   16  // warps used by the dynamic modes
+#define SCHED_CHUNK_WARPS 4   // default chunk in warp-sized task groups
+
+typedef struct {
+  vx_spawn_tasks_cb callback;
+  void * arg;
+  vx_sched_t sched;
+  int begin;
+  int end;
+  int chunk;
+  int NW;
+  volatile int next;                       // next unclaimed task (dynamic)
+  volatile int head[SCHED_WARPS_MAX];      // per-warp task ranges (steal)
+  volatile int tail[SCHED_WARPS_MAX];
+  volatile int number[SCHED_WARPS_MAX];    // bakery tickets
+  volatile char choosing[SCHED_WARPS_MAX];
+} wspawn_tasks_sched_args_t;
+
+static void sched_lock(wspawn_tasks_sched_args_t* p_args, int wid) {
+  p_args->choosing[wid] = 1;
+  int ticket = 0;
+  for (int j = 0; j < p_args->NW; ++j) {
+    int number = p_args->number[j];
+    if (number > ticket)
+      ticket = number;
+  }
+  ++ticket;
+  p_args->number[wid] = ticket;
+  p_args->choosing[wid] = 0;
+
+  for (int j = 0; j < p_args->NW; ++j) {
+    if (j == wid)
+      continue;
+    while (p_args->choosing[j]);
+    for (;;) {
+      int number = p_args->number[j];
+      if (0 == number
+       || number > ticket
+       || (number == ticket && j > wid))
+        break;
+    }
+  }
+}
+
+static void sched_unlock(wspawn_tasks_sched_args_t* p_args, int wid) {
+  p_args->number[wid] = 0;
+}
+
+static void sched_run(wspawn_tasks_sched_args_t* p_args, int start, int end, int tid, int NT) {
+  for (int base = start; base < end; base += NT) {
+    int task_id = base + tid;
+    if (base + NT <= end) {
+      (p_args->callback)(task_id, p_args->arg);
+    } else {
+      // partial group at the end of the range
+      int active = (task_id < end);
+      vx_split(active);
+      if (active) {
+        (p_args->callback)(task_id, p_args->arg);
+      }
+      vx_join();
+    }
+  }
+}
+
+// claim the next chunk from the core's counter
+static int sched_claim(wspawn_tasks_sched_args_t* p_args, int wid) {
+  sched_lock(p_args, wid);
+  int start = p_args->next;
+  p_args->next = start + p_args->chunk;
+  sched_unlock(p_args, wid);
+  return start;
+}
+
+// take the next chunk from the front of the warp's own range, the lock is
+// only needed when a thief may be taking the same tasks from the back
+static int sched_pop(wspawn_tasks_sched_args_t* p_args, int wid, int* end) {
+  int head = p_args->head[wid];
+  p_args->head[wid] = head + p_args->chunk;
+  if (head + p_args->chunk <= p_args->tail[wid]) {
+    *end = head + p_args->chunk;
+    return head;
+  }
+  p_args->head[wid] = head;
+
+  sched_lock(p_args, wid);
+  head = p_args->head[wid];
+  *end = MIN(head + p_args->chunk, p_args->tail[wid]);
+  if (*end > head) {
+    p_args->head[wid] = *end;
+  }
+  sched_unlock(p_args, wid);
+  return head;
+}
+
+// move the back half of the largest remaining range to the warp's own range
+static int sched_steal(wspawn_tasks_sched_args_t* p_args, int wid, int NT) {
+  int found = 0;
+  sched_lock(p_args, wid);
+
+  int victim = -1;
+  int size = p_args->chunk;
+  for (int j = 0; j < p_args->NW; ++j) {
+    int remaining = p_args->tail[j] - p_args->head[j];
+    if (remaining > size) {
+      size = remaining;
+      victim = j;
+    }
+  }
+
+  if (victim >= 0) {
+    int tail = p_args->tail[victim];
+    // keep the ranges in whole warps
+    int split = tail - size / 2;
+    split -= (split - p_args->begin) % NT;
+    p_args->tail[victim] = split;
+    if (p_args->head[victim] > split) {
+      // the owner already took some of these tasks
+      p_args->tail[victim] = tail;
+    } else {
+      p_args->head[wid] = split;
+      p_args->tail[wid] = tail;
+      found = 1;
+    }
+  }
+
+  sched_unlock(p_args, wid);
+  return found;
+}
+
+static void __attribute__ ((noinline)) spawn_tasks_sched_stub() {
+  int core_id = vx_core_id();
+  int wid     = vx_warp_id();
+  int tid     = vx_thread_id();
+  int NT      = vx_num_threads();
+
+  wspawn_tasks_sched_args_t* p_wspawn_args = (wspawn_tasks_sched_args_t*)g_wspawn_args[core_id];
+
+  if (VX_SCHED_DYNAMIC == p_wspawn_args->sched) {
+    for (;;) {
+      int start = sched_claim(p_wspawn_args, wid);
+      if (start >= p_wspawn_args->end)
+        break;
+      sched_run(p_wspawn_args, start, MIN(start + p_wspawn_args->chunk, p_wspawn_args->end), tid, NT);
+    }
+  } else {
+    do {
+      for (;;) {
+        int end;
+        int start = sched_pop(p_wspawn_args, wid, &end);
+        if (start >= end)
+          break;
+        sched_run(p_wspawn_args, start, end, tid, NT);
+      }
+    } while (sched_steal(p_wspawn_args, wid, NT));
+  }
+
+  // wait for all warps to complete
+  vx_barrier(0, p_wspawn_args->NW);
+}
+
+static void spawn_tasks_sched_cb() {
+  // activate all threads
+  vx_tmc(-1);
+
+  // call stub routine
+  spawn_tasks_sched_stub();
+
+  // set warp0 to single-threaded and stop other warps
+  int wid = vx_warp_id();
+  vx_tmc(0 == wid);
+}
+
+void vx_spawn_tasks_sched(int num_tasks, vx_spawn_tasks_cb callback, void * arg, vx_sched_t sched, int chunk) {
+  if (VX_SCHED_STATIC == sched 
+   || 0 == vx_smem_size()) {
+    vx_spawn_tasks(num_tasks, callback, arg);
+    return;
+  }
+
+  // device specs
+  int NC = vx_num_cores();
+  int NW = MIN(vx_num_warps(), SCHED_WARPS_MAX);
+  int NT = vx_num_threads();
+
+  // current core id
+  int core_id = vx_core_id();
+  if (core_id >= NUM_CORES_MAX)
+    return;
+
+  // chunk size, a multiple of the warp size
+  if (chunk <= 0)
+    chunk = SCHED_CHUNK_WARPS * NT;
+  chunk = ((chunk + NT - 1) / NT) * NT;
+
+  // calculate necessary active cores, at least one chunk each
+  int nC = (num_tasks + chunk - 1) / chunk;
+  int nc = MIN(nC, NC);
+  if (core_id >= nc)
+    return; // terminate extra cores
+
+  // even split of warp-sized task groups across cores,
+  // the first cores take the remainder
+  int groups = (num_tasks + NT - 1) / NT;
+  int groups_per_core = groups / nc;
+  int rem   = groups - (nc * groups_per_core);
+  int begin = (core_id * groups_per_core + MIN(core_id, rem)) * NT;
+  int end   = MIN(begin + (groups_per_core + (core_id < rem)) * NT, num_tasks);
+
+  // active warps, at least one chunk each
+  int chunks = (end - begin + chunk - 1) / chunk;
+  int nw = MIN(chunks, NW);
+
+  //--
+  wspawn_tasks_sched_args_t wspawn_args;
+  wspawn_args.callback = callback;
+  wspawn_args.arg      = arg;
+  wspawn_args.sched    = sched;
+  wspawn_args.begin    = begin;
+  wspawn_args.end      = end;
+  wspawn_args.chunk    = chunk;
+  wspawn_args.NW       = nw;
+  wspawn_args.next     = begin;
+  for (int w = 0; w < nw; ++w) {
+    // initial ranges in whole chunks
+    wspawn_args.head[w]     = begin + ((chunks * w) / nw) * chunk;
+    wspawn_args.tail[w]     = MIN(begin + ((chunks * (w + 1)) / nw) * chunk, end);
+    wspawn_args.number[w]   = 0;
+    wspawn_args.choosing[w] = 0;
+  }
+  g_wspawn_args[core_id] = &wspawn_args;
+
+  //--
+  vx_wspawn(nw, spawn_tasks_sched_cb);
+  spawn_tasks_sched_cb();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static void __attribute__ ((noinline)) spawn_kernel_all_stub() {
   int core_id = vx_core_id();
   int wid     = vx_warp_id();
@@ -302,6 +552,175 @@ void vx_spawn_kernel(context_t * ctx, vx_spawn_kernel_cb callback, void * arg) {
   }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// A workgroup runs on the warps of one core, one work-item per thread, so
+// the work-items can share local memory and synchronize with a hardware
+// barrier. A core runs several groups side by side, each in its own slot of
+// warps with its own barrier (barrier 0 is kept for the spawn routine) and
+// its own part of the local memory below the stacks. The local memory is
+// whatever shared memory the device has beyond the stacks (LMEM_ENABLE adds
+// it), read at run time since the runtime is built only once.
+
+typedef struct {
+  context_t * ctx;
+  vx_spawn_group_cb callback;
+  void * arg;
+  int  begin;       // first group of the core
+  int  end;
+  int  slots;       // groups running at a time
+  int  group_warps; // warps per group
+  int  group_size;  // work-items per group
+  int  NW;
+  char * local_mem;
+  int  local_mem_size;
+} wspawn_group_args_t;
+
+static void __attribute__ ((noinline)) spawn_group_stub() {
+  int core_id = vx_core_id();
+  int wid     = vx_warp_id();
+  int tid     = vx_thread_id();
+  int NT      = vx_num_threads();
+
+  wspawn_group_args_t* p_wspawn_args = (wspawn_group_args_t*)g_wspawn_args[core_id];
+  context_t* ctx = p_wspawn_args->ctx;
+
+  int slot     = wid / p_wspawn_args->group_warps;
+  int local_id = (wid - slot * p_wspawn_args->group_warps) * NT + tid;
+  void* local_mem = p_wspawn_args->local_mem + slot * p_wspawn_args->local_mem_size;
+
+  int X  = ctx->num_groups[0];
+  int Y  = ctx->num_groups[1];
+  int XY = X * Y;
+  int LX  = ctx->local_size[0];
+  int LXY = LX * ctx->local_size[1];
+
+  int lz = local_id / LXY;
+  int l2d = local_id - lz * LXY;
+  int ly = l2d / LX;
+  int lx = l2d - ly * LX;
+
+  // disable the threads past the end of the group
+  int active = p_wspawn_args->group_size - (local_id - tid);
+  if (active < NT) {
+    vx_tmc((1 << active) - 1);
+  }
+
+  for (int wg_id = p_wspawn_args->begin + slot; wg_id < p_wspawn_args->end; wg_id += p_wspawn_args->slots) {
+    int k = wg_id / XY;
+    int wg_2d = wg_id - k * XY;
+    int j = wg_2d / X;
+    int i = wg_2d - j * X;
+
+    int gid0 = ctx->global_offset[0] + i;
+    int gid1 = ctx->global_offset[1] + j;
+    int gid2 = ctx->global_offset[2] + k;
+
+    (p_wspawn_args->callback)(p_wspawn_args->arg, ctx, gid0, gid1, gid2, lx, ly, lz, local_mem);
+
+    // the next group reuses the local memory
+    vx_group_barrier();
+  }
+
+  // wait for all warps to complete
+  vx_tmc(-1);
+  vx_barrier(0, p_wspawn_args->NW);
+}
+
+static void spawn_group_cb() {
+  // activate all threads
+  vx_tmc(-1);
+
+  // call stub routine
+  spawn_group_stub();
+
+  // set warp0 to single-threaded and stop other warps
+  int wid = vx_warp_id();
+  vx_tmc(0 == wid);
+}
+
+void vx_group_barrier() {
+  int core_id = vx_core_id();
+  wspawn_group_args_t* p_wspawn_args = (wspawn_group_args_t*)g_wspawn_args[core_id];
+
+  int slot = vx_warp_id() / p_wspawn_args->group_warps;
+
+  // complete the pending local memory stores first
+  vx_fence();
+  vx_barrier(1 + slot, p_wspawn_args->group_warps);
+}
+
+int vx_spawn_kernel_groups(context_t * ctx, vx_spawn_group_cb callback, void * arg, int local_mem_size) {
+  // total number of WGs
+  int X  = ctx->num_groups[0];
+  int Y  = ctx->num_groups[1];
+  int Z  = ctx->num_groups[2];
+  int Q  = X * Y * Z;
+
+  // work-items per WG
+  int L = ctx->local_size[0] * ctx->local_size[1] * ctx->local_size[2];
+
+  // device specs
+  int NC = vx_num_cores();
+  int NW = vx_num_warps();
+  int NT = vx_num_threads();
+
+  // a WG must fit on one core
+  int group_warps = (L + NT - 1) / NT;
+  if (0 == L || group_warps > NW)
+    return -1;
+
+  // WGs running at a time on a core
+  int slots = MIN(NW / group_warps, NUM_BARRIERS - 1);
+  local_mem_size = (local_mem_size + 3) & ~3;
+  if (local_mem_size != 0) {
+    int lmem_size = MAX(vx_smem_size() - ((NW * NT) << STACK_LOG2_SIZE), 0);
+    slots = MIN(slots, lmem_size / local_mem_size);
+  }
+  if (0 == slots)
+    return -1;
+
+  // current core id
+  int core_id = vx_core_id();
+  if (core_id >= NUM_CORES_MAX)
+    return 0;
+
+  // calculate necessary active cores
+  int nc = MIN(Q, NC);
+  if (core_id >= nc)
+    return 0; // terminate extra cores
+
+  // even split across cores, the first cores take the remainder
+  int wgs_per_core = Q / nc;
+  int rem   = Q - (nc * wgs_per_core);
+  int begin = core_id * wgs_per_core + MIN(core_id, rem);
+  int end   = begin + wgs_per_core + (core_id < rem);
+
+  slots = MIN(slots, end - begin);
+  int nw = slots * group_warps;
+
+  //--
+  wspawn_group_args_t wspawn_args;
+  wspawn_args.ctx            = ctx;
+  wspawn_args.callback       = callback;
+  wspawn_args.arg            = arg;
+  wspawn_args.begin          = begin;
+  wspawn_args.end            = end;
+  wspawn_args.slots          = slots;
+  wspawn_args.group_warps    = group_warps;
+  wspawn_args.group_size     = L;
+  wspawn_args.NW             = nw;
+  wspawn_args.local_mem      = (char*)(SMEM_BASE_ADDR - ((NW * NT) << STACK_LOG2_SIZE) - (slots * local_mem_size));
+  wspawn_args.local_mem_size = local_mem_size;
+  g_wspawn_args[core_id] = &wspawn_args;
+
+  //--
+  vx_wspawn(nw, spawn_group_cb);
+  spawn_group_cb();
+
+  return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
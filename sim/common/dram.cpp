@@ -0,0 +1,257 @@
+#include "dram.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace vortex;
+
+DramConfig::DramConfig()
+  : channels(1)
+  , banks(8)
+  , row_size(2048)
+  , block_size(64)
+  , queue_size(16)
+  , tCTRL(8)
+  , tRCD(4)
+  , tCL(4)
+  , tRP(4)
+  , tBURST(1)
+  , tWTR(2)
+  , tRTW(2)
+  , tREFI(1560)
+  , tRFC(70)
+{}
+
+int DramConfig::load(const char* filename) {
+  static const struct {
+    const char* name;
+    uint32_t DramConfig::* field;
+  } params[] = {
+    {"channels",   &DramConfig::channels},
+    {"banks",      &DramConfig::banks},
+    {"row_size",   &DramConfig::row_size},
+    {"block_size", &DramConfig::block_size},
+    {"queue_size", &DramConfig::queue_size},
+    {"tCTRL",      &DramConfig::tCTRL},
+    {"tRCD",       &DramConfig::tRCD},
+    {"tCL",        &DramConfig::tCL},
+    {"tRP",        &DramConfig::tRP},
+    {"tBURST",     &DramConfig::tBURST},
+    {"tWTR",       &DramConfig::tWTR},
+    {"tRTW",       &DramConfig::tRTW},
+    {"tREFI",      &DramConfig::tREFI},
+    {"tRFC",       &DramConfig::tRFC},
+  };
+
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    std::cerr << "*** error: cannot open DRAM config file " << filename << std::endl;
+    return -1;
+  }
+
+  std::string line;
+  for (int lineno = 1; std::getline(ifs, line); ++lineno) {
+    auto comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    std::replace(line.begin(), line.end(), '=', ' ');
+    std::istringstream iss(line);
+    std::string name;
+    if (!(iss >> name))
+      continue;
+    uint32_t value;
+    if (!(iss >> value)) {
+      std::cerr << "*** error: " << filename << ":" << lineno << ": missing value for " << name << std::endl;
+      return -1;
+    }
+    bool found = false;
+    for (auto& param : params) {
+      if (name == param.name) {
+        this->*param.field = value;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      std::cerr << "*** error: " << filename << ":" << lineno << ": unknown DRAM parameter " << name << std::endl;
+      return -1;
+    }
+  }
+
+  if (0 == channels || 0 == banks || 0 == block_size || row_size < block_size) {
+    std::cerr << "*** error: " << filename << ": invalid DRAM organization" << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
+
+int DramConfig::load_env() {
+  auto filename = getenv("VORTEX_DRAM_CONFIG");
+  if (nullptr == filename)
+    return 0;
+  return this->load(filename);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+DramSim::DramSim(const DramConfig& config)
+  : config_(config) {
+  this->reset();
+}
+
+void DramSim::reset() {
+  channel_t channel;
+  channel.banks.resize(config_.banks, {-1, 0, 0});
+  channel.inflight.assign(std::max<uint32_t>(config_.queue_size, 1), 0);
+  channel.head = 0;
+  channel.bus_free = 0;
+  channel.last_write = false;
+  channels_.assign(config_.channels, channel);
+
+  reads_          = 0;
+  writes_         = 0;
+  row_hits_       = 0;
+  row_misses_     = 0;
+  row_conflicts_  = 0;
+  refresh_stalls_ = 0;
+  turnarounds_    = 0;
+  total_latency_  = 0;
+}
+
+bool DramSim::ready(uint64_t addr, uint64_t cycle) const {
+  // requests complete in order per channel, so the oldest of the last
+  // queue_size requests tells whether the queue has drained a slot
+  auto& channel = channels_.at((addr / config_.block_size) % config_.channels);
+  if (0 == config_.queue_size)
+    return true;
+  return channel.inflight[channel.head] <= cycle;
+}
+
+uint64_t DramSim::access(uint64_t addr, bool write, uint64_t cycle) {
+  // address mapping: row | bank | column | channel | offset
+  uint64_t block = addr / config_.block_size;
+  auto& channel = channels_.at(block % config_.channels);
+  uint64_t index = block / config_.channels;
+  index /= (config_.row_size / config_.block_size);
+  auto& bank = channel.banks.at(index % config_.banks);
+  int64_t row = index / config_.banks;
+
+  uint64_t start = std::max<uint64_t>(cycle + config_.tCTRL, bank.ready);
+
+  // refresh blocks the channel for tRFC every tREFI and closes all rows
+  if (config_.tREFI != 0) {
+    uint64_t epoch = start / config_.tREFI;
+    if (epoch != 0 && (start % config_.tREFI) < config_.tRFC) {
+      start = epoch * config_.tREFI + config_.tRFC;
+      ++refresh_stalls_;
+    }
+    if (epoch > bank.refresh) {
+      bank.open_row = -1;
+      bank.refresh = epoch;
+    }
+  }
+
+  // row buffer
+  uint64_t col_cmd = start;
+  if (bank.open_row == row) {
+    ++row_hits_;
+  } else if (bank.open_row < 0) {
+    col_cmd += config_.tRCD;
+    ++row_misses_;
+  } else {
+    col_cmd += config_.tRP + config_.tRCD;
+    ++row_conflicts_;
+  }
+  bank.open_row = row;
+
+  // shared data bus, changing direction costs a turnaround
+  uint64_t bus_free = channel.bus_free;
+  if (write != channel.last_write) {
+    bus_free += write ? config_.tRTW : config_.tWTR;
+    ++turnarounds_;
+  }
+  uint64_t data = std::max<uint64_t>(col_cmd + config_.tCL, bus_free);
+  uint64_t done = data + config_.tBURST;
+  channel.bus_free = done;
+  channel.last_write = write;
+
+  // the bank accepts its next column command one burst later
+  bank.ready = data - config_.tCL + config_.tBURST;
+
+  uint64_t complete = done + config_.tCTRL;
+  if (config_.queue_size != 0) {
+    channel.inflight[channel.head] = complete;
+    channel.head = (channel.head + 1) % config_.queue_size;
+  }
+
+  if (write) {
+    ++writes_;
+  } else {
+    ++reads_;
+  }
+  total_latency_ += complete - cycle;
+
+  return complete;
+}
+
+void DramSim::print_stats(std::ostream& out) const {
+  uint64_t requests = reads_ + writes_;
+  out << std::left;
+  out << std::setw(28) << "# of DRAM reads:" << std::dec << reads_ << std::endl;
+  out << std::setw(28) << "# of DRAM writes:" << writes_ << std::endl;
+  out << std::setw(28) << "# of DRAM row hits:" << row_hits_ << std::endl;
+  out << std::setw(28) << "# of DRAM row misses:" << row_misses_ << std::endl;
+  out << std::setw(28) << "# of DRAM row conflicts:" << row_conflicts_ << std::endl;
+  out << std::setw(28) << "# of DRAM refresh stalls:" << refresh_stalls_ << std::endl;
+  out << std::setw(28) << "# of DRAM turnarounds:" << turnarounds_ << std::endl;
+  out << std::setw(28) << "DRAM average latency:" << (requests ? (total_latency_ / requests) : 0) << std::endl;
+}
+
+void DramSim::save(std::ostream& out) const {
+  out.write((const char*)&config_, sizeof(config_));
+  for (auto& channel : channels_) {
+    out.write((const char*)channel.banks.data(), channel.banks.size() * sizeof(bank_t));
+    out.write((const char*)channel.inflight.data(), channel.inflight.size() * sizeof(uint64_t));
+    out.write((const char*)&channel.head, sizeof(channel.head));
+    out.write((const char*)&channel.bus_free, sizeof(channel.bus_free));
+    out.write((const char*)&channel.last_write, sizeof(channel.last_write));
+  }
+  uint64_t stats[] = {reads_, writes_, row_hits_, row_misses_, row_conflicts_, 
+                      refresh_stalls_, turnarounds_, total_latency_};
+  out.write((const char*)stats, sizeof(stats));
+}
+
+int DramSim::restore(std::istream& in) {
+  DramConfig config;
+  in.read((char*)&config, sizeof(config));
+  if (!in || memcmp(&config, &config_, sizeof(config)) != 0) {
+    std::cerr << "*** error: DRAM snapshot configuration mismatch" << std::endl;
+    return -1;
+  }
+  for (auto& channel : channels_) {
+    in.read((char*)channel.banks.data(), channel.banks.size() * sizeof(bank_t));
+    in.read((char*)channel.inflight.data(), channel.inflight.size() * sizeof(uint64_t));
+    in.read((char*)&channel.head, sizeof(channel.head));
+    in.read((char*)&channel.bus_free, sizeof(channel.bus_free));
+    in.read((char*)&channel.last_write, sizeof(channel.last_write));
+  }
+  uint64_t stats[8];
+  in.read((char*)stats, sizeof(stats));
+  if (!in)
+    return -1;
+  reads_          = stats[0];
+  writes_         = stats[1];
+  row_hits_       = stats[2];
+  row_misses_     = stats[3];
+  row_conflicts_  = stats[4];
+  refresh_stalls_ = stats[5];
+  turnarounds_    = stats[6];
+  total_latency_  = stats[7];
+  return 0;
+}
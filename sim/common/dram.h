@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace vortex {
+
+// DRAM organization and timing, all timings in simulated clock cycles.
+// The defaults approximate one DDR4 channel behind a 200 MHz core clock.
+struct DramConfig {
+  uint32_t channels;      // independent channels, interleaved by block
+  uint32_t banks;         // banks per channel
+  uint32_t row_size;      // row buffer size in bytes
+  uint32_t block_size;    // bytes per request
+  uint32_t queue_size;    // requests queued per channel before backpressure
+  uint32_t tCTRL;         // controller and PHY latency, each way
+  uint32_t tRCD;          // activate to column command
+  uint32_t tCL;           // column command to data
+  uint32_t tRP;           // precharge
+  uint32_t tBURST;        // data bus occupancy per block (bandwidth)
+  uint32_t tWTR;          // write to read bus turnaround
+  uint32_t tRTW;          // read to write bus turnaround
+  uint32_t tREFI;         // refresh interval (0 disables refresh)
+  uint32_t tRFC;          // refresh duration
+
+  DramConfig();
+
+  // read "name = value" lines, '#' starts a comment
+  int load(const char* filename);
+
+  // load the file named by the VORTEX_DRAM_CONFIG environment variable, if set
+  int load_env();
+};
+
+class DramSim {
+public:
+  DramSim(const DramConfig& config = DramConfig());
+
+  void reset();
+
+  const DramConfig& config() const {
+    return config_;
+  }
+
+  // the channel of addr can accept a new request at this cycle
+  bool ready(uint64_t addr, uint64_t cycle) const;
+
+  // schedule a block access issued at cycle and return its completion cycle
+  uint64_t access(uint64_t addr, bool write, uint64_t cycle);
+
+  void print_stats(std::ostream& out) const;
+
+  // write the bank, bus and queue state to a binary stream
+  void save(std::ostream& out) const;
+
+  // resume from a state written by save() with the same configuration
+  int restore(std::istream& in);
+
+private:
+
+  struct bank_t {
+    int64_t  open_row;
+    uint64_t ready;
+    uint64_t refresh;
+  };
+
+  struct channel_t {
+    std::vector<bank_t>   banks;
+    std::vector<uint64_t> inflight;
+    uint32_t head;
+    uint64_t bus_free;
+    bool     last_write;
+  };
+
+  DramConfig config_;
+  std::vector<channel_t> channels_;
+
+  uint64_t reads_;
+  uint64_t writes_;
+  uint64_t row_hits_;
+  uint64_t row_misses_;
+  uint64_t row_conflicts_;
+  uint64_t refresh_stalls_;
+  uint64_t turnarounds_;
+  uint64_t total_latency_;
+};
+
+}
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <fstream>
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 #include "util.h"
 
 using namespace vortex;
@@ -172,17 +174,108 @@ RAM::RAM(uint32_t num_pages, uint32_t page_size)
   : page_bits_(log2ceil(page_size)) {    
     assert(ispow2(page_size));
   mem_.resize(num_pages, NULL);
+  blocks_.resize(num_pages, NULL);
   size_ = uint64_t(mem_.size()) << page_bits_;
 }
 
 RAM::~RAM() {
-  this->clear();
+  for (uint32_t i = 0; i < mem_.size(); ++i) {
+    this->release_page(i);
+  }
+}
+
+static void init_page(uint8_t* page, uint32_t page_size) {
+  // set uninitialized data to "baadf00d"
+  for (uint32_t i = 0; i < page_size; ++i) {
+    page[i] = (0xbaadf00d >> ((i & 0x3) * 8)) & 0xff;
+  }
 }
 
 void RAM::clear() {
-  for (auto& page : mem_) {
+  uint32_t page_size = 1 << page_bits_;
+  for (uint32_t i = 0; i < mem_.size(); ++i) {
+    auto block = blocks_[i];
+    if (block && block->refs != 0) {
+      // keep live mappings valid
+      init_page(mem_[i], page_size);
+      continue;
+    }
+    this->release_page(i);
+  }
+}
+
+void RAM::release_page(uint32_t page_index) {
+  auto& page = mem_[page_index];
+  auto& block = blocks_[page_index];
+  if (block) {
+    if (0 == --block->num_pages) {
+      delete[] block->data;
+      delete block;
+    }
+    block = NULL;
+  } else {
     delete[] page;
-    page = NULL;
+  }
+  page = NULL;
+}
+
+uint8_t* RAM::map(uint64_t addr, uint64_t size) {
+  if (0 == size || addr + size > size_)
+    return NULL;
+
+  uint32_t page_size  = 1 << page_bits_;
+  uint32_t first_page = addr >> page_bits_;
+  uint32_t last_page  = (addr + size - 1) >> page_bits_;
+  uint32_t num_pages  = last_page - first_page + 1;
+
+  // reuse an existing block if it covers the whole range
+  auto block = blocks_[first_page];
+  if (block) {
+    bool covered = true;
+    for (uint32_t i = first_page; i <= last_page; ++i) {
+      if (blocks_[i] != block) {
+        covered = false;
+        break;
+      }
+    }
+    if (covered) {
+      ++block->refs;
+      return block->data + (addr - (uint64_t(block->first_page) << page_bits_));
+    }
+  }
+
+  // cannot move pages that are still mapped
+  for (uint32_t i = first_page; i <= last_page; ++i) {
+    if (blocks_[i] && blocks_[i]->refs != 0)
+      return NULL;
+  }
+
+  // migrate the range into a new contiguous block
+  block = new block_t();
+  block->data       = new uint8_t[uint64_t(num_pages) << page_bits_];
+  block->first_page = first_page;
+  block->num_pages  = num_pages;
+  block->refs       = 1;
+  for (uint32_t i = 0; i < num_pages; ++i) {
+    uint32_t page_index = first_page + i;
+    uint8_t* dst = block->data + (uint64_t(i) << page_bits_);
+    if (mem_[page_index]) {
+      memcpy(dst, mem_[page_index], page_size);
+      this->release_page(page_index);
+    } else {
+      init_page(dst, page_size);
+    }
+    mem_[page_index]    = dst;
+    blocks_[page_index] = block;
+  }
+
+  return block->data + (addr - (uint64_t(first_page) << page_bits_));
+}
+
+void RAM::unmap(uint64_t addr) {
+  auto block = blocks_.at(addr >> page_bits_);
+  if (block && block->refs != 0) {
+    --block->refs;
   }
 }
 
@@ -198,10 +291,7 @@ uint8_t *RAM::get(uint32_t address) const {
   auto &page = mem_.at(page_index);
   if (page == NULL) {
     uint8_t *ptr = new uint8_t[page_size];
-    // set uninitialized data to "baadf00d"
-    for (uint32_t i = 0; i < page_size; ++i) {
-      ptr[i] = (0xbaadf00d >> ((i & 0x3) * 8)) & 0xff;
-    }
+    init_page(ptr, page_size);
     page = ptr;
   }
   return page + byte_offset;
@@ -209,16 +299,66 @@ uint8_t *RAM::get(uint32_t address) const {
 
 void RAM::read(void *data, uint64_t addr, uint64_t size) {
   uint8_t* d = (uint8_t*)data;
-  for (uint64_t i = 0; i < size; i++) {
-    d[i] = *this->get(addr + i);
+  uint64_t page_size = uint64_t(1) << page_bits_;
+  while (size != 0) {
+    // copy up to the end of the current page
+    uint64_t chunk = std::min<uint64_t>(size, page_size - (addr & (page_size - 1)));
+    memmove(d, this->get(addr), chunk);
+    d    += chunk;
+    addr += chunk;
+    size -= chunk;
   }
 }
 
 void RAM::write(const void *data, uint64_t addr, uint64_t size) {
   const uint8_t* s = (const uint8_t*)data;
-  for (uint64_t i = 0; i < size; i++) {
-    *this->get(addr + i) = s[i];
+  uint64_t page_size = uint64_t(1) << page_bits_;
+  while (size != 0) {
+    // copy up to the end of the current page
+    uint64_t chunk = std::min<uint64_t>(size, page_size - (addr & (page_size - 1)));
+    memmove(this->get(addr), s, chunk);
+    s    += chunk;
+    addr += chunk;
+    size -= chunk;
+  }
+}
+
+void RAM::save(std::ostream& out) const {
+  uint32_t page_size = 1 << page_bits_;
+  uint32_t num_pages = 0;
+  for (auto page : mem_) {
+    num_pages += (page != NULL);
+  }
+  out.write((const char*)&page_bits_, sizeof(page_bits_));
+  out.write((const char*)&num_pages, sizeof(num_pages));
+  for (uint32_t i = 0; i < mem_.size(); ++i) {
+    if (mem_[i] == NULL)
+      continue;
+    out.write((const char*)&i, sizeof(i));
+    out.write((const char*)mem_[i], page_size);
+  }
+}
+
+int RAM::restore(std::istream& in) {
+  uint32_t page_bits, num_pages;
+  in.read((char*)&page_bits, sizeof(page_bits));
+  in.read((char*)&num_pages, sizeof(num_pages));
+  if (!in || page_bits != page_bits_) {
+    std::cout << "error: RAM snapshot page size mismatch" << std::endl;
+    return -1;
+  }
+  this->clear();
+  uint32_t page_size = 1 << page_bits_;
+  for (uint32_t n = 0; n < num_pages; ++n) {
+    uint32_t i;
+    in.read((char*)&i, sizeof(i));
+    if (!in || i >= mem_.size()) {
+      std::cout << "error: invalid RAM snapshot" << std::endl;
+      return -1;
+    }
+    in.read((char*)this->get(i << page_bits_), page_size);
   }
+  return in ? 0 : -1;
 }
 
 void RAM::loadBinImage(const char* filename, uint64_t destination) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <iosfwd>
 #include <vector>
 #include <unordered_map>
 
@@ -143,6 +145,19 @@ public:
   void loadBinImage(const char* filename, uint64_t destination);
   void loadHexImage(const char* filename);
 
+  // write the allocated pages to a binary stream
+  void save(std::ostream& out) const;
+
+  // replace the contents with pages written by save()
+  int restore(std::istream& in);
+
+  // map [addr, addr + size) onto contiguous host memory, existing contents are preserved.
+  // returns the host address of addr or NULL if the range overlaps a live mapping.
+  uint8_t* map(uint64_t addr, uint64_t size);
+
+  // release a mapping, its memory remains in use by the device
+  void unmap(uint64_t addr);
+
   uint8_t& operator[](uint64_t address) {
     return *this->get(address);
   }
@@ -153,9 +168,19 @@ public:
 
 private:
 
+  struct block_t {
+    uint8_t* data;
+    uint32_t first_page;
+    uint32_t num_pages;  // pages still backed by this block
+    uint32_t refs;       // live mappings
+  };
+
   uint8_t *get(uint32_t address) const;
 
+  void release_page(uint32_t page_index);
+
   mutable std::vector<uint8_t*> mem_;
+  std::vector<block_t*> blocks_;
   uint32_t page_bits_;
   uint64_t size_;
 };
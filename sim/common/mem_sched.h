@@ -0,0 +1,309 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <assert.h>
+
+namespace vortex {
+
+namespace detail {
+
+constexpr uint32_t pow2_ceil(uint32_t x, uint32_t p = 1) {
+  return (p >= x) ? p : pow2_ceil(x, p * 2);
+}
+
+// Open-addressing map from block address to the completion cycle shared
+// by all pending requests to that address.
+template <uint32_t Capacity>
+class AddrHash {
+public:
+  AddrHash() {
+    this->clear();
+  }
+
+  void clear() {
+    for (auto& slot : slots_) {
+      slot.count = 0;
+    }
+  }
+
+  bool contains(uint64_t addr) const {
+    return this->find(addr) != Size;
+  }
+
+  // completion cycle of a pending request to addr, or `ready` if none
+  uint64_t lookup(uint64_t addr, uint64_t ready) const {
+    uint32_t i = this->find(addr);
+    return (i != Size) ? slots_[i].ready : ready;
+  }
+
+  void insert(uint64_t addr, uint64_t ready) {
+    uint32_t i = home(addr);
+    while (slots_[i].count != 0) {
+      if (slots_[i].addr == addr) {
+        ++slots_[i].count;
+        return;
+      }
+      i = (i + 1) & Mask;
+    }
+    slots_[i].addr  = addr;
+    slots_[i].ready = ready;
+    slots_[i].count = 1;
+  }
+
+  void remove(uint64_t addr) {
+    uint32_t i = this->find(addr);
+    assert(i != Size);
+    if (--slots_[i].count != 0)
+      return;
+    // backward-shift deletion keeps probe sequences intact
+    uint32_t j = i;
+    for (;;) {
+      j = (j + 1) & Mask;
+      if (slots_[j].count == 0)
+        break;
+      uint32_t k = home(slots_[j].addr);
+      if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+        continue;
+      slots_[i] = slots_[j];
+      i = j;
+    }
+    slots_[i].count = 0;
+  }
+
+private:
+
+  static constexpr uint32_t Size = pow2_ceil(2 * Capacity);
+  static constexpr uint32_t Mask = Size - 1;
+
+  struct slot_t {
+    uint64_t addr;
+    uint64_t ready;
+    uint32_t count;
+  };
+
+  static uint32_t home(uint64_t addr) {
+    return uint32_t((addr * 0x9E3779B97F4A7C15ull) >> 32) & Mask;
+  }
+
+  uint32_t find(uint64_t addr) const {
+    uint32_t i = home(addr);
+    while (slots_[i].count != 0) {
+      if (slots_[i].addr == addr)
+        return i;
+      i = (i + 1) & Mask;
+    }
+    return Size;
+  }
+
+  std::array<slot_t, Size> slots_;
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Bounded ring buffer of in-flight memory responses released in request
+// order once their completion cycle is reached. A request to an address
+// that is already pending completes together with it.
+template <typename T, uint32_t Capacity>
+class MemRspQueue {
+public:
+  MemRspQueue() {
+    this->clear();
+  }
+
+  void clear() {
+    head_ = 0;
+    size_ = 0;
+    addrs_.clear();
+  }
+
+  bool empty() const {
+    return (0 == size_);
+  }
+
+  bool full() const {
+    return (size_ == Capacity);
+  }
+
+  uint32_t size() const {
+    return size_;
+  }
+
+  // a merged request to addr is pending
+  bool contains(uint64_t addr) const {
+    return addrs_.contains(addr);
+  }
+
+  // schedule a response for the given cycle and return its payload slot
+  T& push(uint64_t addr, uint64_t ready, bool merge = true) {
+    assert(!this->full());
+    auto& entry = entries_[(head_ + size_) % Capacity];
+    ++size_;
+    entry.addr   = addr;
+    entry.merged = merge;
+    if (merge) {
+      ready = addrs_.lookup(addr, ready);
+      addrs_.insert(addr, ready);
+    }
+    entry.ready = ready;
+    return entry.data;
+  }
+
+  // the oldest response is due at the given cycle
+  bool ready(uint64_t cycle) const {
+    return (size_ != 0) && (entries_[head_].ready <= cycle);
+  }
+
+  T& front() {
+    assert(!this->empty());
+    return entries_[head_].data;
+  }
+
+  void pop() {
+    assert(!this->empty());
+    auto& entry = entries_[head_];
+    if (entry.merged) {
+      addrs_.remove(entry.addr);
+    }
+    head_ = (head_ + 1) % Capacity;
+    --size_;
+  }
+
+private:
+
+  struct entry_t {
+    T        data;
+    uint64_t addr;
+    uint64_t ready;
+    bool     merged;
+  };
+
+  std::array<entry_t, Capacity> entries_;
+  detail::AddrHash<Capacity> addrs_;
+  uint32_t head_;
+  uint32_t size_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Timing wheel of in-flight responses that may complete out of order.
+// Entries are linked into the slot of their completion cycle and moved to
+// a ready list as the wheel advances; latencies must be below Slots.
+template <typename T, uint32_t Capacity, uint32_t Slots = 64>
+class TimingWheel {
+public:
+  TimingWheel() {
+    this->clear();
+  }
+
+  void clear() {
+    for (uint32_t i = 0; i < Slots; ++i) {
+      slots_[i] = {Nil, Nil};
+    }
+    ready_ = {Nil, Nil};
+    free_ = 0;
+    for (uint32_t i = 0; i < Capacity; ++i) {
+      entries_[i].next = i + 1;
+    }
+    entries_[Capacity - 1].next = Nil;
+    cycle_ = 0;
+    size_ = 0;
+  }
+
+  bool empty() const {
+    return (0 == size_);
+  }
+
+  bool full() const {
+    return (size_ == Capacity);
+  }
+
+  uint32_t size() const {
+    return size_;
+  }
+
+  // move the responses due up to the given cycle to the ready list
+  void advance(uint64_t cycle) {
+    for (uint32_t n = 0; cycle_ < cycle && n < Slots; ++n) {
+      ++cycle_;
+      auto& slot = slots_[cycle_ % Slots];
+      if (slot.head != Nil) {
+        this->append(ready_, slot);
+        slot = {Nil, Nil};
+      }
+    }
+    cycle_ = cycle;
+  }
+
+  // schedule a response for the given cycle and return its payload slot
+  T& push(uint64_t ready) {
+    assert(!this->full());
+    assert(ready < cycle_ + Slots);
+    uint32_t index = free_;
+    free_ = entries_[index].next;
+    entries_[index].next = Nil;
+    list_t item{index, index};
+    if (ready <= cycle_) {
+      this->append(ready_, item);
+    } else {
+      this->append(slots_[ready % Slots], item);
+    }
+    ++size_;
+    return entries_[index].data;
+  }
+
+  bool ready() const {
+    return (ready_.head != Nil);
+  }
+
+  T& front() {
+    assert(this->ready());
+    return entries_[ready_.head].data;
+  }
+
+  void pop() {
+    assert(this->ready());
+    uint32_t index = ready_.head;
+    ready_.head = entries_[index].next;
+    if (ready_.head == Nil) {
+      ready_.tail = Nil;
+    }
+    entries_[index].next = free_;
+    free_ = index;
+    --size_;
+  }
+
+private:
+
+  static constexpr uint32_t Nil = Capacity;
+
+  struct entry_t {
+    T        data;
+    uint32_t next;
+  };
+
+  struct list_t {
+    uint32_t head;
+    uint32_t tail;
+  };
+
+  void append(list_t& dst, const list_t& src) {
+    if (dst.head == Nil) {
+      dst.head = src.head;
+    } else {
+      entries_[dst.tail].next = src.head;
+    }
+    dst.tail = src.tail;
+  }
+
+  std::array<entry_t, Capacity> entries_;
+  std::array<list_t, Slots> slots_;
+  list_t   ready_;
+  uint32_t free_;
+  uint64_t cycle_;
+  uint32_t size_;
+};
+
+}
@@ -0,0 +1,58 @@
+#include "perf_trace.h"
+#include <iostream>
+
+using namespace vortex;
+
+PerfTrace::PerfTrace(const char* filename, uint32_t interval)
+  : ofs_(filename)
+  , interval_(interval ? interval : 1)
+  , empty_(true) {
+  if (!ofs_.is_open()) {
+    std::cerr << "*** error: cannot open perf trace file " << filename << std::endl;
+    return;
+  }
+  ofs_ << "{\"displayTimeUnit\":\"ns\","
+       << "\"otherData\":{\"time_unit\":\"cycles\",\"interval\":" << interval_ << "},"
+       << "\"traceEvents\":[";
+}
+
+PerfTrace::~PerfTrace() {
+  if (!ofs_.is_open())
+    return;
+  ofs_ << "\n]}\n";
+  ofs_.close();
+}
+
+void PerfTrace::add_core(int core_id) {
+  if (!cores_.insert(core_id).second)
+    return;
+  ofs_ << (empty_ ? "\n" : ",\n")
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << core_id
+       << ",\"args\":{\"name\":\"core " << core_id << "\"}},\n"
+       << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":" << core_id
+       << ",\"args\":{\"sort_index\":" << core_id << "}}";
+  empty_ = false;
+}
+
+void PerfTrace::counter(int core_id, uint64_t cycle, const char* track, std::initializer_list<value_t> values) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!ofs_.is_open())
+    return;
+  this->add_core(core_id);
+  ofs_ << ",\n{\"name\":\"" << track << "\",\"ph\":\"C\",\"pid\":" << core_id
+       << ",\"ts\":" << cycle << ",\"args\":{";
+  bool first = true;
+  for (auto& value : values) {
+    ofs_ << (first ? "" : ",") << "\"" << value.first << "\":" << value.second;
+    first = false;
+  }
+  ofs_ << "}}";
+}
+
+uint64_t PerfTrace::delta(int core_id, const char* name, uint64_t value) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& last = last_values_[std::make_pair(core_id, std::string(name))];
+  auto ret = (value >= last) ? (value - last) : value;
+  last = value;
+  return ret;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <mutex>
+
+namespace vortex {
+
+// Periodic per-core performance samples written as a Chrome trace
+// (chrome://tracing, ui.perfetto.dev) in JSON object format.
+// Each core is a process (pid = core id) with one counter track per metric
+// group; timestamps are simulation cycles shown as microseconds.
+class PerfTrace {
+public:
+  typedef std::pair<const char*, double> value_t;
+
+  PerfTrace(const char* filename, uint32_t interval);
+  ~PerfTrace();
+
+  bool is_open() const {
+    return ofs_.is_open();
+  }
+
+  // sampling period in cycles
+  uint32_t interval() const {
+    return interval_;
+  }
+
+  // emit a counter track sample, values of the same track are stacked
+  void counter(int core_id, uint64_t cycle, const char* track, std::initializer_list<value_t> values);
+
+  // convert a running counter into its increment since the previous sample,
+  // a counter smaller than its previous value was reset and is returned as is
+  uint64_t delta(int core_id, const char* name, uint64_t value);
+
+private:
+
+  void add_core(int core_id);
+
+  std::ofstream ofs_;
+  uint32_t interval_;
+  bool empty_;
+  std::set<int> cores_;
+  std::map<std::pair<int, std::string>, uint64_t> last_values_;
+  std::mutex mutex_;
+};
+
+}
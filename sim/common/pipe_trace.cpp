@@ -0,0 +1,138 @@
+#include "pipe_trace.h"
+#include <iostream>
+
+using namespace vortex;
+
+static const char* ex_names[] = {"NOP", "ALU", "LSU", "CSR", "FPU", "GPU"};
+
+PipeTrace::PipeTrace(const char* filename)
+  : ofs_(filename)
+  , cycle_(0)
+  , next_id_(0)
+  , retired_(0)
+  , started_(false) {
+  if (!ofs_.is_open()) {
+    std::cerr << "*** error: cannot open pipeline trace file " << filename << std::endl;
+    return;
+  }
+  ofs_ << "Kanata\t0004\n";
+}
+
+PipeTrace::~PipeTrace() {
+  if (!ofs_.is_open())
+    return;
+  // close instructions still in flight as flushed
+  for (auto& it : instrs_) {
+    for (auto& instr : it.second) {
+      ofs_ << "R\t" << instr.id << "\t" << instr.id << "\t1\n";
+    }
+  }
+  ofs_.close();
+}
+
+void PipeTrace::set_cycle(uint64_t cycle) {
+  if (!started_) {
+    ofs_ << "C=\t" << cycle << "\n";
+    cycle_ = cycle;
+    started_ = true;
+  } else if (cycle > cycle_) {
+    ofs_ << "C\t" << (cycle - cycle_) << "\n";
+    cycle_ = cycle;
+  }
+}
+
+void PipeTrace::start_stage(instr_t& instr, int stage, const std::string& name) {
+  this->end_stage(instr);
+  ofs_ << "S\t" << instr.id << "\t0\t" << name << "\n";
+  instr.stage = stage;
+  instr.name = name;
+}
+
+void PipeTrace::end_stage(instr_t& instr) {
+  if (instr.name.empty())
+    return;
+  ofs_ << "E\t" << instr.id << "\t0\t" << instr.name << "\n";
+  instr.name.clear();
+}
+
+void PipeTrace::event(uint64_t cycle, int core_id, int type, int wid, uint32_t PC, int arg) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!ofs_.is_open())
+    return;
+
+  this->set_cycle(cycle);
+
+  auto key = std::make_tuple(core_id, wid, PC);
+
+  if (type == FETCH) {
+    instr_t instr{next_id_++, FETCH, 0, 0, ""};
+    ofs_ << "I\t" << instr.id << "\t" << instr.id << "\t" << core_id << "\n";
+    ofs_ << "L\t" << instr.id << "\t0\t" << std::hex << PC << std::dec
+         << " core" << core_id << " wid=" << wid << "\n";
+    this->start_stage(instr, FETCH, "F");
+    instrs_[key].push_back(instr);
+    return;
+  }
+
+  auto it = instrs_.find(key);
+  if (it == instrs_.end())
+    return;
+  auto& queue = it->second;
+
+  // the oldest instance that has not reached this stage yet,
+  // issue and stall events repeat while at the ibuffer head
+  int stage = (type == ISSUE || type == STALL) ? EXECUTE : type;
+  auto instr = queue.begin();
+  while (instr != queue.end() && instr->stage >= stage) {
+    ++instr;
+  }
+  if (instr == queue.end())
+    return;
+
+  switch (type) {
+  case DECODE:
+    if (instr->stage == FETCH)
+      this->start_stage(*instr, DECODE, "D");
+    break;
+  case IBUFFER:
+    if (instr->stage == DECODE)
+      this->start_stage(*instr, IBUFFER, "Ib");
+    break;
+  case ISSUE:
+    if (instr->stage == IBUFFER)
+      this->start_stage(*instr, ISSUE, "Is");
+    break;
+  case STALL:
+    if (instr->stage == ISSUE) {
+      if (arg == 1) {
+        ++instr->sb_stalls;
+      } else {
+        ++instr->dp_stalls;
+      }
+    }
+    break;
+  case EXECUTE:
+    if (instr->stage == IBUFFER || instr->stage == ISSUE) {
+      std::string name("X:");
+      name += (arg >= 0 && arg < 6) ? ex_names[arg] : "?";
+      this->start_stage(*instr, EXECUTE, name);
+    }
+    break;
+  case COMMIT:
+    if (instr->stage == EXECUTE) {
+      if (instr->sb_stalls || instr->dp_stalls) {
+        ofs_ << "L\t" << instr->id << "\t1\tscoreboard stalls: " << instr->sb_stalls
+             << ", dispatch stalls: " << instr->dp_stalls << "\n";
+      }
+      this->end_stage(*instr);
+      ofs_ << "R\t" << instr->id << "\t" << retired_++ << "\t0\n";
+      queue.erase(instr);
+      if (queue.empty()) {
+        instrs_.erase(it);
+      }
+    }
+    break;
+  default:
+    break;
+  }
+}
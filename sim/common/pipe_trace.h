@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <deque>
+#include <tuple>
+#include <mutex>
+
+namespace vortex {
+
+// Per-instruction pipeline lifetimes written in the Kanata log format
+// (Konata pipeline viewer). Instructions are tracked by core, warp and PC;
+// in-flight instances of the same PC are matched in program order.
+class PipeTrace {
+public:
+  // pipeline events, must match the PIPE_* definitions in util_dpi.vh
+  enum {
+    FETCH   = 0, // icache request
+    DECODE  = 1, // icache response
+    IBUFFER = 2, // decoded into the instruction buffer
+    ISSUE   = 3, // at the head of the instruction buffer
+    STALL   = 4, // head not issued, arg: 1=scoreboard, 2=dispatch
+    EXECUTE = 5, // dispatched, arg: execute unit type
+    COMMIT  = 6, // committed
+  };
+
+  PipeTrace(const char* filename);
+  ~PipeTrace();
+
+  bool is_open() const {
+    return ofs_.is_open();
+  }
+
+  void event(uint64_t cycle, int core_id, int type, int wid, uint32_t PC, int arg);
+
+private:
+
+  struct instr_t {
+    uint64_t id;
+    int      stage;
+    uint32_t sb_stalls;
+    uint32_t dp_stalls;
+    std::string name;
+  };
+
+  typedef std::tuple<int, int, uint32_t> key_t;
+
+  void set_cycle(uint64_t cycle);
+  void start_stage(instr_t& instr, int stage, const std::string& name);
+  void end_stage(instr_t& instr);
+
+  std::ofstream ofs_;
+  std::map<key_t, std::deque<instr_t>> instrs_;
+  uint64_t cycle_;
+  uint64_t next_id_;
+  uint64_t retired_;
+  bool started_;
+  std::mutex mutex_;
+};
+
+}
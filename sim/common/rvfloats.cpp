@@ -1,6 +1,10 @@
 #include "rvfloats.h"
 #include <stdio.h>
 
+// per-thread rounding mode and exception flags so that FPU models can run
+// on Verilator worker threads, must match the softfloat library build
+#define THREAD_LOCAL __thread
+
 extern "C" {
 #include <softfloat.h>
 #include <softfloat/source/include/internals.h>
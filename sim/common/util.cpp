@@ -1,5 +1,6 @@
 #include "util.h"
 #include <string.h>
+#include <iomanip>
 
 // return file extension
 const char* fileExtension(const char* filepath) {
@@ -7,4 +8,13 @@ const char* fileExtension(const char* filepath) {
     if (ext == NULL || ext == filepath) 
       return "";
     return ext + 1;
-}
\ No newline at end of file
+}
+
+void print_throughput(std::ostream& out, uint64_t cycles, std::chrono::steady_clock::duration time) {
+  double secs = std::chrono::duration<double>(time).count();
+  out << std::fixed << std::setprecision(3)
+      << "PERF: sim throughput: cycles=" << cycles
+      << ", time=" << secs << "s"
+      << ", cycles/s=" << std::setprecision(0) << (secs > 0 ? cycles / secs : 0)
+      << std::defaultfloat << std::endl;
+}
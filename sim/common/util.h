@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <chrono>
+#include <ostream>
 #include <assert.h>
 
 template <typename... Args>
@@ -29,4 +31,7 @@ inline uint32_t signExt(uint32_t w, uint32_t bit, uint32_t mask) {
 }
 
 // return file extension
-const char* fileExtension(const char* filepath);
\ No newline at end of file
+const char* fileExtension(const char* filepath);
+
+// print simulated cycles per second of wall time spent stepping the model
+void print_throughput(std::ostream& out, uint64_t cycles, std::chrono::steady_clock::duration time);
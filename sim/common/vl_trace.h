@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+#include <util.h>
+
+#ifdef TRACE_ENABLE
+#include <verilated.h>
+#ifdef TRACE_FST
+#include <verilated_fst_c.h>
+#else
+#include <verilated_vcd_c.h>
+#endif
+#endif
+
+namespace vortex {
+
+// Waveform trace settings, selected at runtime. The cycle window also gates
+// the DPI debug trace.
+struct TraceConfig {
+  bool        enabled;    // write a waveform (requires a TRACE build)
+  uint64_t    start;      // first traced cycle
+  uint64_t    stop;       // first cycle past the window
+  int         depth;      // hierarchy levels below the top module
+  std::string filename;
+
+  TraceConfig()
+  #ifdef NDEBUG
+    : enabled(false)
+  #else
+    : enabled(true)
+  #endif
+    , start(0)
+    , stop(-1ull)
+    , depth(99)
+  #ifdef TRACE_FST
+    , filename("trace.fst")
+  #else
+    , filename("trace.vcd")
+  #endif
+  {}
+
+  // VORTEX_TRACE_FILE, VORTEX_TRACE_START, VORTEX_TRACE_STOP and
+  // VORTEX_TRACE_DEPTH, a file or window enables tracing unless VORTEX_TRACE=0
+  void load_env() {
+    const char* value;
+    if ((value = getenv("VORTEX_TRACE_FILE"))) {
+      filename = value;
+      enabled = true;
+    }
+    if ((value = getenv("VORTEX_TRACE_START"))) {
+      start = strtoull(value, nullptr, 0);
+      enabled = true;
+    }
+    if ((value = getenv("VORTEX_TRACE_STOP"))) {
+      stop = strtoull(value, nullptr, 0);
+      enabled = true;
+    }
+    if ((value = getenv("VORTEX_TRACE_DEPTH"))) {
+      depth = atoi(value);
+    }
+    if ((value = getenv("VORTEX_TRACE"))) {
+      enabled = (atoi(value) != 0);
+    }
+  }
+
+  bool in_window(uint64_t cycle) const {
+    return (cycle >= start && cycle < stop);
+  }
+};
+
+// Attaches the waveform writer to the model only while the cycle window is
+// open, so that untraced cycles run at full speed.
+template <typename Model>
+class VlTracer {
+public:
+  VlTracer(Model* model)
+    : model_(model)
+  #ifdef TRACE_ENABLE
+    , tfp_(nullptr)
+  #endif
+    , next_(-1ull)
+  {}
+
+  ~VlTracer() {
+    this->close();
+  }
+
+  void configure(const TraceConfig& config) {
+    this->close();
+    config_ = config;
+  #ifdef TRACE_ENABLE
+    next_ = config_.enabled ? (config_.start * 2) : -1ull;
+  #else
+    if (config_.enabled) {
+      std::cout << "*** warning: waveform tracing requires a TRACE build." << std::endl;
+    }
+  #endif
+  }
+
+  const TraceConfig& config() const {
+    return config_;
+  }
+
+  // called after each evaluation, two per cycle
+  void dump(uint64_t timestamp) {
+  #ifdef TRACE_ENABLE
+    if (timestamp < next_)
+      return;
+    if (nullptr == tfp_) {
+      if (timestamp / 2 >= config_.stop) {
+        next_ = -1ull;
+        return;
+      }
+      this->open(timestamp);
+    } else if (timestamp / 2 >= config_.stop) {
+      this->close();
+      return;
+    }
+    tfp_->dump(timestamp);
+  #else
+    __unused(timestamp);
+  #endif
+  }
+
+  void close() {
+  #ifdef TRACE_ENABLE
+    if (tfp_) {
+      tfp_->close();
+      delete tfp_;
+      tfp_ = nullptr;
+    }
+  #endif
+    next_ = -1ull;
+  }
+
+private:
+
+#ifdef TRACE_ENABLE
+  void open(uint64_t timestamp) {
+  #ifdef TRACE_FST
+    tfp_ = new VerilatedFstC();
+  #else
+    tfp_ = new VerilatedVcdC();
+  #endif
+    model_->trace(tfp_, config_.depth);
+    tfp_->open(config_.filename.c_str());
+    std::cout << std::dec << timestamp << ": [sim] tracing to " << config_.filename << std::endl;
+    // dump every evaluation while open
+    next_ = 0;
+  }
+#endif
+
+  Model* model_;
+#ifdef TRACE_ENABLE
+#ifdef TRACE_FST
+  VerilatedFstC* tfp_;
+#else
+  VerilatedVcdC* tfp_;
+#endif
+#endif
+  TraceConfig config_;
+  uint64_t next_;
+};
+
+}
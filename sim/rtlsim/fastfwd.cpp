@@ -0,0 +1,306 @@
+#include "fastfwd.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <VX_config.h>
+#include <mem.h>
+#include "archdef.h"
+#include "decode.h"
+#include "core.h"
+
+using namespace vortex;
+
+// Hand-off layout below STARTUP_ADDR (all regions must be unused by the program):
+//
+//   0x7FFFE000  x31 of each thread, indexed by GTID (only x31 is free to
+//               address it: ori -2048, slli 3, srli 1 maps GTID to it)
+//   0x7FFF0000  one 32-byte resume trampoline per warp, indexed by GWID
+//   STUB_CODE   boot code executed by warp 0 of every core out of reset
+//   below       per-thread register records and per-core shared memory images
+//
+#define X31_TABLE_ADDR    0x7FFFE000
+#define TRAMPOLINE_ADDR   0x7FFF0000
+#define TRAMPOLINE_SIZE   32
+#define STUB_CODE_ADDR    0x7FFEF000
+#define THREAD_REC_SIZE   512
+#define THREAD_REC_FREGS  128
+#define THREAD_REC_FCSR   256
+#define THREAD_REC_TMASK  260
+
+namespace {
+
+enum {
+  x0 = 0, t0 = 5, t1 = 6, t2 = 7, t3 = 28, x31 = 31
+};
+
+// minimal RV32 encoder for the boot stub
+class Asm {
+public:
+  Asm(uint32_t base) : base_(base) {}
+
+  uint32_t pc() const {
+    return base_ + 4 * code_.size();
+  }
+
+  const std::vector<uint32_t>& code() const {
+    return code_;
+  }
+
+  void emit(uint32_t inst) {
+    code_.push_back(inst);
+  }
+
+  void r_type(uint32_t op, uint32_t f3, uint32_t f7, int rd, int rs1, int rs2) {
+    this->emit((f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op);
+  }
+
+  void i_type(uint32_t op, uint32_t f3, int rd, int rs1, int32_t imm) {
+    this->emit(((imm & 0xfff) << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op);
+  }
+
+  void s_type(uint32_t op, uint32_t f3, int rs1, int rs2, int32_t imm) {
+    this->emit((((imm >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | ((imm & 0x1f) << 7) | op);
+  }
+
+  // lui + addi, always two instructions
+  void li(int rd, uint32_t value) {
+    uint32_t hi = (value + 0x800) & 0xfffff000;
+    this->emit(hi | (rd << 7) | 0x37);
+    this->i_type(0x13, 0, rd, rd, value - hi);
+  }
+
+  void addi(int rd, int rs1, int32_t imm) { this->i_type(0x13, 0, rd, rs1, imm); }
+  void ori(int rd, int rs1, int32_t imm)  { this->i_type(0x13, 6, rd, rs1, imm); }
+  void slli(int rd, int rs1, int shamt)   { this->i_type(0x13, 1, rd, rs1, shamt); }
+  void srli(int rd, int rs1, int shamt)   { this->i_type(0x13, 5, rd, rs1, shamt); }
+  void add(int rd, int rs1, int rs2)      { this->r_type(0x33, 0, 0, rd, rs1, rs2); }
+  void mul(int rd, int rs1, int rs2)      { this->r_type(0x33, 0, 1, rd, rs1, rs2); }
+  void lw(int rd, int rs1, int32_t imm)   { this->i_type(0x03, 2, rd, rs1, imm); }
+  void flw(int rd, int rs1, int32_t imm)  { this->i_type(0x07, 2, rd, rs1, imm); }
+  void sw(int rs2, int rs1, int32_t imm)  { this->s_type(0x23, 2, rs1, rs2, imm); }
+  void jalr(int rd, int rs1, int32_t imm) { this->i_type(0x67, 0, rd, rs1, imm); }
+  void csrr(int rd, uint32_t csr)         { this->i_type(0x73, 2, rd, x0, csr); }
+  void csrw(uint32_t csr, int rs1)        { this->i_type(0x73, 1, x0, rs1, csr); }
+  void fence()                            { this->emit(0x0000000f); }
+  void nop()                              { this->addi(x0, x0, 0); }
+  void tmc(int rs1)                       { this->s_type(0x6b, 0, rs1, x0, 0); }
+  void wspawn(int num, int pc)            { this->s_type(0x6b, 1, num, pc, 0); }
+
+  void bne(int rs1, int rs2, uint32_t target) {
+    int32_t off = target - this->pc();
+    this->emit((((off >> 12) & 0x1) << 31) | (((off >> 5) & 0x3f) << 25) | (rs2 << 20) | (rs1 << 15)
+             | (1 << 12) | (((off >> 1) & 0xf) << 8) | (((off >> 11) & 0x1) << 7) | 0x63);
+  }
+
+  int jal(int rd, uint32_t target) {
+    int32_t off = target - this->pc();
+    if (off < -(1 << 20) || off >= (1 << 20)) {
+      std::cerr << "*** error: fast-forward resume PC 0x" << std::hex << target
+                << " out of jal range" << std::dec << std::endl;
+      return -1;
+    }
+    this->emit((((off >> 20) & 0x1) << 31) | (((off >> 1) & 0x3ff) << 21) | (((off >> 11) & 0x1) << 20)
+             | (((off >> 12) & 0xff) << 12) | (rd << 7) | 0x6f);
+    return 0;
+  }
+
+private:
+  uint32_t base_;
+  std::vector<uint32_t> code_;
+};
+
+// index -> X31_TABLE_ADDR + index * 4 or TRAMPOLINE_ADDR + index * 32,
+// valid for index < 2048, using x31 only
+void index_to_addr(Asm& a, int shift) {
+  a.ori(x31, x31, -2048);
+  a.slli(x31, x31, shift + 1);
+  a.srli(x31, x31, 1);
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+FastForward::FastForward(RAM* ram)
+  : ram_(ram)
+  , exitcode_(0) {
+  arch_ = std::make_shared<ArchDef>("rv32imf", NUM_CORES * NUM_CLUSTERS, NUM_WARPS, NUM_THREADS);
+  decoder_ = std::make_shared<Decoder>(*arch_);
+  mmu_ = std::make_shared<MemoryUnit>(0, arch_->wsize(), true);
+  mmu_->attach(*ram_, 0, 0xFFFFFFFF);
+  for (int i = 0; i < arch_->num_cores(); ++i) {
+    cores_.push_back(std::make_shared<Core>(*arch_, *decoder_, *mmu_, i));
+  }
+}
+
+FastForward::~FastForward() {}
+
+uint64_t FastForward::instrs() const {
+  uint64_t instrs = 0;
+  for (auto& core : cores_) {
+    instrs += core->num_insts();
+  }
+  return instrs;
+}
+
+bool FastForward::converged() const {
+  for (auto& core : cores_) {
+    if (!core->barriers_idle())
+      return false;
+    for (int w = 0; w < arch_->num_warps(); ++w) {
+      if (!core->warp(w).converged())
+        return false;
+    }
+  }
+  return true;
+}
+
+int FastForward::run(uint64_t instrs) {
+  for (;;) {
+    bool running = false;
+    for (auto& core : cores_) {
+      core->step();
+      if (core->running()) {
+        running = true;
+      }
+      if (core->check_ebreak()) {
+        exitcode_ = core->getIRegValue(3);
+        return 1;
+      }
+    }
+    if (!running) {
+      exitcode_ = 0;
+      return 1;
+    }
+    if (this->instrs() >= instrs && this->converged())
+      return 0;
+  }
+}
+
+int FastForward::write_boot_stub() {
+  int num_cores   = arch_->num_cores();
+  int num_warps   = arch_->num_warps();
+  int num_threads = arch_->num_threads();
+  uint32_t total_warps   = num_cores * num_warps;
+  uint32_t total_threads = total_warps * num_threads;
+
+  if (STARTUP_ADDR != 0x80000000
+   || total_threads > 2048
+   || (TRAMPOLINE_ADDR + total_warps * TRAMPOLINE_SIZE) > X31_TABLE_ADDR) {
+    std::cerr << "*** error: fast-forward hand-off not supported for this configuration" << std::endl;
+    return -1;
+  }
+
+  uint32_t regs_addr = STUB_CODE_ADDR - total_threads * THREAD_REC_SIZE;
+#ifdef SM_ENABLE
+  uint32_t smem_addr = regs_addr - num_cores * SMEM_SIZE;
+#endif
+
+  // per-thread register records and x31 table
+  for (int c = 0; c < num_cores; ++c) {
+    for (int w = 0; w < num_warps; ++w) {
+      auto& warp = cores_.at(c)->warp(w);
+      Word tmask = warp.active() ? warp.getTmask() : 0;
+      Word fcsr = cores_.at(c)->get_csr(CSR_FCSR, 0, w);
+      for (int t = 0; t < num_threads; ++t) {
+        uint32_t gtid = (c * num_warps + w) * num_threads + t;
+        uint32_t rec = regs_addr + gtid * THREAD_REC_SIZE;
+        for (int r = 0; r < 32; ++r) {
+          Word ireg = warp.getIReg(t, r);
+          Word freg = warp.getFReg(t, r);
+          ram_->write(&ireg, rec + 4 * r, 4);
+          ram_->write(&freg, rec + THREAD_REC_FREGS + 4 * r, 4);
+        }
+        ram_->write(&fcsr, rec + THREAD_REC_FCSR, 4);
+        ram_->write(&tmask, rec + THREAD_REC_TMASK, 4);
+        Word x31v = warp.getIReg(t, 31);
+        ram_->write(&x31v, X31_TABLE_ADDR + gtid * 4, 4);
+      }
+    }
+#ifdef SM_ENABLE
+    std::vector<uint8_t> smem(SMEM_SIZE);
+    cores_.at(c)->shared_mem().read(smem.data(), 0, SMEM_SIZE);
+    ram_->write(smem.data(), smem_addr + c * SMEM_SIZE, SMEM_SIZE);
+#endif
+  }
+
+  // per-warp trampolines: restore x31 and jump to the resume PC
+  for (int c = 0; c < num_cores; ++c) {
+    for (int w = 0; w < num_warps; ++w) {
+      uint32_t gwid = c * num_warps + w;
+      Asm a(TRAMPOLINE_ADDR + gwid * TRAMPOLINE_SIZE);
+      a.csrr(x31, CSR_GTID);
+      index_to_addr(a, 2);
+      a.lw(x31, x31, 0);
+      if (a.jal(x0, cores_.at(c)->warp(w).getPC()) != 0)
+        return -1;
+      while (a.code().size() * 4 < TRAMPOLINE_SIZE) {
+        a.nop();
+      }
+      ram_->write(a.code().data(), TRAMPOLINE_ADDR + gwid * TRAMPOLINE_SIZE, TRAMPOLINE_SIZE);
+    }
+  }
+
+  // boot code
+  Asm a(STUB_CODE_ADDR);
+#ifdef SM_ENABLE
+  // copy this core's shared memory image
+  a.csrr(t0, CSR_GCID);
+  a.li(t1, SMEM_SIZE);
+  a.mul(t0, t0, t1);
+  a.li(t1, smem_addr);
+  a.add(t0, t0, t1);
+  a.li(t1, SMEM_BASE_ADDR - SMEM_SIZE);
+  a.li(t2, SMEM_SIZE);
+  a.add(t2, t0, t2);
+  uint32_t loop = a.pc();
+  a.lw(t3, t0, 0);
+  a.sw(t3, t1, 0);
+  a.addi(t0, t0, 4);
+  a.addi(t1, t1, 4);
+  a.bne(t0, t2, loop);
+  a.fence();
+#endif
+  // start all warps at the restore code
+  a.li(t0, num_warps);
+  a.li(t1, a.pc() + 12);
+  a.wspawn(t0, t1);
+  // all threads on, load the register record
+  a.li(t0, (num_threads < 32) ? ((1u << num_threads) - 1) : 0xffffffff);
+  a.tmc(t0);
+  a.csrr(t0, CSR_GTID);
+  a.slli(t0, t0, 9);
+  a.li(t1, regs_addr);
+  a.add(x31, t0, t1);
+#ifdef EXT_F_ENABLE
+  a.lw(t0, x31, THREAD_REC_FCSR);
+  a.csrw(CSR_FCSR, t0);
+  for (int r = 0; r < 32; ++r) {
+    a.flw(r, x31, THREAD_REC_FREGS + 4 * r);
+  }
+#endif
+  for (int r = 1; r < 31; ++r) {
+    a.lw(r, x31, 4 * r);
+  }
+  // apply the warp thread mask, inactive warps halt here
+  a.lw(x31, x31, THREAD_REC_TMASK);
+  a.tmc(x31);
+  // jump to the warp trampoline
+  a.csrr(x31, CSR_GWID);
+  index_to_addr(a, 5);
+  a.jalr(x0, x31, 0);
+
+  if (a.pc() > TRAMPOLINE_ADDR) {
+    std::cerr << "*** error: fast-forward boot stub overflow" << std::endl;
+    return -1;
+  }
+  ram_->write(a.code().data(), STUB_CODE_ADDR, a.code().size() * 4);
+
+  // patch the boot vector, the cores never return to it
+  Asm boot(STARTUP_ADDR);
+  boot.jal(x0, STUB_CODE_ADDR);
+  ram_->write(boot.code().data(), STARTUP_ADDR, 4);
+
+  std::cout << "Fast-forwarded " << this->instrs() << " instructions" << std::endl;
+  return 0;
+}
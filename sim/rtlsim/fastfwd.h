@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vortex {
+
+class RAM;
+class ArchDef;
+class Decoder;
+class MemoryUnit;
+class Core;
+
+// Hybrid simulation: a program runs functionally in simX on the shared RAM,
+// then its architectural state is handed over to the RTL model through a
+// boot stub written below STARTUP_ADDR that the cores execute out of reset.
+class FastForward {
+public:
+  FastForward(RAM* ram);
+  ~FastForward();
+
+  // run until `instrs` thread instructions have executed and every warp has
+  // reconverged, returns 1 if the program exited first (see exitcode())
+  int run(uint64_t instrs);
+
+  int exitcode() const {
+    return exitcode_;
+  }
+
+  uint64_t instrs() const;
+
+  // write the state restore stub and tables to RAM and patch the boot vector
+  int write_boot_stub();
+
+private:
+
+  bool converged() const;
+
+  RAM* ram_;
+  std::shared_ptr<ArchDef> arch_;
+  std::shared_ptr<Decoder> decoder_;
+  std::shared_ptr<MemoryUnit> mmu_;
+  std::vector<std::shared_ptr<Core>> cores_;
+  int exitcode_;
+};
+
+}
@@ -1,28 +1,82 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <unistd.h>
-#include <unistd.h>
+#include <chrono>
 #include <util.h>
 #include <mem.h>
+#include <perf_trace.h>
+#include <pipe_trace.h>
 #include "simulator.h"
+#ifdef FASTFWD_ENABLE
+#include "fastfwd.h"
+#endif
 
 using namespace vortex;
 
 static void show_usage() {
-   std::cout << "Usage: [-r] [-h: help] programs.." << std::endl;
+   std::cout << "Usage: [-r] [-b: batch] [-p: perf trace file] [-n: perf sampling interval] [-k: pipeline trace file] [-s: save snapshot file] [-c: snapshot cycle] [-l: load snapshot file] [-f: fast-forward instructions] [-t: trace file] [-w: trace window start[:stop] cycles] [-d: trace depth] [-h: help] programs.." << std::endl;
 }
 
 bool riscv_test = false;
+bool batch_mode = false;
+const char* perf_trace_file = nullptr;
+uint32_t perf_interval = 1000;
+const char* pipe_trace_file = nullptr;
+const char* snapshot_save_file = nullptr;
+uint64_t snapshot_cycle = 0;
+const char* snapshot_load_file = nullptr;
+uint64_t fastfwd_instrs = 0;
+vortex::TraceConfig trace_config;
 std::vector<const char*> programs;
 
 static void parse_args(int argc, char **argv) {
   	int c;
-  	while ((c = getopt(argc, argv, "rh?")) != -1) {
+  	while ((c = getopt(argc, argv, "rbp:n:k:s:c:l:f:t:w:d:h?")) != -1) {
     	switch (c) {
 		case 'r':
 			riscv_test = true;
 			break;
+		case 'b':
+			batch_mode = true;
+			break;
+		case 'p':
+			perf_trace_file = optarg;
+			break;
+		case 'n':
+			perf_interval = atoi(optarg);
+			break;
+		case 'k':
+			pipe_trace_file = optarg;
+			break;
+		case 's':
+			snapshot_save_file = optarg;
+			break;
+		case 'c':
+			snapshot_cycle = strtoull(optarg, nullptr, 0);
+			break;
+		case 'l':
+			snapshot_load_file = optarg;
+			break;
+		case 'f':
+			fastfwd_instrs = strtoull(optarg, nullptr, 0);
+			break;
+		case 't':
+			trace_config.filename = optarg;
+			trace_config.enabled = true;
+			break;
+		case 'w': {
+			char* end;
+			trace_config.start = strtoull(optarg, &end, 0);
+			if (*end == ':') {
+				trace_config.stop = strtoull(end + 1, nullptr, 0);
+			}
+			trace_config.enabled = true;
+		} break;
+		case 'd':
+			trace_config.depth = atoi(optarg);
+			break;
     	case 'h':
     	case '?':
       		show_usage();
@@ -37,24 +91,77 @@ static void parse_args(int argc, char **argv) {
 	for (int i = optind; i < argc; ++i) {
 		programs.push_back(argv[i]);	
 	}
+
+	// the snapshot already holds the program
+	if (snapshot_load_file) {
+		programs.assign(1, snapshot_load_file);
+	}
+
+	if (batch_mode && (snapshot_load_file || snapshot_save_file)) {
+		std::cout << "*** error: batch mode does not support snapshots." << std::endl;
+		exit(-1);
+	}
 }
 
+struct batch_result_t {
+	const char* program;
+	int exitcode;
+	bool passed;
+	uint64_t cycles;
+	double secs;
+};
+
 int main(int argc, char **argv) {
 
 	int exitcode = 0;
+	int failed_exitcode = 0;
 	bool failed = false;
 	
+	// command line options override the environment
+	trace_config.load_env();
 	parse_args(argc, argv);
 
+	std::shared_ptr<PerfTrace> perf_trace;
+	if (perf_trace_file) {
+		perf_trace = std::make_shared<PerfTrace>(perf_trace_file, perf_interval);
+	}
+
+	std::shared_ptr<PipeTrace> pipe_trace;
+	if (pipe_trace_file) {
+		pipe_trace = std::make_shared<PipeTrace>(pipe_trace_file);
+	}
+
+	// batch mode builds the model once and resets it between programs
+	std::unique_ptr<vortex::Simulator> batch_simulator;
+	std::vector<batch_result_t> batch_results;
+	if (batch_mode) {
+		batch_simulator.reset(new vortex::Simulator());
+	}
+
 	for (auto program : programs) {
 		std::cout << "Running " << program << "..." << std::endl;
+		auto start_time = std::chrono::steady_clock::now();
 
 		vortex::RAM ram((1<<12), (1<<20));
-		vortex::Simulator simulator;
+		std::unique_ptr<vortex::Simulator> local_simulator;
+		if (!batch_mode) {
+			local_simulator.reset(new vortex::Simulator());
+		}
+		auto& simulator = batch_mode ? *batch_simulator : *local_simulator;
 		simulator.attach_ram(&ram);
+		simulator.attach_perf_trace(perf_trace.get());
+		simulator.attach_pipe_trace(pipe_trace.get());
+		simulator.set_trace(trace_config);
+		if (batch_mode && !batch_results.empty()) {
+			simulator.reset();
+		}
+		uint64_t start_cycles = simulator.cycles();
 
 		std::string program_ext(fileExtension(program));
-		if (program_ext == "bin") {
+		if (snapshot_load_file) {
+			if (simulator.restore_snapshot(snapshot_load_file) != 0)
+				return -1;
+		} else if (program_ext == "bin") {
 			ram.loadBinImage(program, STARTUP_ADDR);
 		} else if (program_ext == "hex") {
 			ram.loadHexImage(program);
@@ -63,25 +170,75 @@ int main(int argc, char **argv) {
 			return -1;
 		}
 
-		exitcode = simulator.run();
+		if (snapshot_save_file) {
+			simulator.set_snapshot(snapshot_cycle, snapshot_save_file);
+		}
+
+		bool completed = false;
+		if (fastfwd_instrs != 0 && !snapshot_load_file) {
+#ifdef FASTFWD_ENABLE
+			vortex::FastForward fastfwd(&ram);
+			if (fastfwd.run(fastfwd_instrs)) {
+				// the program exited before the hand-off point
+				std::cout << "Completed in fast-forward after " << fastfwd.instrs() << " instructions" << std::endl;
+				exitcode = fastfwd.exitcode();
+				completed = true;
+			} else if (fastfwd.write_boot_stub() != 0) {
+				return -1;
+			}
+#else
+			std::cout << "*** error: fast-forward requires a FASTFWD=1 build." << std::endl;
+			return -1;
+#endif
+		}
+
+		if (!completed) {
+			exitcode = simulator.run();
+		}
 		
+		bool passed = riscv_test ? (1 == exitcode) : (0 == exitcode);
 		if (riscv_test) {
-			if (1 == exitcode) {
+			if (passed) {
 				std::cout << "Passed" << std::endl;
 			} else {
 				std::cout << "Failed: exitcode=" << exitcode << std::endl;
-				failed = true;
 			}
 		} else {
-			if (exitcode != 0) {
+			if (!passed) {
 				std::cout << "*** error: exitcode=" << exitcode << std::endl;
-				failed = true;
 			}
 		}	
+
+		if (batch_mode) {
+			double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+			batch_results.push_back({program, exitcode, passed, simulator.cycles() - start_cycles, secs});
+			if (!passed && !failed) {
+				failed = true;
+				failed_exitcode = exitcode;
+			}
+			continue;
+		}
 		
-		if (failed)
+		if (!passed) {
+			failed = true;
+			failed_exitcode = exitcode;
 			break;
+		}
+	}
+
+	if (batch_mode) {
+		int num_failed = 0;
+		std::cout << "Batch results:" << std::endl;
+		for (auto& result : batch_results) {
+			std::cout << "  " << result.program << ": " << (result.passed ? "passed" : "failed")
+			          << ", exitcode=" << result.exitcode 
+			          << ", cycles=" << result.cycles
+			          << ", time=" << std::fixed << std::setprecision(3) << result.secs << "s" 
+			          << std::defaultfloat << std::endl;
+			num_failed += !result.passed;
+		}
+		std::cout << "Batch: " << batch_results.size() << " programs, " << num_failed << " failed" << std::endl;
 	}
 
-	return failed ? exitcode : 0;
+	return failed ? (failed_exitcode ? failed_exitcode : -1) : 0;
 }
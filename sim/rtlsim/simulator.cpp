@@ -10,36 +10,20 @@
 #include "VVortex__Syms.h"
 #endif
 
-#ifdef VCD_OUTPUT
-#include <verilated_vcd_c.h>
+#ifdef SAVABLE_ENABLE
+#include <verilated_save.h>
 #endif
 
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <atomic>
+#include <type_traits>
+#include <util.h>
 #include <mem.h>
-
-#define ENABLE_MEM_STALLS
-
-#ifndef TRACE_START_TIME
-#define TRACE_START_TIME 0ull
-#endif
-
-#ifndef TRACE_STOP_TIME
-#define TRACE_STOP_TIME -1ull
-#endif
-
-#ifndef MEM_LATENCY
-#define MEM_LATENCY 24
-#endif
-
-#ifndef MEM_RQ_SIZE
-#define MEM_RQ_SIZE 16
-#endif
-
-#ifndef MEM_STALLS_MODULO
-#define MEM_STALLS_MODULO 16
-#endif
+#include <perf_trace.h>
+#include <pipe_trace.h>
+#include <vl_trace.h>
 
 #ifndef VERILATOR_RESET_VALUE
 #define VERILATOR_RESET_VALUE 2
@@ -50,6 +34,7 @@
 
 using namespace vortex;
 
+// only advanced between evaluations, DPI calls may read it from worker threads
 static uint64_t timestamp = 0;
 
 double sc_time_stamp() { 
@@ -58,13 +43,15 @@ double sc_time_stamp() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static bool trace_enabled = false;
-static uint64_t trace_start_time = TRACE_START_TIME;
-static uint64_t trace_stop_time = TRACE_STOP_TIME;
+// toggled by DPI calls on any Verilator worker thread
+static std::atomic<bool> trace_enabled(false);
+static uint64_t trace_start_cycle = 0;
+static uint64_t trace_stop_cycle = -1ull;
 
 bool sim_trace_enabled() {
-  if (timestamp >= trace_start_time 
-   && timestamp < trace_stop_time)
+  uint64_t cycle = timestamp / 2;
+  if (cycle >= trace_start_cycle 
+   && cycle < trace_stop_cycle)
     return true;
   return trace_enabled;
 }
@@ -75,16 +62,29 @@ void sim_trace_enable(bool enable) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static PerfTrace* perf_trace = nullptr;
+
+PerfTrace* sim_perf_trace() {
+  return perf_trace;
+}
+
+static PipeTrace* pipe_trace = nullptr;
+
+PipeTrace* sim_pipe_trace() {
+  return pipe_trace;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 namespace vortex {
 class VL_OBJ {
 public:
 #ifdef AXI_BUS
   VVortex_axi *device;
+  VlTracer<VVortex_axi> *tracer;
 #else
   VVortex *device;
-#endif
-#ifdef VCD_OUTPUT
-  VerilatedVcdC *trace;
+  VlTracer<VVortex> *tracer;
 #endif
 
   VL_OBJ() {
@@ -95,25 +95,21 @@ public:
     // Turn off assertion before reset
     Verilated::assertOn(false);
 
+  #ifdef TRACE_ENABLE
+    Verilated::traceEverOn(true);
+  #endif
+
   #ifdef AXI_BUS
     this->device = new VVortex_axi();
+    this->tracer = new VlTracer<VVortex_axi>(this->device);
   #else
     this->device = new VVortex();
-  #endif
-
-  #ifdef VCD_OUTPUT
-    Verilated::traceEverOn(true);
-    this->trace = new VerilatedVcdC();
-    this->device->trace(this->trace, 99);
-    this->trace->open("trace.vcd");
+    this->tracer = new VlTracer<VVortex>(this->device);
   #endif
   }
 
   ~VL_OBJ() {
-  #ifdef VCD_OUTPUT
-    this->trace->close();
-    delete this->trace;
-  #endif
+    delete this->tracer;
     delete this->device;
   }
 };
@@ -121,21 +117,42 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Simulator::Simulator() {
+Simulator::Simulator() 
+  : step_cycles_(0)
+  , step_time_(0)
+  , snapshot_cycle_(0) {
   vl_obj_ = new VL_OBJ();
   ram_ = nullptr;
+
+  DramConfig dram_config;
+  if (0 == dram_config.load_env()) {
+    dram_ = DramSim(dram_config);
+  }
+
+  TraceConfig trace_config;
+  trace_config.load_env();
+  this->set_trace(trace_config);
+
   // reset the device
   this->reset();
 }
 
 Simulator::~Simulator() {
+  this->flush_prints();
+  if (getenv("VORTEX_SIM_THROUGHPUT")) {
+    print_throughput(std::cout, step_cycles_, step_time_);
+  }
+  delete vl_obj_;
+}
+
+void Simulator::flush_prints() {
   for (auto& buf : print_bufs_) {
     auto str = buf.second.str();
     if (!str.empty()) {
       std::cout << "#" << buf.first << ": " << str << std::endl;
     }
   }
-  delete vl_obj_;
+  print_bufs_.clear();
 }
 
 void Simulator::attach_ram(RAM* ram) {
@@ -146,12 +163,45 @@ void Simulator::attach_ram(RAM* ram) {
   last_mem_rsp_bank_ = 0;
 }
 
+void Simulator::attach_perf_trace(PerfTrace* trace) {
+#ifndef PERF_TRACE_ENABLE
+  if (trace) {
+    std::cout << "*** warning: performance sampling requires a PERF_TRACE=1 build." << std::endl;
+  }
+#endif
+  perf_trace = trace;
+}
+
+void Simulator::attach_pipe_trace(PipeTrace* trace) {
+#ifndef PIPE_TRACE_ENABLE
+  if (trace) {
+    std::cout << "*** warning: pipeline trace requires a PIPE_TRACE=1 build." << std::endl;
+  }
+#endif
+  pipe_trace = trace;
+}
+
+void Simulator::set_dram_config(const DramConfig& config) {
+  dram_ = DramSim(config);
+}
+
+void Simulator::set_trace(const TraceConfig& config) {
+  trace_start_cycle = config.start;
+  trace_stop_cycle = config.stop;
+  vl_obj_->tracer->configure(config);
+}
+
 void Simulator::reset() { 
-  print_bufs_.clear();
+  // no assertions while the design comes out of reset
+  Verilated::assertOn(false);
+
+  // keep the pending output of the previous program
+  this->flush_prints();
 
   for (int b = 0; b < MEMORY_BANKS; ++b) {
     mem_rsp_vec_[b].clear();
   }
+  dram_.reset();
   last_mem_rsp_bank_ = 0;
   mem_rd_rsp_active_ = false;
   mem_wr_rsp_active_ = false;
@@ -178,6 +228,7 @@ void Simulator::reset() {
 }
 
 void Simulator::step() {
+  auto start_time = std::chrono::steady_clock::now();
 
   vl_obj_->device->clk = 0;
   this->eval();
@@ -197,6 +248,9 @@ void Simulator::step() {
   this->eval_mem_bus(1);
 #endif
 
+  step_time_ += std::chrono::steady_clock::now() - start_time;
+  ++step_cycles_;
+
 #ifndef NDEBUG
   fflush(stdout);
 #endif
@@ -204,11 +258,7 @@ void Simulator::step() {
 
 void Simulator::eval() {
   vl_obj_->device->eval();
-#ifdef VCD_OUTPUT
-  if (sim_trace_enabled()) {
-    vl_obj_->trace->dump(timestamp);
-  }
-#endif
+  vl_obj_->tracer->dump(timestamp);
   ++timestamp;
 }
 
@@ -236,13 +286,7 @@ void Simulator::eval_axi_bus(bool clk) {
     return;
   }
 
-  // update memory responses schedule
-  for (int b = 0; b < MEMORY_BANKS; ++b) {    
-    for (auto& rsp : mem_rsp_vec_[b]) {
-      if (rsp.cycles_left > 0)
-        rsp.cycles_left -= 1;
-    }
-  }
+  uint64_t cycle = timestamp / 2;
 
   bool has_rd_response = false;
   bool has_wr_response = false;
@@ -250,14 +294,12 @@ void Simulator::eval_axi_bus(bool clk) {
   // schedule memory responses that are ready
   for (int i = 0; i < MEMORY_BANKS; ++i) {
     uint32_t b = (i + last_mem_rsp_bank_ + 1) % MEMORY_BANKS;
-    if (!mem_rsp_vec_[b].empty()) {
-      auto mem_rsp_it = mem_rsp_vec_[b].begin();
-      if (mem_rsp_it->cycles_left <= 0) {
-          has_rd_response = !mem_rsp_it->write;
-          has_wr_response = mem_rsp_it->write;
-          last_mem_rsp_bank_ = b;
-          break;
-      }
+    if (mem_rsp_vec_[b].ready(cycle)) {
+      auto& mem_rsp = mem_rsp_vec_[b].front();
+      has_rd_response = !mem_rsp.write;
+      has_wr_response = mem_rsp.write;
+      last_mem_rsp_bank_ = b;
+      break;
     }
   }
 
@@ -268,20 +310,20 @@ void Simulator::eval_axi_bus(bool clk) {
   }
   if (!mem_rd_rsp_active_) {
     if (has_rd_response) {      
-      auto mem_rsp_it = mem_rsp_vec_[last_mem_rsp_bank_].begin();
+      auto& mem_rsp = mem_rsp_vec_[last_mem_rsp_bank_].front();
       /*
-        printf("%0ld: [sim] MEM Rd Rsp: bank=%d, addr=%0lx, data=", timestamp, last_mem_rsp_bank_, mem_rsp_it->addr);
+        printf("%0ld: [sim] MEM Rd Rsp: bank=%d, addr=%0lx, data=", timestamp, last_mem_rsp_bank_, mem_rsp.addr);
         for (int i = 0; i < MEM_BLOCK_SIZE; i++) {
-          printf("%02x", mem_rsp_it->block[(MEM_BLOCK_SIZE-1)-i]);
+          printf("%02x", mem_rsp.block[(MEM_BLOCK_SIZE-1)-i]);
         }
         printf("\n");
       */      
       vl_obj_->device->m_axi_rvalid = 1;
-      vl_obj_->device->m_axi_rid    = mem_rsp_it->tag;   
+      vl_obj_->device->m_axi_rid    = mem_rsp.tag;   
       vl_obj_->device->m_axi_rresp  = 0;
       vl_obj_->device->m_axi_rlast  = 1;
-      memcpy((uint8_t*)vl_obj_->device->m_axi_rdata, mem_rsp_it->block.data(), MEM_BLOCK_SIZE);
-      mem_rsp_vec_[last_mem_rsp_bank_].erase(mem_rsp_it);
+      memcpy((uint8_t*)vl_obj_->device->m_axi_rdata, mem_rsp.block.data(), MEM_BLOCK_SIZE);
+      mem_rsp_vec_[last_mem_rsp_bank_].pop();
       mem_rd_rsp_active_ = true;
     } else {
       vl_obj_->device->m_axi_rvalid = 0;
@@ -295,14 +337,14 @@ void Simulator::eval_axi_bus(bool clk) {
   }
   if (!mem_wr_rsp_active_) {
     if (has_wr_response) {
-      auto mem_rsp_it = mem_rsp_vec_[last_mem_rsp_bank_].begin();
+      auto& mem_rsp = mem_rsp_vec_[last_mem_rsp_bank_].front();
       /*
-        printf("%0ld: [sim] MEM Wr Rsp: bank=%d, addr=%0lx\n", timestamp, last_mem_rsp_bank_, mem_rsp_it->addr);        
+        printf("%0ld: [sim] MEM Wr Rsp: bank=%d, addr=%0lx\n", timestamp, last_mem_rsp_bank_, mem_rsp.addr);        
       */
       vl_obj_->device->m_axi_bvalid = 1;      
-      vl_obj_->device->m_axi_bid    = mem_rsp_it->tag;
+      vl_obj_->device->m_axi_bid    = mem_rsp.tag;
       vl_obj_->device->m_axi_bresp  = 0;
-      mem_rsp_vec_[last_mem_rsp_bank_].erase(mem_rsp_it);
+      mem_rsp_vec_[last_mem_rsp_bank_].pop();
       mem_wr_rsp_active_ = true;
     } else {
       vl_obj_->device->m_axi_bvalid = 0;
@@ -314,15 +356,8 @@ void Simulator::eval_axi_bus(bool clk) {
   uint32_t req_bank = (MEMORY_BANKS >= 2) ? ((req_addr / MEM_BLOCK_SIZE) % MEMORY_BANKS) : 0;
 
   // handle memory stalls
-  bool mem_stalled = false;
-#ifdef ENABLE_MEM_STALLS
-  if (0 == ((timestamp/2) % MEM_STALLS_MODULO)) { 
-    mem_stalled = true;
-  } else
-  if (mem_rsp_vec_[req_bank].size() >= MEM_RQ_SIZE) {
-    mem_stalled = true;
-  }
-#endif
+  bool mem_stalled = mem_rsp_vec_[req_bank].full() 
+                  || !dram_.ready(req_addr, cycle);
 
   // process memory requests
   if (!mem_stalled) {
@@ -359,28 +394,22 @@ void Simulator::eval_axi_bus(bool clk) {
               (*ram_)[base_addr + i] = data[i];
             }
           }
-          mem_req_t mem_req;
+          // write responses are not merged with pending reads
+          uint64_t ready = dram_.access(base_addr, true, cycle);
+          auto& mem_req = mem_rsp_vec_[req_bank].push(base_addr, ready, false);
           mem_req.tag  = vl_obj_->device->m_axi_arid;
           mem_req.addr = vl_obj_->device->m_axi_araddr;        
-          mem_req.cycles_left = 0;
           mem_req.write = 1;
-          mem_rsp_vec_[req_bank].emplace_back(mem_req);
         }        
       } else {
-        mem_req_t mem_req;        
+        // duplicate requests complete with the pending one
+        uint64_t addr = vl_obj_->device->m_axi_araddr;
+        uint64_t ready = mem_rsp_vec_[req_bank].contains(addr) ? cycle : dram_.access(addr, false, cycle);
+        auto& mem_req = mem_rsp_vec_[req_bank].push(addr, ready);
         mem_req.tag  = vl_obj_->device->m_axi_arid;   
         mem_req.addr = vl_obj_->device->m_axi_araddr;
         ram_->read(mem_req.block.data(), vl_obj_->device->m_axi_araddr, MEM_BLOCK_SIZE);
-        mem_req.cycles_left = MEM_LATENCY;
         mem_req.write = 0;
-        for (auto& rsp : mem_rsp_vec_[req_bank]) {
-          if (mem_req.addr == rsp.addr) {
-            // duplicate requests receive the same cycle delay
-            mem_req.cycles_left = rsp.cycles_left;
-            break;
-          }
-        }     
-        mem_rsp_vec_[req_bank].emplace_back(mem_req);
       } 
     }    
   }
@@ -408,24 +437,17 @@ void Simulator::eval_mem_bus(bool clk) {
     return;
   }
 
-  // update memory responses schedule
-  for (int b = 0; b < MEMORY_BANKS; ++b) {    
-    for (auto& rsp : mem_rsp_vec_[b]) {
-      if (rsp.cycles_left > 0)
-        rsp.cycles_left -= 1;
-    }
-  }
+  uint64_t cycle = timestamp / 2;
 
   bool has_response = false;
 
   // schedule memory responses that are ready
   for (int i = 0; i < MEMORY_BANKS; ++i) {
     uint32_t b = (i + last_mem_rsp_bank_ + 1) % MEMORY_BANKS;
-    if (!mem_rsp_vec_[b].empty()
-    && (mem_rsp_vec_[b].begin()->cycles_left) <= 0) {
-        has_response = true;
-        last_mem_rsp_bank_ = b;
-        break;
+    if (mem_rsp_vec_[b].ready(cycle)) {
+      has_response = true;
+      last_mem_rsp_bank_ = b;
+      break;
     }
   }
 
@@ -437,17 +459,17 @@ void Simulator::eval_mem_bus(bool clk) {
   if (!mem_rd_rsp_active_) {
     if (has_response) {
       vl_obj_->device->mem_rsp_valid = 1;      
-      auto mem_rsp_it = mem_rsp_vec_[last_mem_rsp_bank_].begin();      
+      auto& mem_rsp = mem_rsp_vec_[last_mem_rsp_bank_].front();      
       /*
-        printf("%0ld: [sim] MEM Rd: bank=%d, addr=%0lx, data=", timestamp, last_mem_rsp_bank_, mem_rsp_it->addr);
+        printf("%0ld: [sim] MEM Rd: bank=%d, addr=%0lx, data=", timestamp, last_mem_rsp_bank_, mem_rsp.addr);
         for (int i = 0; i < MEM_BLOCK_SIZE; i++) {
-          printf("%02x", mem_rsp_it->block[(MEM_BLOCK_SIZE-1)-i]);
+          printf("%02x", mem_rsp.block[(MEM_BLOCK_SIZE-1)-i]);
         }
         printf("\n");
       */
-      memcpy((uint8_t*)vl_obj_->device->mem_rsp_data, mem_rsp_it->block.data(), MEM_BLOCK_SIZE);
-      vl_obj_->device->mem_rsp_tag = mem_rsp_it->tag;   
-      mem_rsp_vec_[last_mem_rsp_bank_].erase(mem_rsp_it);
+      memcpy((uint8_t*)vl_obj_->device->mem_rsp_data, mem_rsp.block.data(), MEM_BLOCK_SIZE);
+      vl_obj_->device->mem_rsp_tag = mem_rsp.tag;   
+      mem_rsp_vec_[last_mem_rsp_bank_].pop();
       mem_rd_rsp_active_ = true;
     } else {
       vl_obj_->device->mem_rsp_valid = 0;
@@ -455,18 +477,12 @@ void Simulator::eval_mem_bus(bool clk) {
   }
 
   // select the memory bank
+  uint64_t req_addr = vl_obj_->device->mem_req_addr * MEM_BLOCK_SIZE;
   uint32_t req_bank = (MEMORY_BANKS >= 2) ? (vl_obj_->device->mem_req_addr % MEMORY_BANKS) : 0;
 
   // handle memory stalls
-  bool mem_stalled = false;
-#ifdef ENABLE_MEM_STALLS
-  if (0 == ((timestamp/2) % MEM_STALLS_MODULO)) { 
-    mem_stalled = true;
-  } else
-  if (mem_rsp_vec_[req_bank].size() >= MEM_RQ_SIZE) {
-    mem_stalled = true;
-  }
-#endif
+  bool mem_stalled = mem_rsp_vec_[req_bank].full() 
+                  || !dram_.ready(req_addr, cycle);
 
   // process memory requests
   if (!mem_stalled) {
@@ -501,21 +517,16 @@ void Simulator::eval_mem_bus(bool clk) {
               (*ram_)[base_addr + i] = data[i];
             }
           }
+          // posted write, only occupies the DRAM
+          dram_.access(base_addr, true, cycle);
         }
       } else {
-        mem_req_t mem_req;        
+        // duplicate requests complete with the pending one
+        uint64_t ready = mem_rsp_vec_[req_bank].contains(req_addr) ? cycle : dram_.access(req_addr, false, cycle);
+        auto& mem_req = mem_rsp_vec_[req_bank].push(req_addr, ready);
         mem_req.tag  = vl_obj_->device->mem_req_tag;   
-        mem_req.addr = (vl_obj_->device->mem_req_addr * MEM_BLOCK_SIZE);
-        ram_->read(mem_req.block.data(), vl_obj_->device->mem_req_addr * MEM_BLOCK_SIZE, MEM_BLOCK_SIZE);
-        mem_req.cycles_left = MEM_LATENCY;
-        for (auto& rsp : mem_rsp_vec_[req_bank]) {
-          if (mem_req.addr == rsp.addr) {
-            // duplicate requests receive the same cycle delay
-            mem_req.cycles_left = rsp.cycles_left;
-            break;
-          }
-        }     
-        mem_rsp_vec_[req_bank].emplace_back(mem_req);
+        mem_req.addr = req_addr;
+        ram_->read(mem_req.block.data(), req_addr, MEM_BLOCK_SIZE);
       } 
     }    
   }
@@ -535,6 +546,10 @@ bool Simulator::is_busy() const {
   return vl_obj_->device->busy;
 }
 
+uint64_t Simulator::cycles() const {
+  return timestamp / 2;
+}
+
 int Simulator::run() {
   int exitcode = 0;
 
@@ -548,6 +563,10 @@ int Simulator::run() {
       exitcode = get_last_wb_value(3);
       break;  
     }
+    if (!snapshot_file_.empty() 
+     && snapshot_cycle_ == timestamp/2) {
+      this->save_snapshot(snapshot_file_.c_str());
+    }
     this->step();
   }
 
@@ -557,6 +576,137 @@ int Simulator::run() {
   return exitcode;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// snapshot layout: Verilated model state followed by the harness state
+#define SNAPSHOT_VERSION 1
+
+template <typename T>
+static void write_pod(std::ostream& out, const T& value) {
+  out.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static void read_pod(std::istream& in, T& value) {
+  in.read((char*)&value, sizeof(T));
+}
+
+void Simulator::set_snapshot(uint64_t cycle, const char* filename) {
+  snapshot_cycle_ = cycle;
+  snapshot_file_ = filename ? filename : "";
+}
+
+int Simulator::save_snapshot(const char* filename) {
+#ifdef SAVABLE_ENABLE
+  static_assert(std::is_trivially_copyable<decltype(mem_rsp_vec_)>::value, "invalid type");
+
+  std::ostringstream ss;
+  write_pod<uint32_t>(ss, SNAPSHOT_VERSION);
+  write_pod(ss, timestamp);
+  write_pod(ss, mem_rsp_vec_);
+  write_pod(ss, last_mem_rsp_bank_);
+  write_pod(ss, mem_rd_rsp_active_);
+  write_pod(ss, mem_rd_rsp_ready_);
+  write_pod(ss, mem_wr_rsp_active_);
+  write_pod(ss, mem_wr_rsp_ready_);
+  dram_.save(ss);
+  write_pod<bool>(ss, ram_ != nullptr);
+  if (ram_) {
+    ram_->save(ss);
+  }
+  write_pod<uint32_t>(ss, print_bufs_.size());
+  for (auto& buf : print_bufs_) {
+    auto str = buf.second.str();
+    write_pod(ss, buf.first);
+    write_pod<uint32_t>(ss, str.size());
+    ss.write(str.data(), str.size());
+  }
+  std::string state = ss.str();
+
+  VerilatedSave os;
+  os.open(filename);
+  if (!os.isOpen()) {
+    std::cout << "*** error: cannot open snapshot file " << filename << std::endl;
+    return -1;
+  }
+  os << *vl_obj_->device;
+  os << state;
+  os.close();
+
+  std::cout << std::dec << timestamp << ": [sim] snapshot saved to " << filename << std::endl;
+  return 0;
+#else
+  __unused(filename);
+  std::cout << "*** error: snapshots require a SAVABLE=1 build." << std::endl;
+  return -1;
+#endif
+}
+
+int Simulator::restore_snapshot(const char* filename) {
+#ifdef SAVABLE_ENABLE
+  VerilatedRestore is;
+  is.open(filename);
+  if (!is.isOpen()) {
+    std::cout << "*** error: cannot open snapshot file " << filename << std::endl;
+    return -1;
+  }
+  std::string state;
+  is >> *vl_obj_->device;
+  is >> state;
+  is.close();
+
+  std::istringstream ss(state);
+  uint32_t version;
+  read_pod(ss, version);
+  if (!ss || version != SNAPSHOT_VERSION) {
+    std::cout << "*** error: unsupported snapshot version" << std::endl;
+    return -1;
+  }
+  read_pod(ss, timestamp);
+  read_pod(ss, mem_rsp_vec_);
+  read_pod(ss, last_mem_rsp_bank_);
+  read_pod(ss, mem_rd_rsp_active_);
+  read_pod(ss, mem_rd_rsp_ready_);
+  read_pod(ss, mem_wr_rsp_active_);
+  read_pod(ss, mem_wr_rsp_ready_);
+  if (dram_.restore(ss) != 0)
+    return -1;
+  bool has_ram;
+  read_pod(ss, has_ram);
+  if (has_ram) {
+    if (nullptr == ram_) {
+      std::cout << "*** error: attach a RAM before restoring a snapshot" << std::endl;
+      return -1;
+    }
+    if (ram_->restore(ss) != 0)
+      return -1;
+  }
+  uint32_t num_bufs;
+  read_pod(ss, num_bufs);
+  print_bufs_.clear();
+  for (uint32_t i = 0; i < num_bufs; ++i) {
+    int tid;
+    uint32_t size;
+    read_pod(ss, tid);
+    read_pod(ss, size);
+    std::string str(size, '\0');
+    ss.read(&str[0], size);
+    print_bufs_[tid] << str;
+  }
+  if (!ss) {
+    std::cout << "*** error: invalid snapshot file " << filename << std::endl;
+    return -1;
+  }
+
+  std::cout << std::dec << timestamp << ": [sim] snapshot restored from " << filename << std::endl;
+  return 0;
+#else
+  __unused(filename);
+  std::cout << "*** error: snapshots require a SAVABLE=1 build." << std::endl;
+  return -1;
+#endif
+}
+
 bool Simulator::get_ebreak() const {
 #ifdef AXI_BUS
   return (int)vl_obj_->device->Vortex_axi->vortex->genblk2__BRA__0__KET____DOT__cluster->genblk2__BRA__0__KET____DOT__core->pipeline->execute->ebreak;
@@ -576,4 +726,5 @@ int Simulator::get_last_wb_value(int reg) const {
 void Simulator::print_stats(std::ostream& out) {
   out << std::left;
   out << std::setw(24) << "# of total cycles:" << std::dec << timestamp/2 << std::endl;
-}
\ No newline at end of file
+  dram_.print_stats(out);
+}
@@ -2,10 +2,15 @@
 
 #include <VX_config.h>
 #include <ostream>
-#include <list>
+#include <array>
+#include <chrono>
 #include <vector>
+#include <string>
 #include <sstream> 
 #include <unordered_map>
+#include <mem_sched.h>
+#include <dram.h>
+#include <vl_trace.h>
 
 #ifndef MEMORY_BANKS
   #ifdef PLATFORM_PARAM_LOCAL_MEMORY_BANKS
@@ -15,10 +20,16 @@
   #endif
 #endif
 
+#ifndef MEM_RQ_SIZE
+#define MEM_RQ_SIZE 16
+#endif
+
 namespace vortex {
 
 class VL_OBJ;
 class RAM;
+class PerfTrace;
+class PipeTrace;
 
 class Simulator {
 public:
@@ -28,20 +39,45 @@ public:
 
   void attach_ram(RAM* ram);
 
+  // sample the cores performance counters into the trace
+  void attach_perf_trace(PerfTrace* perf_trace);
+
+  // record per-instruction pipeline lifetimes (requires PIPE_TRACE build)
+  void attach_pipe_trace(PipeTrace* pipe_trace);
+
+  // replace the DRAM timing model (default: VORTEX_DRAM_CONFIG file)
+  void set_dram_config(const DramConfig& config);
+
+  // waveform and debug trace window (default: VORTEX_TRACE* environment)
+  void set_trace(const TraceConfig& config);
+
   bool is_busy() const;
 
+  // simulated cycles since construction, including resets
+  uint64_t cycles() const;
+
+  // restart the device, the model is reused so that a new program can be
+  // attached without rebuilding it
   void reset();
   void step();
   void wait(uint32_t cycles);
 
   int run();
 
+  // checkpoint the model, memory and pending requests (requires SAVABLE build)
+  int save_snapshot(const char* filename);
+
+  // resume from a checkpoint taken by the same build, the RAM must be attached
+  int restore_snapshot(const char* filename);
+
+  // save a snapshot when run() reaches the given cycle
+  void set_snapshot(uint64_t cycle, const char* filename);
+
   void print_stats(std::ostream& out);
 
 private:  
 
-  typedef struct {    
-    int cycles_left;  
+  typedef struct {
     std::array<uint8_t, MEM_BLOCK_SIZE> block;
     uint64_t addr;
     uint64_t tag;
@@ -51,6 +87,8 @@ private:
   std::unordered_map<int, std::stringstream> print_bufs_;
 
   void eval();  
+
+  void flush_prints();
   
 #ifdef AXI_BUS
   void reset_axi_bus();  
@@ -64,7 +102,7 @@ private:
   
   bool get_ebreak() const;
 
-  std::list<mem_req_t> mem_rsp_vec_ [MEMORY_BANKS];
+  MemRspQueue<mem_req_t, MEM_RQ_SIZE> mem_rsp_vec_ [MEMORY_BANKS];
   uint32_t last_mem_rsp_bank_;
 
   bool mem_rd_rsp_active_;
@@ -75,6 +113,14 @@ private:
 
   RAM *ram_;
 
+  DramSim dram_;
+
+  uint64_t step_cycles_;
+  std::chrono::steady_clock::duration step_time_;
+
+  uint64_t snapshot_cycle_;
+  std::string snapshot_file_;
+
   VL_OBJ* vl_obj_;
 };
 
@@ -23,7 +23,9 @@ Core::Core(const ArchDef &arch, Decoder &decoder, MemoryUnit &mem, Word id)
     , inst_in_decode_("decode")
     , inst_in_issue_("issue")
     , inst_in_execute_("execute")
-    , inst_in_writeback_("writeback") {
+    , inst_in_writeback_("writeback")
+    , perf_trace_(nullptr)
+    , dram_(nullptr) {
   in_use_iregs_.resize(arch.num_warps(), 0);
   in_use_fregs_.resize(arch.num_warps(), 0);
   in_use_vregs_.reset();
@@ -88,6 +90,10 @@ void Core::clear() {
   insts_  = 0;
   loads_  = 0;
   stores_ = 0;
+  scoreboard_stalls_ = 0;
+  idle_cycles_ = 0;
+  mem_stalls_ = 0;
+  dram_blocks_.clear();
 
   inst_in_schedule_.valid = true;
   warps_[0]->setTmask(0, true);
@@ -108,6 +114,10 @@ void Core::step() {
   this->fetch();
   this->schedule();
 
+  if (perf_trace_ && 0 == (steps_ % perf_trace_->interval())) {
+    this->perf_sample();
+  }
+
   DPN(2, std::flush);
 }
 
@@ -129,8 +139,10 @@ void Core::schedule() {
     }
   }
 
-  if (!foundSchedule)
+  if (!foundSchedule) {
+    ++idle_cycles_;
     return;
+  }
 
   D(2, "Schedule: wid=" << scheduled_warp);
   inst_in_schedule_.wid = scheduled_warp;
@@ -149,6 +161,16 @@ void Core::fetch() {
   warps_[wid]->step(&inst_in_fetch_);
   auto active_threads_a = warps_[wid]->getActiveThreads();   
 
+  // schedule the blocks touched by the instruction, loads complete with the slowest one
+  inst_in_fetch_.mem_ready = 0;
+  for (auto& block : dram_blocks_) {
+    auto ready = dram_->access(block.first, block.second, steps_);
+    if (!block.second && ready > inst_in_fetch_.mem_ready) {
+      inst_in_fetch_.mem_ready = ready;
+    }
+  }
+  dram_blocks_.clear();
+
   insts_ += active_threads_b;
   if (active_threads_b != active_threads_a) {
     D(3, "*** warp#" << wid << " active threads changed to " << active_threads_a);
@@ -184,6 +206,7 @@ void Core::issue() {
   if (in_use_regs) {      
     D(3, "*** Issue: registers not ready!");
     inst_in_issue_.stalled = true;
+    ++scoreboard_stalls_;
     return;
   } 
 
@@ -210,6 +233,13 @@ void Core::execute() {
   if (!inst_in_execute_.enter(&inst_in_writeback_))
     return;
 
+  if (inst_in_execute_.mem_ready > steps_) {
+    D(3, "*** Execute: waiting for memory");
+    inst_in_execute_.stalled = true;
+    ++mem_stalls_;
+    return;
+  }
+
   // advance pipeline
   inst_in_execute_.next(&inst_in_writeback_);
 }
@@ -279,6 +309,13 @@ Word Core::get_csr(Addr addr, int tid, int wid) {
   } else if (addr == CSR_NC) {
     // Number of cores
     return arch_.num_cores();
+  } else if (addr == CSR_SMEM_SIZE) {
+    // Shared memory size per core
+  #ifdef SM_ENABLE
+    return SMEM_SIZE;
+  #else
+    return 0;
+  #endif
   } else if (addr == CSR_MINSTRET) {
     // NumInsts
     return insts_;
@@ -321,6 +358,14 @@ void Core::barrier(int bar_id, int count, int warp_id) {
   barrier.reset();
 }
 
+bool Core::barriers_idle() const {
+  for (auto& barrier : barriers_) {
+    if (barrier.any())
+      return false;
+  }
+  return true;
+}
+
 Word Core::icache_fetch(Addr addr) {
   Word data;
   mem_.read(&data, addr, sizeof(Word), 0);
@@ -337,6 +382,7 @@ Word Core::dcache_read(Addr addr, Size size) {
      return data;
   }
 #endif
+  this->dram_access(addr, false);
   mem_.read(&data, addr, size, 0);
   return data;
 }
@@ -355,9 +401,22 @@ void Core::dcache_write(Addr addr, Word data, Size size) {
      this->writeToStdOut(addr, data);
      return;
   }
+  this->dram_access(addr, true);
   mem_.write(&data, addr, size, 0);
 }
 
+void Core::dram_access(Addr addr, bool write) {
+  if (nullptr == dram_)
+    return;
+  // coalesce the threads of a warp into one request per block
+  Addr block_addr = addr & ~Addr(dram_->config().block_size - 1);
+  for (auto& block : dram_blocks_) {
+    if (block.first == block_addr && block.second == write)
+      return;
+  }
+  dram_blocks_.emplace_back(block_addr, write);
+}
+
 bool Core::running() const {
   return inst_in_fetch_.valid 
       || inst_in_decode_.valid 
@@ -370,7 +429,38 @@ void Core::printStats() const {
   std::cout << "Steps : " << steps_ << std::endl
             << "Insts : " << insts_ << std::endl
             << "Loads : " << loads_ << std::endl
-            << "Stores: " << stores_ << std::endl;
+            << "Stores: " << stores_ << std::endl
+            << "Memory stalls: " << mem_stalls_ << std::endl;
+}
+
+void Core::attach_perf_trace(PerfTrace* perf_trace) {
+  perf_trace_ = perf_trace;
+}
+
+void Core::attach_dram(DramSim* dram) {
+  dram_ = dram;
+}
+
+void Core::perf_sample() {
+  int active_warps = 0;
+  for (auto& warp : warps_) {
+    active_warps += warp->active();
+  }
+
+  auto cycles = perf_trace_->delta(id_, "cycles", steps_);
+  auto instrs = perf_trace_->delta(id_, "instrs", insts_);
+  auto scoreboard_stalls = perf_trace_->delta(id_, "scoreboard_stalls", scoreboard_stalls_);
+  auto idle_cycles = perf_trace_->delta(id_, "idle_cycles", idle_cycles_);
+  auto loads = perf_trace_->delta(id_, "loads", loads_);
+  auto stores = perf_trace_->delta(id_, "stores", stores_);
+
+  perf_trace_->counter(id_, steps_, "ipc", {{"ipc", cycles ? double(instrs) / cycles : 0}});
+  perf_trace_->counter(id_, steps_, "warps", {{"active", active_warps}, 
+                                              {"stalled", stalled_warps_.count()}});
+  perf_trace_->counter(id_, steps_, "stalls", {{"scoreboard", scoreboard_stalls}, 
+                                               {"idle", idle_cycles}});
+  perf_trace_->counter(id_, steps_, "memory", {{"loads", loads}, 
+                                               {"stores", stores}});
 }
 
 void Core::writeToStdOut(Addr addr, Word data) {
@@ -13,6 +13,8 @@
 #include "archdef.h"
 #include "decode.h"
 #include "mem.h"
+#include "dram.h"
+#include "perf_trace.h"
 #include "warp.h"
 #include "pipeline.h"
 
@@ -66,6 +68,15 @@ public:
 
   void barrier(int bar_id, int count, int warp_id);
 
+  // no warp is waiting at a barrier
+  bool barriers_idle() const;
+
+#ifdef SM_ENABLE
+  RAM& shared_mem() {
+    return shared_mem_;
+  }
+#endif
+
   Word icache_fetch(Addr);
 
   Word dcache_read(Addr, Size);
@@ -75,6 +86,12 @@ public:
   void trigger_ebreak();
   bool check_ebreak() const;
 
+  // sample performance counters into the trace every interval cycles
+  void attach_perf_trace(PerfTrace* perf_trace);
+
+  // delay loads by the DRAM latency (default: no memory timing)
+  void attach_dram(DramSim* dram);
+
 private: 
 
   void schedule();
@@ -85,6 +102,10 @@ private:
   void writeback();
 
   void writeToStdOut(Addr addr, Word data);
+
+  void dram_access(Addr addr, bool write);
+
+  void perf_sample();
   
   std::vector<RegMask> in_use_iregs_;
   std::vector<RegMask> in_use_fregs_;
@@ -117,6 +138,14 @@ private:
   uint64_t insts_;
   uint64_t loads_;
   uint64_t stores_; 
+  uint64_t scoreboard_stalls_;
+  uint64_t idle_cycles_;
+  uint64_t mem_stalls_;
+
+  PerfTrace* perf_trace_;
+
+  DramSim* dram_;
+  std::vector<std::pair<Addr, bool>> dram_blocks_;
 };
 
 } // namespace vortex
\ No newline at end of file
@@ -20,6 +20,9 @@ int main(int argc, char **argv) {
   int num_warps(NUM_WARPS);
   int num_threads(NUM_THREADS);
   std::string imgFileName;
+  std::string perfTraceFileName;
+  std::string dramConfigFileName;
+  int perf_interval(1000);
   bool showHelp(false);
   bool showStats(false);
   bool riscv_test(false);
@@ -33,6 +36,9 @@ int main(int argc, char **argv) {
   CommandLineArgSetter<int> ft("-t", "--threads", "", num_threads);
   CommandLineArgFlag fr("-r", "--riscv", "", riscv_test);
   CommandLineArgFlag fs("-s", "--stats", "", showStats);
+  CommandLineArgSetter<std::string> fp("-p", "--perf-trace", "", perfTraceFileName);
+  CommandLineArgSetter<int> fn("-n", "--perf-interval", "", perf_interval);
+  CommandLineArgSetter<std::string> fd("-d", "--dram", "", dramConfigFileName);
 
   CommandLineArg::readArgs(argc - 1, argv + 1);
 
@@ -44,7 +50,10 @@ int main(int argc, char **argv) {
                  "  -t, --threads <num> Number of threads\n"
                  "  -a, --arch <arch string> Architecture string\n"
                  "  -r, --riscv riscv test\n"
-                 "  -s, --stats Print stats on exit.\n";
+                 "  -s, --stats Print stats on exit.\n"
+                 "  -p, --perf-trace <filename> Write perf samples as Chrome trace JSON\n"
+                 "  -n, --perf-interval <cycles> Perf sampling interval (default 1000)\n"
+                 "  -d, --dram <filename> Model DRAM timing with the given config\n";
     return 0;
   }
 
@@ -70,9 +79,24 @@ int main(int argc, char **argv) {
   struct stat hello;
   fstat(0, &hello);
 
+  std::shared_ptr<PerfTrace> perf_trace;
+  if (!perfTraceFileName.empty()) {
+    perf_trace = std::make_shared<PerfTrace>(perfTraceFileName.c_str(), perf_interval);
+  }
+
+  std::shared_ptr<DramSim> dram;
+  if (!dramConfigFileName.empty()) {
+    DramConfig dram_config;
+    if (dram_config.load(dramConfigFileName.c_str()) != 0)
+      return -1;
+    dram = std::make_shared<DramSim>(dram_config);
+  }
+
   std::vector<std::shared_ptr<Core>> cores(num_cores);
   for (int i = 0; i < num_cores; ++i) {
     cores[i] = std::make_shared<Core>(arch, decoder, mu, i);
+    cores[i]->attach_perf_trace(perf_trace.get());
+    cores[i]->attach_dram(dram.get());
   }
 
   bool running;
@@ -92,6 +116,15 @@ int main(int argc, char **argv) {
     }
   } while (running);
 
+  if (showStats) {
+    for (auto& core : cores) {
+      core->printStats();
+    }
+    if (dram) {
+      dram->print_stats(std::cout);
+    }
+  }
+
   if (riscv_test) {
     if (1 == exitcode) {
       std::cout << "Passed." << std::endl;
@@ -31,6 +31,7 @@ void Pipeline::clear() {
   used_iregs.reset();
   used_fregs.reset();
   used_vregs.reset();
+  mem_ready = 0;
 }
 
 bool Pipeline::enter(Pipeline *drain) {
@@ -59,5 +60,6 @@ void Pipeline::next(Pipeline *drain) {
     drain->used_iregs = this->used_iregs;
     drain->used_fregs = this->used_fregs;
     drain->used_vregs = this->used_vregs;
+    drain->mem_ready = this->mem_ready;
   }
 }
\ No newline at end of file
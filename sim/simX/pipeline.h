@@ -38,6 +38,9 @@ public:
   RegMask   used_fregs;
   RegMask   used_vregs;
 
+  //--
+  uint64_t  mem_ready;
+
 private:
 
   const char* name_;
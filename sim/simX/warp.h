@@ -85,6 +85,19 @@ public:
     return iRegFile_[0][reg];
   }
 
+  Word getIReg(int tid, int reg) const {
+    return iRegFile_.at(tid).at(reg);
+  }
+
+  Word getFReg(int tid, int reg) const {
+    return fRegFile_.at(tid).at(reg);
+  }
+
+  // no divergent branch is waiting to reconverge
+  bool converged() const {
+    return domStack_.empty();
+  }
+
   void step(Pipeline *);
 
 private:
@@ -0,0 +1,259 @@
+#include "cci_link.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <assert.h>
+
+using namespace vortex;
+
+static const char* channel_names[] = {"VL0", "VH0", "VH1"};
+
+CciConfig::CciConfig()
+  : channels{{0, 0, 0, 0},        // VL0
+             {8, 15, 64, 64},     // VH0
+             {0, 0, 0, 0}}        // VH1
+  , rd_credits(16)
+  , wr_credits(16)
+  , seed(1)
+{}
+
+int CciConfig::load(const char* filename) {
+  static const struct {
+    const char* name;
+    uint32_t CciConfig::* field;
+  } params[] = {
+    {"rd_credits", &CciConfig::rd_credits},
+    {"wr_credits", &CciConfig::wr_credits},
+    {"seed",       &CciConfig::seed},
+  };
+
+  // per-channel parameters are prefixed with the channel name, e.g. vh0_rd_bw
+  static const struct {
+    const char* name;
+    uint32_t channel_t::* field;
+  } channel_params[] = {
+    {"lat_min", &channel_t::lat_min},
+    {"lat_max", &channel_t::lat_max},
+    {"rd_bw",   &channel_t::rd_bw},
+    {"wr_bw",   &channel_t::wr_bw},
+  };
+
+  std::ifstream ifs(filename);
+  if (!ifs) {
+    std::cerr << "*** error: cannot open CCI config file " << filename << std::endl;
+    return -1;
+  }
+
+  std::string line;
+  for (int lineno = 1; std::getline(ifs, line); ++lineno) {
+    auto comment = line.find('#');
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    std::replace(line.begin(), line.end(), '=', ' ');
+    std::istringstream iss(line);
+    std::string name;
+    if (!(iss >> name))
+      continue;
+    uint32_t value;
+    if (!(iss >> value)) {
+      std::cerr << "*** error: " << filename << ":" << lineno << ": missing value for " << name << std::endl;
+      return -1;
+    }
+    bool found = false;
+    for (auto& param : params) {
+      if (name == param.name) {
+        this->*param.field = value;
+        found = true;
+        break;
+      }
+    }
+    for (int c = 0; c < NUM_CHANNELS && !found; ++c) {
+      std::string prefix(channel_names[c]);
+      std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+      prefix += '_';
+      if (name.compare(0, prefix.size(), prefix) != 0)
+        continue;
+      for (auto& param : channel_params) {
+        if (name.compare(prefix.size(), std::string::npos, param.name) == 0) {
+          channels[c].*param.field = value;
+          found = true;
+          break;
+        }
+      }
+    }
+    if (!found) {
+      std::cerr << "*** error: " << filename << ":" << lineno << ": unknown CCI parameter " << name << std::endl;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int CciConfig::load_env() {
+  auto filename = getenv("VORTEX_CCI_CONFIG");
+  if (nullptr == filename)
+    return 0;
+  return this->load(filename);
+}
+
+int CciConfig::validate(uint32_t max_credits, uint32_t max_delay) const {
+  if (rd_credits < 2 || rd_credits > max_credits
+   || wr_credits < 2 || wr_credits > max_credits) {
+    std::cerr << "*** error: CCI credits must be in [2, " << max_credits << "]" << std::endl;
+    return -1;
+  }
+
+  // a full set of requests on one channel must complete within max_delay
+  bool has_rd = false, has_wr = false;
+  for (int c = 0; c < NUM_CHANNELS; ++c) {
+    auto& channel = channels[c];
+    if (0 == channel.rd_bw && 0 == channel.wr_bw)
+      continue;
+    if (channel.lat_min > channel.lat_max) {
+      std::cerr << "*** error: CCI " << channel_names[c] << " latency range is empty" << std::endl;
+      return -1;
+    }
+    if (channel.rd_bw) {
+      has_rd = true;
+      uint64_t delay = channel.lat_max + ((uint64_t)rd_credits * line_ticks(channel.rd_bw) + 63) / 64 + 1;
+      if (delay >= max_delay) {
+        std::cerr << "*** error: CCI " << channel_names[c] << " read delay exceeds " << max_delay << " cycles" << std::endl;
+        return -1;
+      }
+    }
+    if (channel.wr_bw) {
+      has_wr = true;
+      uint64_t delay = channel.lat_max + ((uint64_t)wr_credits * line_ticks(channel.wr_bw) + 63) / 64 + 1;
+      if (delay >= max_delay) {
+        std::cerr << "*** error: CCI " << channel_names[c] << " write delay exceeds " << max_delay << " cycles" << std::endl;
+        return -1;
+      }
+    }
+  }
+  if (!has_rd || !has_wr) {
+    std::cerr << "*** error: CCI link needs a read and a write channel" << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+CciLink::CciLink(const CciConfig& config)
+  : config_(config) {
+  this->reset();
+}
+
+void CciLink::reset() {
+  for (auto& channel : channels_) {
+    channel = {0, 0, 0, 0};
+  }
+  rd_pending_ = 0;
+  wr_pending_ = 0;
+  rand_       = config_.seed ? config_.seed : 1;
+  rd_latency_ = 0;
+  wr_latency_ = 0;
+  rd_stalls_  = 0;
+}
+
+uint32_t CciLink::select(uint32_t vc, bool write) const {
+  // VC 1..3 map to VL0, VH0 and VH1, VA or a disabled channel lets the
+  // link pick the channel that frees up first
+  if (vc != 0 && vc <= CciConfig::NUM_CHANNELS) {
+    auto& channel = config_.channels[vc - 1];
+    if ((write ? channel.wr_bw : channel.rd_bw) != 0)
+      return vc - 1;
+  }
+  uint32_t best = 0;
+  uint64_t best_free = -1ull;
+  for (uint32_t c = 0; c < CciConfig::NUM_CHANNELS; ++c) {
+    auto& channel = config_.channels[c];
+    if (0 == (write ? channel.wr_bw : channel.rd_bw))
+      continue;
+    uint64_t free = write ? channels_[c].wr_free : channels_[c].rd_free;
+    if (free < best_free) {
+      best_free = free;
+      best = c;
+    }
+  }
+  return best;
+}
+
+uint32_t CciLink::latency(uint32_t ch) {
+  auto& channel = config_.channels[ch];
+  // xorshift64*
+  rand_ ^= rand_ >> 12;
+  rand_ ^= rand_ << 25;
+  rand_ ^= rand_ >> 27;
+  uint64_t r = rand_ * 0x2545F4914F6CDD1Dull;
+  return channel.lat_min + (r >> 32) % (channel.lat_max - channel.lat_min + 1);
+}
+
+uint64_t CciLink::read(uint32_t vc, uint64_t cycle) {
+  assert(rd_pending_ < config_.rd_credits);
+  uint32_t ch = this->select(vc, false);
+  auto& channel = channels_[ch];
+  // the data returns once the host has served the request and the
+  // downstream direction is free
+  uint64_t arrival = (cycle + this->latency(ch)) * 64;
+  if (channel.rd_free > arrival) {
+    ++rd_stalls_;
+  }
+  uint64_t start = std::max(arrival, channel.rd_free);
+  channel.rd_free = start + CciConfig::line_ticks(config_.channels[ch].rd_bw);
+  uint64_t complete = (channel.rd_free + 63) / 64;
+  ++channel.reads;
+  ++rd_pending_;
+  rd_latency_ += complete - cycle;
+  return complete;
+}
+
+uint64_t CciLink::write(uint32_t vc, uint64_t cycle) {
+  assert(wr_pending_ < config_.wr_credits);
+  uint32_t ch = this->select(vc, true);
+  auto& channel = channels_[ch];
+  // the data goes upstream, then the host acknowledges the write
+  uint64_t start = std::max(cycle * 64, channel.wr_free);
+  channel.wr_free = start + CciConfig::line_ticks(config_.channels[ch].wr_bw);
+  uint64_t complete = (channel.wr_free + 63) / 64 + this->latency(ch);
+  ++channel.writes;
+  ++wr_pending_;
+  wr_latency_ += complete - cycle;
+  return complete;
+}
+
+void CciLink::read_done() {
+  assert(rd_pending_ != 0);
+  --rd_pending_;
+}
+
+void CciLink::write_done() {
+  assert(wr_pending_ != 0);
+  --wr_pending_;
+}
+
+void CciLink::print_stats(std::ostream& out) const {
+  uint64_t reads = 0, writes = 0;
+  for (auto& channel : channels_) {
+    reads += channel.reads;
+    writes += channel.writes;
+  }
+  out << std::left;
+  out << std::setw(28) << "# of CCI reads:" << std::dec << reads << std::endl;
+  out << std::setw(28) << "# of CCI writes:" << writes << std::endl;
+  for (int c = 0; c < CciConfig::NUM_CHANNELS; ++c) {
+    if (0 == (channels_[c].reads + channels_[c].writes))
+      continue;
+    std::string label = std::string("# of CCI ") + channel_names[c] + " reads/writes:";
+    out << std::setw(28) << label << channels_[c].reads << "/" << channels_[c].writes << std::endl;
+  }
+  out << std::setw(28) << "# of CCI read stalls:" << rd_stalls_ << std::endl;
+  out << std::setw(28) << "CCI read average latency:" << (reads ? (rd_latency_ / reads) : 0) << std::endl;
+  out << std::setw(28) << "CCI write average latency:" << (writes ? (wr_latency_ / writes) : 0) << std::endl;
+}
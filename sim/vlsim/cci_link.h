@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+namespace vortex {
+
+// CCI-P host link organization and timing, all timings in AFU clock cycles.
+// Physical channels: VL0 (UPI), VH0 and VH1 (PCIe). The defaults keep the
+// former fixed vlsim timing: 8-15 cycles, 16 requests, one line per cycle.
+struct CciConfig {
+  struct channel_t {
+    uint32_t lat_min;     // host round-trip latency range
+    uint32_t lat_max;
+    uint32_t rd_bw;       // host to device bytes per cycle (0 disables the channel)
+    uint32_t wr_bw;       // device to host bytes per cycle
+  };
+
+  enum { VL0 = 0, VH0 = 1, VH1 = 2, NUM_CHANNELS = 3 };
+
+  channel_t channels[NUM_CHANNELS];
+  uint32_t  rd_credits;   // outstanding read requests
+  uint32_t  wr_credits;   // outstanding write requests
+  uint32_t  seed;         // latency sampling seed
+
+  CciConfig();
+
+  // read "name = value" lines, '#' starts a comment
+  int load(const char* filename);
+
+  // load the file named by the VORTEX_CCI_CONFIG environment variable, if set
+  int load_env();
+
+  // credits and completion times must fit the response queues
+  int validate(uint32_t max_credits, uint32_t max_delay) const;
+
+  // line transfer time in 1/64 cycle units
+  static uint32_t line_ticks(uint32_t bw) {
+    return (64 * 64 + bw - 1) / bw;
+  }
+};
+
+class CciLink {
+public:
+  CciLink(const CciConfig& config = CciConfig());
+
+  void reset();
+
+  const CciConfig& config() const {
+    return config_;
+  }
+
+  // the AFU must stop issuing (TxAlmFull)
+  bool rd_almost_full() const {
+    return (rd_pending_ + 1) >= config_.rd_credits;
+  }
+
+  bool wr_almost_full() const {
+    return (wr_pending_ + 1) >= config_.wr_credits;
+  }
+
+  // schedule a cache line request on the given virtual channel (0 = VA)
+  // and return its completion cycle, completions may be out of order
+  uint64_t read(uint32_t vc, uint64_t cycle);
+  uint64_t write(uint32_t vc, uint64_t cycle);
+
+  // a response was returned to the AFU
+  void read_done();
+  void write_done();
+
+  void print_stats(std::ostream& out) const;
+
+private:
+
+  struct channel_t {
+    uint64_t rd_free;     // in 1/64 cycle units
+    uint64_t wr_free;
+    uint64_t reads;
+    uint64_t writes;
+  };
+
+  uint32_t select(uint32_t vc, bool write) const;
+
+  uint32_t latency(uint32_t ch);
+
+  CciConfig config_;
+  channel_t channels_[CciConfig::NUM_CHANNELS];
+  uint32_t  rd_pending_;
+  uint32_t  wr_pending_;
+  uint64_t  rand_;
+
+  uint64_t  rd_latency_;
+  uint64_t  wr_latency_;
+  uint64_t  rd_stalls_;
+};
+
+}
@@ -15,6 +15,10 @@ extern fpga_result fpgaOpen(fpga_token token, fpga_handle *handle, int flags) {
   if (NULL == handle || flags != 0)
     return FPGA_INVALID_PARAM;
   auto sim = new opae_sim();    
+  if (sim->init() != 0) {
+    delete sim;
+    return FPGA_EXCEPTION;
+  }
   *handle = reinterpret_cast<fpga_handle>(sim);
   return FPGA_OK;
 }
@@ -4,41 +4,16 @@
 #include "Vvortex_afu_shim.h"
 #include "Vvortex_afu_shim__Syms.h"
 
-#ifdef VCD_OUTPUT
-#include <verilated_vcd_c.h>
-#endif
-
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <atomic>
+#include <thread>
+#include <util.h>
 #include <mem.h>
-
-#define CCI_LATENCY  8
-#define CCI_RAND_MOD 8
-#define CCI_RQ_SIZE 16
-#define CCI_WQ_SIZE 16
-
-#define ENABLE_MEM_STALLS
-
-#ifndef TRACE_START_TIME
-#define TRACE_START_TIME 0ull
-#endif
-
-#ifndef TRACE_STOP_TIME
-#define TRACE_STOP_TIME -1ull
-#endif
-
-#ifndef MEM_LATENCY
-#define MEM_LATENCY 24
-#endif
-
-#ifndef MEM_RQ_SIZE
-#define MEM_RQ_SIZE 16
-#endif
-
-#ifndef MEM_STALLS_MODULO
-#define MEM_STALLS_MODULO 16
-#endif
+#include <perf_trace.h>
+#include <pipe_trace.h>
+#include <vl_trace.h>
 
 #ifndef VERILATOR_RESET_VALUE
 #define VERILATOR_RESET_VALUE 2
@@ -46,6 +21,7 @@
 
 using namespace vortex;
 
+// only advanced between evaluations, DPI calls may read it from worker threads
 static uint64_t timestamp = 0;
 
 double sc_time_stamp() { 
@@ -69,13 +45,15 @@ static void __aligned_free(void *ptr) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static bool trace_enabled = false;
-static uint64_t trace_start_time = TRACE_START_TIME;
-static uint64_t trace_stop_time = TRACE_STOP_TIME;
+// toggled by DPI calls on any Verilator worker thread
+static std::atomic<bool> trace_enabled(false);
+static uint64_t trace_start_cycle = 0;
+static uint64_t trace_stop_cycle = -1ull;
 
 bool sim_trace_enabled() {
-  if (timestamp >= trace_start_time 
-   && timestamp < trace_stop_time)
+  uint64_t cycle = timestamp / 2;
+  if (cycle >= trace_start_cycle 
+   && cycle < trace_stop_cycle)
     return true;
   return trace_enabled;
 }
@@ -84,6 +62,15 @@ void sim_trace_enable(bool enable) {
   trace_enabled = enable;
 }
 
+// performance sampling and pipeline tracing are not supported by the AFU simulator
+PerfTrace* sim_perf_trace() {
+  return nullptr;
+}
+
+PipeTrace* sim_pipe_trace() {
+  return nullptr;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 namespace vortex {
@@ -94,9 +81,7 @@ public:
 #else
   Vvortex_afu_shim *device;
 #endif
-#ifdef VCD_OUTPUT
-  VerilatedVcdC *trace;
-#endif
+  VlTracer<Vvortex_afu_shim> *tracer;
 
   VL_OBJ() {
     // force random values for unitialized signals  
@@ -106,25 +91,20 @@ public:
     // Turn off assertion before reset
     Verilated::assertOn(false);
 
+  #ifdef TRACE_ENABLE
+    Verilated::traceEverOn(true);
+  #endif
+
   #ifdef AXI_BUS
     this->device = new Vvortex_afu_shim();
   #else
     this->device = new Vvortex_afu_shim();
   #endif
-
-  #ifdef VCD_OUTPUT
-    Verilated::traceEverOn(true);
-    this->trace = new VerilatedVcdC();
-    this->device->trace(this->trace, 99);
-    this->trace->open("trace.vcd");
-  #endif
+    this->tracer = new VlTracer<Vvortex_afu_shim>(this->device);
   }
 
   ~VL_OBJ() {
-  #ifdef VCD_OUTPUT
-    this->trace->close();
-    delete this->trace;
-  #endif
+    delete this->tracer;
     delete this->device;
   }
 };
@@ -134,30 +114,68 @@ public:
 
 opae_sim::opae_sim() 
   : stop_(false)
-  , host_buffer_ids_(0) {  
+  , mmio_posted_(nullptr)
+  , mmio_pending_(nullptr)
+  , sleeping_(false)
+  , host_buffer_ids_(0)
+  , step_cycles_(0)
+  , step_time_(0) {  
   vl_obj_ = new VL_OBJ();
   ram_ = new RAM((1<<12), (1<<20));
+}
+
+int opae_sim::init() {
+  // each local memory bank is a separate DRAM device
+  DramConfig dram_config;
+  if (0 == dram_config.load_env()) {
+    for (int b = 0; b < MEMORY_BANKS; ++b) {
+      dram_[b] = DramSim(dram_config);
+    }
+  }
+
+  // host link timing
+  CciConfig cci_config;
+  if (cci_config.load_env() != 0
+   || cci_config.validate(CCI_RQ_SIZE, CCI_MAX_DELAY) != 0)
+    return -1;
+  cci_link_ = CciLink(cci_config);
+
+  // waveform and debug trace window
+  TraceConfig trace_config;
+  trace_config.load_env();
+  trace_start_cycle = trace_config.start;
+  trace_stop_cycle = trace_config.stop;
+  vl_obj_->tracer->configure(trace_config);
 
   // reset the device
   this->reset();
 
   // launch execution thread
   future_ = std::async(std::launch::async, [&]{                   
-      while (!stop_) {
-          std::lock_guard<std::mutex> guard(mutex_);
-          this->step();
-      }
+      this->run();
   }); 
+
+  return 0;
 }
 
 opae_sim::~opae_sim() {  
   stop_ = true;
+  {
+    std::lock_guard<std::mutex> guard(wake_mutex_);
+    wake_cv_.notify_one();
+  }
   if (future_.valid()) {
     future_.wait();
   } 
   for (auto& buffer : host_buffers_) {
     __aligned_free(buffer.second.data);
   }   
+  if (getenv("VORTEX_SIM_THROUGHPUT")) {
+    print_throughput(std::cout, step_cycles_, step_time_);
+  }
+  if (getenv("VORTEX_CCI_CONFIG")) {
+    cci_link_.print_stats(std::cout);
+  }
   delete vl_obj_;
   delete ram_;
 }
@@ -166,6 +184,7 @@ int opae_sim::prepare_buffer(uint64_t len, void **buf_addr, uint64_t *wsid, int
   auto alloc = __aligned_malloc(CACHE_BLOCK_SIZE, len);
   if (alloc == NULL)
     return -1;
+  std::lock_guard<std::mutex> guard(mutex_);
   host_buffer_t buffer;
   buffer.data   = (uint64_t*)alloc;
   buffer.size   = len;
@@ -178,6 +197,7 @@ int opae_sim::prepare_buffer(uint64_t len, void **buf_addr, uint64_t *wsid, int
 }
 
 void opae_sim::release_buffer(uint64_t wsid) {
+  std::lock_guard<std::mutex> guard(mutex_);
   auto it = host_buffers_.find(wsid);
   if (it != host_buffers_.end()) {
     __aligned_free(it->second.data);
@@ -186,32 +206,111 @@ void opae_sim::release_buffer(uint64_t wsid) {
 }
 
 void opae_sim::get_io_address(uint64_t wsid, uint64_t *ioaddr) {
+  std::lock_guard<std::mutex> guard(mutex_);
   *ioaddr = host_buffers_[wsid].ioaddr;
 }
 
 void opae_sim::read_mmio64(uint32_t mmio_num, uint64_t offset, uint64_t *value) {
-  std::lock_guard<std::mutex> guard(mutex_);
-
-  vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid = 1;
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
-  this->step();  
-  vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid = 0;
-  assert(vl_obj_->device->af2cp_sTxPort_c2_mmioRdValid);  
-  *value = vl_obj_->device->af2cp_sTxPort_c2_data;
+  __unused(mmio_num);
+  mmio_req_t req;
+  req.offset = offset;
+  req.write  = false;
+  this->post_mmio(&req);
+  *value = req.value;
 }
 
 void opae_sim::write_mmio64(uint32_t mmio_num, uint64_t offset, uint64_t value) {
-  std::lock_guard<std::mutex> guard(mutex_);
-  
-  vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid = 1;  
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_address = offset / 4;
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
-  vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
-  memcpy(vl_obj_->device->vcp2af_sRxPort_c0_data, &value, 8);
-  this->step();
-  vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid = 0;
+  __unused(mmio_num);
+  mmio_req_t req;
+  req.offset = offset;
+  req.value  = value;
+  req.write  = true;
+  this->post_mmio(&req);
+}
+
+void opae_sim::post_mmio(mmio_req_t* req) {
+  req->done = false;
+  req->next = mmio_posted_.load(std::memory_order_relaxed);
+  while (!mmio_posted_.compare_exchange_weak(req->next, req));
+
+  // wake up the simulation thread, the lock orders this notification
+  // after its last check of the mailbox
+  if (sleeping_) {
+    std::lock_guard<std::mutex> guard(wake_mutex_);
+    wake_cv_.notify_one();
+  }
+
+  // requests complete within a cycle of being picked up
+  while (!req->done.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+}
+
+opae_sim::mmio_req_t* opae_sim::pop_mmio() {
+  if (nullptr == mmio_pending_) {
+    // the posted stack is newest first, reverse it
+    auto req = mmio_posted_.exchange(nullptr, std::memory_order_acquire);
+    while (req) {
+      auto next = req->next;
+      req->next = mmio_pending_;
+      mmio_pending_ = req;
+      req = next;
+    }
+  }
+  auto req = mmio_pending_;
+  if (req) {
+    mmio_pending_ = req->next;
+  }
+  return req;
+}
+
+bool opae_sim::is_idle() const {
+  if (!vl_obj_->device->afu_idle
+   || !cci_reads_.empty()
+   || !cci_writes_.empty())
+    return false;
+  for (int b = 0; b < MEMORY_BANKS; ++b) {
+    if (!mem_reads_[b].empty())
+      return false;
+  }
+  return true;
+}
+
+void opae_sim::run() {
+  while (!stop_) {
+    // MMIO requests are applied at cycle boundaries, one per cycle
+    auto req = this->pop_mmio();
+    if (nullptr == req) {
+      if (this->is_idle()) {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        sleeping_ = true;
+        wake_cv_.wait(lock, [&]{ 
+          return stop_ || (mmio_posted_.load() != nullptr); 
+        });
+        sleeping_ = false;
+        continue;
+      }
+      this->step();
+      continue;
+    }
+
+    vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_address = req->offset / 4;
+    vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_length = 1;
+    vl_obj_->device->vcp2af_sRxPort_c0_ReqMmioHdr_tid = 0;
+    if (req->write) {
+      vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid = 1;
+      memcpy(vl_obj_->device->vcp2af_sRxPort_c0_data, &req->value, 8);
+      this->step();
+      vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid = 0;
+    } else {
+      vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid = 1;
+      this->step();
+      vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid = 0;
+      assert(vl_obj_->device->af2cp_sTxPort_c2_mmioRdValid);
+      req->value = vl_obj_->device->af2cp_sTxPort_c2_data;
+    }
+    req->done.store(true, std::memory_order_release);
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -219,6 +318,7 @@ void opae_sim::write_mmio64(uint32_t mmio_num, uint64_t offset, uint64_t value)
 void opae_sim::reset() {  
   cci_reads_.clear();
   cci_writes_.clear();
+  cci_link_.reset();
   vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid = 0;
   vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid = 0;
   vl_obj_->device->vcp2af_sRxPort_c0_rspValid = 0;  
@@ -228,6 +328,7 @@ void opae_sim::reset() {
 
   for (int b = 0; b < MEMORY_BANKS; ++b) {
     mem_reads_[b].clear();
+    dram_[b].reset();
     vl_obj_->device->avs_readdatavalid[b] = 0;  
     vl_obj_->device->avs_waitrequest[b] = 0;
   }
@@ -248,6 +349,8 @@ void opae_sim::reset() {
 }
 
 void opae_sim::step() {
+  auto start_time = std::chrono::steady_clock::now();
+
   this->sRxPort_bus();
   this->sTxPort_bus();
   this->avs_bus();
@@ -257,6 +360,9 @@ void opae_sim::step() {
   vl_obj_->device->clk = 1;
   this->eval();
 
+  step_time_ += std::chrono::steady_clock::now() - start_time;
+  ++step_cycles_;
+
 #ifndef NDEBUG
   fflush(stdout);
 #endif
@@ -264,11 +370,7 @@ void opae_sim::step() {
 
 void opae_sim::eval() {  
   vl_obj_->device->eval();
-#ifdef VCD_OUTPUT
-  if (sim_trace_enabled()) {
-    vl_obj_->trace->dump(timestamp);
-  }
-#endif
+  vl_obj_->tracer->dump(timestamp);
   ++timestamp;
 }
 
@@ -277,123 +379,86 @@ void opae_sim::sRxPort_bus() {
   bool mmio_req_enabled = vl_obj_->device->vcp2af_sRxPort_c0_mmioRdValid
                        || vl_obj_->device->vcp2af_sRxPort_c0_mmioWrValid;
 
-  // schedule CCI read responses
-  std::list<cci_rd_req_t>::iterator cci_rd_it(cci_reads_.end());
-  for (auto it = cci_reads_.begin(), ie = cci_reads_.end(); it != ie; ++it) {
-    if (it->cycles_left > 0)
-      it->cycles_left -= 1;
-    if ((cci_rd_it == ie) && (it->cycles_left == 0)) {
-      cci_rd_it = it;
-    }
-  }
-
-  // schedule CCI write responses
-  std::list<cci_wr_req_t>::iterator cci_wr_it(cci_writes_.end());
-  for (auto it = cci_writes_.begin(), ie = cci_writes_.end(); it != ie; ++it) {
-    if (it->cycles_left > 0)
-      it->cycles_left -= 1;
-    if ((cci_wr_it == ie) && (it->cycles_left == 0)) {
-      cci_wr_it = it;
-    }
-  }
+  // schedule CCI responses
+  uint64_t cycle = timestamp / 2;
+  cci_reads_.advance(cycle);
+  cci_writes_.advance(cycle);
 
   // send CCI write response  
   vl_obj_->device->vcp2af_sRxPort_c1_rspValid = 0;  
-  if (cci_wr_it != cci_writes_.end()) {
+  if (cci_writes_.ready()) {
     vl_obj_->device->vcp2af_sRxPort_c1_rspValid = 1;
     vl_obj_->device->vcp2af_sRxPort_c1_hdr_resp_type = 0;
-    vl_obj_->device->vcp2af_sRxPort_c1_hdr_mdata = cci_wr_it->mdata;
-    cci_writes_.erase(cci_wr_it);
+    vl_obj_->device->vcp2af_sRxPort_c1_hdr_mdata = cci_writes_.front().mdata;
+    cci_writes_.pop();
+    cci_link_.write_done();
   }
 
   // send CCI read response (ensure mmio disabled) 
   vl_obj_->device->vcp2af_sRxPort_c0_rspValid = 0;  
   if (!mmio_req_enabled 
-   && (cci_rd_it != cci_reads_.end())) {
+   && cci_reads_.ready()) {
+    auto& cci_rsp = cci_reads_.front();
     vl_obj_->device->vcp2af_sRxPort_c0_rspValid = 1;
     vl_obj_->device->vcp2af_sRxPort_c0_hdr_resp_type = 0;
-    memcpy(vl_obj_->device->vcp2af_sRxPort_c0_data, cci_rd_it->data.data(), CACHE_BLOCK_SIZE);
-    vl_obj_->device->vcp2af_sRxPort_c0_hdr_mdata = cci_rd_it->mdata;    
-    /*printf("%0ld: [sim] CCI Rd Rsp: addr=%ld, mdata=%d, data=", timestamp, cci_rd_it->addr, cci_rd_it->mdata);
+    memcpy(vl_obj_->device->vcp2af_sRxPort_c0_data, cci_rsp.data.data(), CACHE_BLOCK_SIZE);
+    vl_obj_->device->vcp2af_sRxPort_c0_hdr_mdata = cci_rsp.mdata;    
+    /*printf("%0ld: [sim] CCI Rd Rsp: addr=%ld, mdata=%d, data=", timestamp, cci_rsp.addr, cci_rsp.mdata);
     for (int i = 0; i < CACHE_BLOCK_SIZE; ++i)
-      printf("%02x", cci_rd_it->data[CACHE_BLOCK_SIZE-1-i]);
+      printf("%02x", cci_rsp.data[CACHE_BLOCK_SIZE-1-i]);
     printf("\n");*/
-    cci_reads_.erase(cci_rd_it);
+    cci_reads_.pop();
+    cci_link_.read_done();
   }
 }
   
 void opae_sim::sTxPort_bus() {
+  uint64_t cycle = timestamp / 2;
+
   // process read requests
   if (vl_obj_->device->af2cp_sTxPort_c0_valid) {
     assert(!vl_obj_->device->vcp2af_sRxPort_c0_TxAlmFull);
-    cci_rd_req_t cci_req;
-    cci_req.cycles_left = CCI_LATENCY + (timestamp % CCI_RAND_MOD);     
+    auto ready = cci_link_.read(vl_obj_->device->af2cp_sTxPort_c0_hdr_vc_sel, cycle);
+    auto& cci_req = cci_reads_.push(ready);
     cci_req.addr = vl_obj_->device->af2cp_sTxPort_c0_hdr_address;
     cci_req.mdata = vl_obj_->device->af2cp_sTxPort_c0_hdr_mdata;
     auto host_ptr = (uint64_t*)(vl_obj_->device->af2cp_sTxPort_c0_hdr_address * CACHE_BLOCK_SIZE);
     memcpy(cci_req.data.data(), host_ptr, CACHE_BLOCK_SIZE);
     //printf("%0ld: [sim] CCI Rd Req: addr=%ld, mdata=%d\n", timestamp, vl_obj_->device->af2cp_sTxPort_c0_hdr_address, cci_req.mdata);
-    cci_reads_.emplace_back(cci_req);    
   }
 
   // process write requests
   if (vl_obj_->device->af2cp_sTxPort_c1_valid) {
     assert(!vl_obj_->device->vcp2af_sRxPort_c1_TxAlmFull);
-    cci_wr_req_t cci_req;
-    cci_req.cycles_left = CCI_LATENCY + (timestamp % CCI_RAND_MOD);
+    auto ready = cci_link_.write(vl_obj_->device->af2cp_sTxPort_c1_hdr_vc_sel, cycle);
+    auto& cci_req = cci_writes_.push(ready);
     cci_req.mdata = vl_obj_->device->af2cp_sTxPort_c1_hdr_mdata;
     auto host_ptr = (uint64_t*)(vl_obj_->device->af2cp_sTxPort_c1_hdr_address * CACHE_BLOCK_SIZE);
     memcpy(host_ptr, vl_obj_->device->af2cp_sTxPort_c1_data, CACHE_BLOCK_SIZE);
-    cci_writes_.emplace_back(cci_req);
   } 
 
-  // check queues overflow
-  vl_obj_->device->vcp2af_sRxPort_c0_TxAlmFull = (cci_reads_.size() >= (CCI_RQ_SIZE-1));
-  vl_obj_->device->vcp2af_sRxPort_c1_TxAlmFull = (cci_writes_.size() >= (CCI_WQ_SIZE-1));
+  // throttle the AFU when the link runs out of credits
+  vl_obj_->device->vcp2af_sRxPort_c0_TxAlmFull = cci_link_.rd_almost_full();
+  vl_obj_->device->vcp2af_sRxPort_c1_TxAlmFull = cci_link_.wr_almost_full();
 }
   
 void opae_sim::avs_bus() {
+  uint64_t cycle = timestamp / 2;
   for (int b = 0; b < MEMORY_BANKS; ++b) {
-    // update memory responses schedule
-    for (auto& rsp : mem_reads_[b]) {
-      if (rsp.cycles_left > 0)
-        rsp.cycles_left -= 1;
-    }
-
-    // schedule memory responses in FIFO order
-    std::list<mem_rd_req_t>::iterator mem_rd_it(mem_reads_[b].end());
-    if (!mem_reads_[b].empty() 
-    && (0 == mem_reads_[b].begin()->cycles_left)) {
-        mem_rd_it = mem_reads_[b].begin();
-    }
-
-    // send memory response  
+    // send memory responses in FIFO order
     vl_obj_->device->avs_readdatavalid[b] = 0;  
-    if (mem_rd_it != mem_reads_[b].end()) {
+    if (mem_reads_[b].ready(cycle)) {
+      auto& mem_rsp = mem_reads_[b].front();
       vl_obj_->device->avs_readdatavalid[b] = 1;
-      memcpy(vl_obj_->device->avs_readdata[b], mem_rd_it->data.data(), MEM_BLOCK_SIZE);
-      uint32_t addr = mem_rd_it->addr;
-      mem_reads_[b].erase(mem_rd_it);
-      /*printf("%0ld: [sim] MEM Rd Rsp: bank=%d, addr=%x, pending={", timestamp, b, addr * MEM_BLOCK_SIZE);
-      for (auto& req : mem_reads_[b]) {
-        if (req.cycles_left != 0) 
-          printf(" !%0x", req.addr * MEM_BLOCK_SIZE);
-        else
-          printf(" %0x", req.addr * MEM_BLOCK_SIZE);
-      }
-      printf("}\n");*/
+      memcpy(vl_obj_->device->avs_readdata[b], mem_rsp.data.data(), MEM_BLOCK_SIZE);
+      /*printf("%0ld: [sim] MEM Rd Rsp: bank=%d, addr=%x, pending=%d\n", timestamp, b, mem_rsp.addr * MEM_BLOCK_SIZE, mem_reads_[b].size() - 1);*/
+      mem_reads_[b].pop();
     }
 
     // handle memory stalls
-    bool mem_stalled = false;
-  #ifdef ENABLE_MEM_STALLS
-    if (0 == ((timestamp/2) % MEM_STALLS_MODULO)) { 
-      mem_stalled = true;
-    } else
-    if (mem_reads_[b].size() >= MEM_RQ_SIZE) {
-      mem_stalled = true;
-    }
-  #endif
+    uint64_t req_addr = vl_obj_->device->avs_address[b] * MEM_BLOCK_SIZE;
+    bool mem_stalled = mem_reads_[b].full() 
+                    || !dram_[b].ready(req_addr, cycle);
 
     // process memory requests
     if (!mem_stalled) {
@@ -407,6 +472,8 @@ void opae_sim::avs_bus() {
             (*ram_)[base_addr + i] = data[i];
           }
         }
+        // posted write, only occupies the DRAM
+        dram_[b].access(base_addr, true, cycle);
         /*printf("%0ld: [sim] MEM Wr Req: bank=%d, addr=%x, data=", timestamp, b, base_addr);
         for (int i = 0; i < MEM_BLOCK_SIZE; i++) {
           printf("%02x", data[(MEM_BLOCK_SIZE-1)-i]);
@@ -414,26 +481,13 @@ void opae_sim::avs_bus() {
         printf("\n");*/
       }
       if (vl_obj_->device->avs_read[b]) {
-        mem_rd_req_t mem_req;      
+        // duplicate requests complete with the pending one
+        uint32_t addr = vl_obj_->device->avs_address[b];
+        uint64_t ready = mem_reads_[b].contains(addr) ? cycle : dram_[b].access(req_addr, false, cycle);
+        auto& mem_req = mem_reads_[b].push(addr, ready);
         mem_req.addr = vl_obj_->device->avs_address[b];
         ram_->read(mem_req.data.data(), vl_obj_->device->avs_address[b] * MEM_BLOCK_SIZE, MEM_BLOCK_SIZE);      
-        mem_req.cycles_left = MEM_LATENCY;
-        for (auto& rsp : mem_reads_[b]) {
-          if (mem_req.addr == rsp.addr) {
-            // duplicate requests receive the same cycle delay
-            mem_req.cycles_left = rsp.cycles_left;
-            break;
-          }
-        }
-        mem_reads_[b].emplace_back(mem_req);
-        /*printf("%0ld: [sim] MEM Rd Req: bank=%d, addr=%x, pending={", timestamp, b, mem_req.addr * MEM_BLOCK_SIZE);
-        for (auto& req : mem_reads_[b]) {
-          if (req.cycles_left != 0) 
-            printf(" !%0x", req.addr * MEM_BLOCK_SIZE);
-          else
-            printf(" %0x", req.addr * MEM_BLOCK_SIZE);
-        }
-        printf("}\n");*/
+        /*printf("%0ld: [sim] MEM Rd Req: bank=%d, addr=%x, pending=%d\n", timestamp, b, mem_req.addr * MEM_BLOCK_SIZE, mem_reads_[b].size());*/
       }
     }
 
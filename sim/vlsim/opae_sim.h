@@ -5,8 +5,15 @@
 
 #include <ostream>
 #include <future>
-#include <list>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <array>
 #include <unordered_map>
+#include <mem_sched.h>
+#include <dram.h>
+#include "cci_link.h"
 
 #ifndef MEMORY_BANKS 
   #ifdef PLATFORM_PARAM_LOCAL_MEMORY_BANKS
@@ -21,6 +28,15 @@
 
 #define CACHE_BLOCK_SIZE  64
 
+// upper bounds of the CCI link credits and completion delay
+#define CCI_RQ_SIZE 256
+#define CCI_WQ_SIZE 256
+#define CCI_MAX_DELAY 1024
+
+#ifndef MEM_RQ_SIZE
+#define MEM_RQ_SIZE 16
+#endif
+
 namespace vortex {
 
 class VL_OBJ;
@@ -32,6 +48,9 @@ public:
   opae_sim();
   virtual ~opae_sim();
 
+  // load the timing configs and start the device, -1 on a bad config
+  int init();
+
   int prepare_buffer(uint64_t len, void **buf_addr, uint64_t *wsid, int flags);
 
   void release_buffer(uint64_t wsid);
@@ -45,20 +64,17 @@ public:
 private: 
 
   typedef struct {
-    int cycles_left;  
     std::array<uint8_t, MEM_BLOCK_SIZE> data;
     uint32_t addr;
   } mem_rd_req_t;
 
   typedef struct {
-    int cycles_left;  
     std::array<uint8_t, CACHE_BLOCK_SIZE> data;
     uint64_t addr;
     uint32_t mdata;
   } cci_rd_req_t;
 
   typedef struct {
-    int cycles_left;  
     uint32_t mdata;
   } cci_wr_req_t;
 
@@ -68,8 +84,25 @@ private:
     uint64_t  ioaddr;  
   } host_buffer_t;
 
+  // MMIO request posted by the host, completed by the simulation thread
+  struct mmio_req_t {
+    uint64_t          offset;
+    uint64_t          value;
+    bool              write;
+    std::atomic<bool> done;
+    mmio_req_t*       next;
+  };
+
   void reset();
 
+  void run();
+
+  bool is_idle() const;
+
+  void post_mmio(mmio_req_t* req);
+
+  mmio_req_t* pop_mmio();
+
   void eval();
 
   void step();
@@ -79,21 +112,39 @@ private:
   void avs_bus();
 
   std::future<void> future_;
-  bool stop_;
+  std::atomic<bool> stop_;
+
+  // lock-free stack of posted requests, the simulation thread keeps
+  // them in arrival order in mmio_pending_
+  std::atomic<mmio_req_t*> mmio_posted_;
+  mmio_req_t* mmio_pending_;
+
+  // the simulation thread sleeps while the AFU is idle
+  std::atomic<bool> sleeping_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
 
   std::unordered_map<int64_t, host_buffer_t> host_buffers_;
   int64_t host_buffer_ids_;
 
-  std::list<mem_rd_req_t> mem_reads_ [MEMORY_BANKS];
+  MemRspQueue<mem_rd_req_t, MEM_RQ_SIZE> mem_reads_ [MEMORY_BANKS];
 
-  std::list<cci_rd_req_t> cci_reads_;
+  TimingWheel<cci_rd_req_t, CCI_RQ_SIZE, CCI_MAX_DELAY> cci_reads_;
 
-  std::list<cci_wr_req_t> cci_writes_;
+  TimingWheel<cci_wr_req_t, CCI_WQ_SIZE, CCI_MAX_DELAY> cci_writes_;
 
+  CciLink cci_link_;
+
+  // guards host_buffers_
   std::mutex mutex_;
 
   RAM *ram_;
 
+  DramSim dram_ [MEMORY_BANKS];
+
+  uint64_t step_cycles_;
+  std::chrono::steady_clock::duration step_time_;
+
   VL_OBJ* vl_obj_;
 };
 
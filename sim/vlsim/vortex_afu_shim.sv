@@ -70,6 +70,9 @@ module vortex_afu_shim (
   output t_ccip_tid           af2cp_sTxPort_c2_hdr_tid,
   output logic                af2cp_sTxPort_c2_mmioRdValid,   
   output t_ccip_mmioData      af2cp_sTxPort_c2_data,       
+
+  // AFU command state is idle (simulation only)
+  output logic                afu_idle,
   
   // Avalon signals for local memory access
   output  t_local_mem_data      avs_writedata [`PLATFORM_PARAM_LOCAL_MEMORY_BANKS],
@@ -167,4 +170,6 @@ assign af2cp_sTxPort_c2_hdr_tid = af2cp_sTxPort.c2.hdr.tid;
 assign af2cp_sTxPort_c2_mmioRdValid = af2cp_sTxPort.c2.mmioRdValid;  
 assign af2cp_sTxPort_c2_data = af2cp_sTxPort.c2.data;
 
+assign afu_idle = (afu.state == 0); // STATE_IDLE
+
 endmodule
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <unistd.h>
+#include <string.h>
+#include <vector>
+#include <vortex.h>
+#include "common.h"
+
+#define RT_CHECK(_expr)                                         \
+   do {                                                         \
+     int _ret = _expr;                                          \
+     if (0 == _ret)                                             \
+       break;                                                   \
+     printf("Error: '%s' returned %d!\n", #_expr, (int)_ret);   \
+	 cleanup();			                                              \
+     exit(-1);                                                  \
+   } while (false)
+
+// image width in words, the copied tile skips the first and last column
+#define IMAGE_WIDTH 16
+#define TILE_WIDTH  (IMAGE_WIDTH - 2)
+#define TILE_VALUE  0x10000
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* kernel_file = "kernel.bin";
+uint32_t count = 0;
+
+vx_device_h device = nullptr;
+vx_buffer_h staging_buf = nullptr;
+
+static void show_usage() {
+   std::cout << "Vortex Test." << std::endl;
+   std::cout << "Usage: [-k: kernel] [-n words] [-h: help]" << std::endl;
+}
+
+static void parse_args(int argc, char **argv) {
+  int c;
+  while ((c = getopt(argc, argv, "n:k:h?")) != -1) {
+    switch (c) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'k':
+      kernel_file = optarg;
+      break;
+    case 'h':
+    case '?': {
+      show_usage();
+      exit(0);
+    } break;
+    default:
+      show_usage();
+      exit(-1);
+    }
+  }
+}
+
+void cleanup() {
+  if (staging_buf) {
+    vx_buf_release(staging_buf);
+  }
+  if (device) {
+    vx_dev_close(device);
+  }
+}
+
+int check_values(const int32_t* values, const std::vector<int32_t>& refs, const char* name) {
+  int errors = 0;
+  for (uint32_t i = 0; i < refs.size(); ++i) {
+    if (values[i] != refs[i]) {
+      std::cout << "error at " << name << " #" << std::dec << i
+                << std::hex << ": actual 0x" << values[i] << ", expected 0x" << refs[i] << std::endl;
+      ++errors;
+    }
+  }
+  if (errors != 0) {
+    std::cout << "Found " << std::dec << errors << " errors!" << std::endl;
+    std::cout << "FAILED!" << std::endl;
+    return 1;  
+  }
+  return 0;
+}
+
+int run_test(const kernel_arg_t& kernel_arg,
+             uint32_t buf_size, 
+             uint32_t num_points) {
+  uint32_t height     = num_points / IMAGE_WIDTH;
+  uint32_t pitch      = IMAGE_WIDTH * sizeof(int32_t);
+  uint32_t tile_pitch = TILE_WIDTH * sizeof(int32_t);
+  auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+
+  // expected source image, the tile overwrites all but the edge columns
+  std::vector<int32_t> ref_image(num_points);
+  for (uint32_t i = 0; i < num_points; ++i) {
+    uint32_t x = i % IMAGE_WIDTH;
+    ref_image[i] = (x != 0 && x != IMAGE_WIDTH-1) ? (TILE_VALUE + i) : i;
+  }
+
+  // upload the background image
+  std::cout << "upload source image" << std::endl;
+  for (uint32_t i = 0; i < num_points; ++i) {
+    buf_ptr[i] = i;
+  }
+  RT_CHECK(vx_copy_to_dev(staging_buf, kernel_arg.src_ptr, buf_size, 0));
+
+  // upload the tile, every row only partially covers its cache blocks
+  std::cout << "upload source tile" << std::endl;
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < TILE_WIDTH; ++x) {
+      buf_ptr[y * TILE_WIDTH + x] = TILE_VALUE + y * IMAGE_WIDTH + x + 1;
+    }
+  }
+  RT_CHECK(vx_copy_to_dev_2d(staging_buf, kernel_arg.src_ptr + sizeof(int32_t), pitch, 0, tile_pitch, tile_pitch, height));
+
+  // start device
+  std::cout << "start device" << std::endl;
+  RT_CHECK(vx_start(device));
+
+  // wait for completion
+  std::cout << "wait for completion" << std::endl;
+  RT_CHECK(vx_ready_wait(device, -1));
+
+  // download the destination tile
+  std::cout << "download destination tile" << std::endl;
+  memset(buf_ptr, 0, buf_size);
+  RT_CHECK(vx_copy_from_dev_2d(staging_buf, kernel_arg.dst_ptr + sizeof(int32_t), pitch, 0, tile_pitch, tile_pitch, height));
+  {
+    std::vector<int32_t> refs(height * TILE_WIDTH);
+    for (uint32_t y = 0; y < height; ++y) {
+      for (uint32_t x = 0; x < TILE_WIDTH; ++x) {
+        refs[y * TILE_WIDTH + x] = ref_image[y * IMAGE_WIDTH + x + 1] + 1;
+      }
+    }
+    RT_CHECK(check_values(buf_ptr, refs, "tile"));
+  }
+
+  // download the edge columns as a list of single words
+  std::cout << "download destination edges" << std::endl;
+  memset(buf_ptr, 0, buf_size);
+  {
+    std::vector<vx_copy_desc_t> descs(2 * height);
+    std::vector<int32_t> refs(2 * height);
+    for (uint32_t i = 0; i < 2 * height; ++i) {
+      uint32_t index = (i / 2) * IMAGE_WIDTH + (i % 2) * (IMAGE_WIDTH - 1);
+      descs[i].dev_maddr = kernel_arg.dst_ptr + index * sizeof(int32_t);
+      descs[i].offset    = i * sizeof(int32_t);
+      descs[i].size      = sizeof(int32_t);
+      refs[i] = ref_image[index] + 1;
+    }
+    RT_CHECK(vx_copy_from_dev_sg(staging_buf, descs.data(), descs.size()));
+    RT_CHECK(check_values(buf_ptr, refs, "edge"));
+  }
+
+  // download the whole destination image
+  std::cout << "verify destination image" << std::endl;
+  memset(buf_ptr, 0, buf_size);
+  RT_CHECK(vx_copy_from_dev(staging_buf, kernel_arg.dst_ptr, buf_size, 0));
+  {
+    std::vector<int32_t> refs(num_points);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      refs[i] = ref_image[i] + 1;
+    }
+    RT_CHECK(check_values(buf_ptr, refs, "result"));
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  size_t value; 
+  kernel_arg_t kernel_arg;
+  
+  // parse command arguments
+  parse_args(argc, argv);
+
+  // keep whole image rows
+  count = (count + IMAGE_WIDTH - 1) & ~(IMAGE_WIDTH - 1);
+  if (count == 0) {
+    count = IMAGE_WIDTH;
+  }
+
+  // open device connection
+  std::cout << "open device connection" << std::endl;  
+  RT_CHECK(vx_dev_open(&device));
+
+  unsigned max_cores, max_warps, max_threads;
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_CORES, &max_cores));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_WARPS, &max_warps));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_THREADS, &max_threads));
+
+  uint32_t num_tasks  = max_cores * max_warps * max_threads;
+  uint32_t num_points = count * num_tasks;
+  uint32_t buf_size   = num_points * sizeof(int32_t);
+
+  std::cout << "number of points: " << num_points << std::endl;
+  std::cout << "buffer size: " << buf_size << " bytes" << std::endl;
+
+  // upload program
+  std::cout << "upload program" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+
+  // allocate device memory
+  std::cout << "allocate device memory" << std::endl;  
+
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.src_ptr = value;
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.dst_ptr = value;
+
+  kernel_arg.num_tasks = num_tasks;
+  kernel_arg.task_size = count;
+
+  std::cout << "dev_src=" << std::hex << kernel_arg.src_ptr << std::endl;
+  std::cout << "dev_dst=" << std::hex << kernel_arg.dst_ptr << std::endl;
+  
+  // allocate shared memory  
+  std::cout << "allocate shared memory" << std::endl;    
+  RT_CHECK(vx_alloc_shared_mem(device, buf_size, &staging_buf));
+  
+  // upload kernel argument
+  std::cout << "upload kernel argument" << std::endl;
+  {
+    auto buf_ptr = (int*)vx_host_ptr(staging_buf);
+    memcpy(buf_ptr, &kernel_arg, sizeof(kernel_arg_t));
+    RT_CHECK(vx_copy_to_dev(staging_buf, KERNEL_ARG_DEV_MEM_ADDR, sizeof(kernel_arg_t), 0));
+  }
+
+  // run tests
+  std::cout << "run tests" << std::endl;
+  RT_CHECK(run_test(kernel_arg, buf_size, num_points));
+
+  // cleanup
+  std::cout << "cleanup" << std::endl;  
+  cleanup();
+
+  std::cout << "PASSED!" << std::endl;
+
+  return 0;
+}
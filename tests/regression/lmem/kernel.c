@@ -0,0 +1,49 @@
+#include <stdint.h>
+#include <vx_intrinsics.h>
+#include <vx_spawn.h>
+#include "common.h"
+
+// Workgroup sum through local memory
+
+void kernel_body(kernel_arg_t* arg, const context_t* ctx,
+                 uint32_t group_x, uint32_t group_y, uint32_t group_z,
+                 uint32_t local_x, uint32_t local_y, uint32_t local_z,
+                 void* local_mem) {
+	int32_t* src_ptr = (int32_t*)arg->src_ptr;
+	int32_t* dst_ptr = (int32_t*)arg->dst_ptr;
+	int32_t* sums    = (int32_t*)local_mem;
+	uint32_t size    = ctx->local_size[0];
+
+	sums[local_x] = src_ptr[group_x * size + local_x];
+	vx_group_barrier();
+
+	// tree reduction, the group size needs not be a power of two
+	for (uint32_t stride = 1; stride < size; stride *= 2) {
+		__if (0 == (local_x & (2 * stride - 1)) && (local_x + stride) < size) {
+			sums[local_x] += sums[local_x + stride];
+		}__endif
+		vx_group_barrier();
+	}
+
+	__if (0 == local_x) {
+		dst_ptr[group_x] = sums[0];
+	}__endif
+}
+
+void main() {
+	kernel_arg_t* arg = (kernel_arg_t*)KERNEL_ARG_DEV_MEM_ADDR;
+
+	context_t ctx;
+	ctx.num_groups[0] = arg->num_groups;
+	ctx.num_groups[1] = 1;
+	ctx.num_groups[2] = 1;
+	ctx.global_offset[0] = 0;
+	ctx.global_offset[1] = 0;
+	ctx.global_offset[2] = 0;
+	ctx.local_size[0] = arg->local_size;
+	ctx.local_size[1] = 1;
+	ctx.local_size[2] = 1;
+	ctx.work_dim = 1;
+
+	vx_spawn_kernel_groups(&ctx, (vx_spawn_group_cb)kernel_body, arg, arg->local_size * sizeof(int32_t));
+}
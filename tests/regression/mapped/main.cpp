@@ -0,0 +1,201 @@
+#include <iostream>
+#include <unistd.h>
+#include <string.h>
+#include <vortex.h>
+#include "common.h"
+
+#define RT_CHECK(_expr)                                         \
+   do {                                                         \
+     int _ret = _expr;                                          \
+     if (0 == _ret)                                             \
+       break;                                                   \
+     printf("Error: '%s' returned %d!\n", #_expr, (int)_ret);   \
+	 cleanup();			                                              \
+     exit(-1);                                                  \
+   } while (false)
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* kernel_file = "kernel.bin";
+uint32_t count = 0;
+
+vx_device_h device = nullptr;
+vx_buffer_h staging_buf = nullptr;
+vx_buffer_h src_map = nullptr;
+vx_buffer_h dst_map = nullptr;
+
+static void show_usage() {
+   std::cout << "Vortex Test." << std::endl;
+   std::cout << "Usage: [-k: kernel] [-n words] [-h: help]" << std::endl;
+}
+
+static void parse_args(int argc, char **argv) {
+  int c;
+  while ((c = getopt(argc, argv, "n:k:h?")) != -1) {
+    switch (c) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'k':
+      kernel_file = optarg;
+      break;
+    case 'h':
+    case '?': {
+      show_usage();
+      exit(0);
+    } break;
+    default:
+      show_usage();
+      exit(-1);
+    }
+  }
+}
+
+void cleanup() {
+  if (src_map) {
+    vx_buf_release(src_map);
+  }
+  if (dst_map) {
+    vx_buf_release(dst_map);
+  }
+  if (staging_buf) {
+    vx_buf_release(staging_buf);
+  }
+  if (device) {
+    vx_dev_close(device);
+  }
+}
+
+int check_buffer(vx_buffer_h buffer, uint32_t num_points, int delta) {
+  int errors = 0;
+  auto buf_ptr = (int32_t*)vx_host_ptr(buffer);
+  for (uint32_t i = 0; i < num_points; ++i) {
+    int ref = i + delta; 
+    int cur = buf_ptr[i];
+    if (cur != ref) {
+      std::cout << "error at result #" << std::dec << i
+                << std::hex << ": actual 0x" << cur << ", expected 0x" << ref << std::endl;
+      ++errors;
+    }
+  }
+  if (errors != 0) {
+    std::cout << "Found " << std::dec << errors << " errors!" << std::endl;
+    std::cout << "FAILED!" << std::endl;
+    return 1;  
+  }
+  return 0;
+}
+
+int run_test(const kernel_arg_t& kernel_arg,
+             uint32_t buf_size, 
+             uint32_t num_points) {
+  // write the source in place
+  std::cout << "write mapped source buffer" << std::endl;
+  {
+    auto buf_ptr = (int32_t*)vx_host_ptr(src_map);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      buf_ptr[i] = i;
+    }
+  }
+
+  // copying a mapped buffer to its own range is a no-op
+  RT_CHECK(vx_copy_to_dev(src_map, kernel_arg.src_ptr, buf_size, 0));
+  RT_CHECK(check_buffer(src_map, num_points, 0));
+
+  // start device
+  std::cout << "start device" << std::endl;
+  RT_CHECK(vx_start(device));
+
+  // wait for completion
+  std::cout << "wait for completion" << std::endl;
+  RT_CHECK(vx_ready_wait(device, -1));
+
+  // read the result in place
+  std::cout << "verify mapped destination buffer" << std::endl;  
+  RT_CHECK(vx_copy_from_dev(dst_map, kernel_arg.dst_ptr, buf_size, 0));
+  RT_CHECK(check_buffer(dst_map, num_points, 1));
+
+  // a mapped buffer still copies to other ranges
+  std::cout << "copy between mapped ranges" << std::endl;  
+  RT_CHECK(vx_copy_to_dev(dst_map, kernel_arg.src_ptr, buf_size, 0));
+  RT_CHECK(check_buffer(src_map, num_points, 1));
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  size_t value; 
+  kernel_arg_t kernel_arg;
+  
+  // parse command arguments
+  parse_args(argc, argv);
+
+  if (count == 0) {
+    count = 1;
+  }
+
+  // open device connection
+  std::cout << "open device connection" << std::endl;  
+  RT_CHECK(vx_dev_open(&device));
+
+  unsigned max_cores, max_warps, max_threads;
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_CORES, &max_cores));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_WARPS, &max_warps));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_THREADS, &max_threads));
+
+  uint32_t num_tasks  = max_cores * max_warps * max_threads;
+  uint32_t num_points = count * num_tasks;
+  uint32_t buf_size   = num_points * sizeof(int32_t);
+
+  std::cout << "number of points: " << num_points << std::endl;
+  std::cout << "buffer size: " << buf_size << " bytes" << std::endl;
+
+  // upload program
+  std::cout << "upload program" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+
+  // allocate device memory
+  std::cout << "allocate device memory" << std::endl;  
+
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.src_ptr = value;
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.dst_ptr = value;
+
+  kernel_arg.num_tasks = num_tasks;
+  kernel_arg.task_size = count;
+
+  std::cout << "dev_src=" << std::hex << kernel_arg.src_ptr << std::endl;
+  std::cout << "dev_dst=" << std::hex << kernel_arg.dst_ptr << std::endl;
+
+  // map device memory, only simulated devices support it
+  std::cout << "map device memory" << std::endl;  
+  if (vx_map_dev_mem(device, kernel_arg.src_ptr, buf_size, &src_map) != 0) {
+    std::cout << "mapping not supported by this driver, skipped" << std::endl;
+    cleanup();
+    std::cout << "PASSED!" << std::endl;
+    return 0;
+  }
+  RT_CHECK(vx_map_dev_mem(device, kernel_arg.dst_ptr, buf_size, &dst_map));
+  
+  // upload kernel argument
+  std::cout << "upload kernel argument" << std::endl;
+  RT_CHECK(vx_alloc_shared_mem(device, sizeof(kernel_arg_t), &staging_buf));
+  {
+    auto buf_ptr = (int*)vx_host_ptr(staging_buf);
+    memcpy(buf_ptr, &kernel_arg, sizeof(kernel_arg_t));
+    RT_CHECK(vx_copy_to_dev(staging_buf, KERNEL_ARG_DEV_MEM_ADDR, sizeof(kernel_arg_t), 0));
+  }
+
+  // run tests
+  std::cout << "run tests" << std::endl;
+  RT_CHECK(run_test(kernel_arg, buf_size, num_points));
+
+  // cleanup
+  std::cout << "cleanup" << std::endl;  
+  cleanup();
+
+  std::cout << "PASSED!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,247 @@
+#include <iostream>
+#include <unistd.h>
+#include <string.h>
+#include <vortex.h>
+#include "common.h"
+
+#define RT_CHECK(_expr)                                         \
+   do {                                                         \
+     int _ret = _expr;                                          \
+     if (0 == _ret)                                             \
+       break;                                                   \
+     printf("Error: '%s' returned %d!\n", #_expr, (int)_ret);   \
+	 cleanup();			                                              \
+     exit(-1);                                                  \
+   } while (false)
+
+#define TEST_CHECK(_cond)                                       \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     std::cout << "FAILED!" << std::endl;                       \
+     return 1;                                                  \
+   } while (false)
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* kernel_file = "kernel.bin";
+uint32_t count = 0;
+
+vx_device_h device = nullptr;
+vx_buffer_h staging_buf = nullptr;
+
+static void show_usage() {
+   std::cout << "Vortex Test." << std::endl;
+   std::cout << "Usage: [-k: kernel] [-n words] [-h: help]" << std::endl;
+}
+
+static void parse_args(int argc, char **argv) {
+  int c;
+  while ((c = getopt(argc, argv, "n:k:h?")) != -1) {
+    switch (c) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'k':
+      kernel_file = optarg;
+      break;
+    case 'h':
+    case '?': {
+      show_usage();
+      exit(0);
+    } break;
+    default:
+      show_usage();
+      exit(-1);
+    }
+  }
+}
+
+void cleanup() {
+  if (staging_buf) {
+    vx_buf_release(staging_buf);
+  }
+  if (device) {
+    vx_dev_close(device);
+  }
+}
+
+// check that freed blocks coalesce and get reused, returns the reallocated pair
+int test_alloc(uint32_t buf_size, size_t* src_ptr, size_t* dst_ptr) {
+  size_t block_size = CACHE_BLOCK_SIZE;
+  while (block_size < buf_size) {
+    block_size *= 2;
+  }
+
+  size_t free0, used0;
+  RT_CHECK(vx_mem_info(device, &free0, &used0));
+  std::cout << "memory free=" << std::dec << free0 << ", used=" << used0 << std::endl;
+
+  // four blocks of the same size class are laid out side by side
+  size_t addrs[4];
+  for (int i = 0; i < 4; ++i) {
+    RT_CHECK(vx_alloc_dev_mem(device, buf_size, &addrs[i]));
+    std::cout << "block" << i << "=" << std::hex << addrs[i] << std::endl;
+  }
+  for (int i = 1; i < 4; ++i) {
+    TEST_CHECK(addrs[i] == addrs[0] + i * block_size);
+  }
+
+  size_t mem_free, mem_used;
+  RT_CHECK(vx_mem_info(device, &mem_free, &mem_used));
+  TEST_CHECK(mem_used == used0 + 4 * block_size);
+  TEST_CHECK(mem_free == free0 - 4 * block_size);
+
+  // release out of order, the buddies merge back
+  RT_CHECK(vx_mem_free(device, addrs[1]));
+  RT_CHECK(vx_mem_free(device, addrs[3]));
+  RT_CHECK(vx_mem_free(device, addrs[0]));
+  RT_CHECK(vx_mem_free(device, addrs[2]));
+
+  RT_CHECK(vx_mem_info(device, &mem_free, &mem_used));
+  TEST_CHECK(mem_used == used0);
+  TEST_CHECK(mem_free == free0);
+
+  // invalid releases are rejected
+  TEST_CHECK(vx_mem_free(device, addrs[0]) != 0);
+  TEST_CHECK(vx_mem_free(device, addrs[0] + CACHE_BLOCK_SIZE) != 0);
+
+  // the merged range serves one block four times larger
+  size_t addr;
+  RT_CHECK(vx_alloc_dev_mem(device, 4 * block_size, &addr));
+  TEST_CHECK(addr == addrs[0]);
+  RT_CHECK(vx_mem_free(device, addr));
+
+  // and the lowest blocks again
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, src_ptr));
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, dst_ptr));
+  TEST_CHECK(*src_ptr == addrs[0]);
+  TEST_CHECK(*dst_ptr == addrs[1]);
+
+  return 0;
+}
+
+int run_test(const kernel_arg_t& kernel_arg,
+             uint32_t buf_size, 
+             uint32_t num_points) {
+  // start device
+  std::cout << "start device" << std::endl;
+  RT_CHECK(vx_start(device));
+
+  // wait for completion
+  std::cout << "wait for completion" << std::endl;
+  RT_CHECK(vx_ready_wait(device, -1));
+
+  // download destination buffer
+  std::cout << "download destination buffer" << std::endl;
+  RT_CHECK(vx_copy_from_dev(staging_buf, kernel_arg.dst_ptr, buf_size, 0));
+
+  // verify result
+  std::cout << "verify result" << std::endl;  
+  {
+    int errors = 0;
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      int ref = i + 1; 
+      int cur = buf_ptr[i];
+      if (cur != ref) {
+        std::cout << "error at result #" << std::dec << i
+                  << std::hex << ": actual 0x" << cur << ", expected 0x" << ref << std::endl;
+        ++errors;
+      }
+    }
+    if (errors != 0) {
+      std::cout << "Found " << std::dec << errors << " errors!" << std::endl;
+      std::cout << "FAILED!" << std::endl;
+      return 1;  
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  kernel_arg_t kernel_arg;
+  
+  // parse command arguments
+  parse_args(argc, argv);
+
+  if (count == 0) {
+    count = 1;
+  }
+
+  // open device connection
+  std::cout << "open device connection" << std::endl;  
+  RT_CHECK(vx_dev_open(&device));
+
+  unsigned max_cores, max_warps, max_threads;
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_CORES, &max_cores));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_WARPS, &max_warps));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_THREADS, &max_threads));
+
+  uint32_t num_tasks  = max_cores * max_warps * max_threads;
+  uint32_t num_points = count * num_tasks;
+  uint32_t buf_size   = num_points * sizeof(int32_t);
+
+  std::cout << "number of points: " << num_points << std::endl;
+  std::cout << "buffer size: " << buf_size << " bytes" << std::endl;
+
+  // upload program
+  std::cout << "upload program" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+
+  // allocate, free and reallocate device memory
+  std::cout << "test device memory allocator" << std::endl;  
+  {
+    size_t src_ptr, dst_ptr;
+    RT_CHECK(test_alloc(buf_size, &src_ptr, &dst_ptr));
+    kernel_arg.src_ptr = src_ptr;
+    kernel_arg.dst_ptr = dst_ptr;
+  }
+
+  kernel_arg.num_tasks = num_tasks;
+  kernel_arg.task_size = count;
+
+  std::cout << "dev_src=" << std::hex << kernel_arg.src_ptr << std::endl;
+  std::cout << "dev_dst=" << std::hex << kernel_arg.dst_ptr << std::endl;
+  
+  // allocate shared memory  
+  std::cout << "allocate shared memory" << std::endl;    
+  uint32_t alloc_size = std::max<uint32_t>(buf_size, sizeof(kernel_arg_t));
+  RT_CHECK(vx_alloc_shared_mem(device, alloc_size, &staging_buf));
+  
+  // upload kernel argument
+  std::cout << "upload kernel argument" << std::endl;
+  {
+    auto buf_ptr = (int*)vx_host_ptr(staging_buf);
+    memcpy(buf_ptr, &kernel_arg, sizeof(kernel_arg_t));
+    RT_CHECK(vx_copy_to_dev(staging_buf, KERNEL_ARG_DEV_MEM_ADDR, sizeof(kernel_arg_t), 0));
+  }
+
+  // upload source buffer
+  {
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      buf_ptr[i] = i;
+    }
+  }
+  std::cout << "upload source buffer" << std::endl;      
+  RT_CHECK(vx_copy_to_dev(staging_buf, kernel_arg.src_ptr, buf_size, 0));
+
+  // run tests
+  std::cout << "run tests" << std::endl;
+  RT_CHECK(run_test(kernel_arg, buf_size, num_points));
+
+  // release device memory
+  RT_CHECK(vx_mem_free(device, kernel_arg.src_ptr));
+  RT_CHECK(vx_mem_free(device, kernel_arg.dst_ptr));
+
+  // cleanup
+  std::cout << "cleanup" << std::endl;  
+  cleanup();
+
+  std::cout << "PASSED!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,316 @@
+#include <iostream>
+#include <unistd.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <vortex.h>
+#include "common.h"
+
+#define RT_CHECK(_expr)                                         \
+   do {                                                         \
+     int _ret = _expr;                                          \
+     if (0 == _ret)                                             \
+       break;                                                   \
+     printf("Error: '%s' returned %d!\n", #_expr, (int)_ret);   \
+	 cleanup();			                                              \
+     exit(-1);                                                  \
+   } while (false)
+
+#define TEST_CHECK(_cond)                                       \
+   do {                                                         \
+     if (_cond)                                                 \
+       break;                                                   \
+     printf("Error: '%s' failed!\n", #_cond);                   \
+     std::cout << "FAILED!" << std::endl;                       \
+     return 1;                                                  \
+   } while (false)
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* kernel_file = "kernel.bin";
+uint32_t count = 0;
+
+vx_device_h device = nullptr;
+vx_buffer_h staging_buf = nullptr;
+vx_perf_counters_t perf_begin = {};
+vx_perf_counters_t perf_end = {};
+vx_perf_counters_t perf_delta = {};
+
+static void show_usage() {
+   std::cout << "Vortex Test." << std::endl;
+   std::cout << "Usage: [-k: kernel] [-n words] [-h: help]" << std::endl;
+}
+
+static void parse_args(int argc, char **argv) {
+  int c;
+  while ((c = getopt(argc, argv, "n:k:h?")) != -1) {
+    switch (c) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'k':
+      kernel_file = optarg;
+      break;
+    case 'h':
+    case '?': {
+      show_usage();
+      exit(0);
+    } break;
+    default:
+      show_usage();
+      exit(-1);
+    }
+  }
+}
+
+void cleanup() {
+  vx_perf_release(&perf_begin);
+  vx_perf_release(&perf_end);
+  vx_perf_release(&perf_delta);
+  if (staging_buf) {
+    vx_buf_release(staging_buf);
+  }
+  if (device) {
+    vx_dev_close(device);
+  }
+}
+
+// emit the counters into a string
+int emit_counters(const vx_perf_counters_t& counters, int format, std::string* text) {
+  FILE* stream = tmpfile();
+  if (nullptr == stream)
+    return -1;
+  int ret = vx_perf_emit(&counters, format, stream);
+  if (0 == ret) {
+    char buffer[256];
+    size_t size;
+    rewind(stream);
+    text->clear();
+    while ((size = fread(buffer, 1, sizeof(buffer), stream)) != 0) {
+      text->append(buffer, size);
+    }
+  }
+  fclose(stream);
+  return ret;
+}
+
+size_t count_matches(const std::string& text, const std::string& pattern) {
+  size_t matches = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+    ++matches;
+  }
+  return matches;
+}
+
+// the totals sum the cores, except cycles which is the maximum
+int check_counters(const vx_perf_counters_t& counters) {
+  uint64_t instrs = 0, cycles = 0;
+  for (unsigned core_id = 0; core_id < counters.num_cores; ++core_id) {
+    instrs += counters.cores[core_id].instrs;
+    cycles = std::max(cycles, counters.cores[core_id].cycles);
+  }
+  TEST_CHECK(counters.total.instrs != 0);
+  TEST_CHECK(counters.total.instrs == instrs);
+  TEST_CHECK(counters.total.cycles == cycles);
+  return 0;
+}
+
+int check_json(const vx_perf_counters_t& counters) {
+  std::string text;
+  RT_CHECK(emit_counters(counters, VX_PERF_FORMAT_JSON, &text));
+  std::cout << text;
+
+  std::stringstream header, total;
+  header << "{\"num_cores\": " << counters.num_cores << ", \"total\": {";
+  total << "\"total\": {\"instrs\": " << counters.total.instrs << ", \"cycles\": " << counters.total.cycles;
+  TEST_CHECK(text.compare(0, header.str().size(), header.str()) == 0);
+  TEST_CHECK(text.find(total.str()) != std::string::npos);
+  TEST_CHECK(count_matches(text, "\"instrs\": ") == counters.num_cores + 1);
+  TEST_CHECK(count_matches(text, "{") == count_matches(text, "}"));
+  TEST_CHECK(count_matches(text, "\"ipc\": ") == counters.num_cores + 1);
+  TEST_CHECK(text.size() >= 3 && text.compare(text.size() - 3, 3, "]}\n") == 0);
+  return 0;
+}
+
+int check_csv(const vx_perf_counters_t& counters) {
+  std::string text;
+  RT_CHECK(emit_counters(counters, VX_PERF_FORMAT_CSV, &text));
+  std::cout << text;
+
+  std::vector<std::string> lines;
+  std::stringstream ss(text);
+  for (std::string line; std::getline(ss, line);) {
+    lines.push_back(line);
+  }
+  TEST_CHECK(lines.size() == counters.num_cores + 2);
+  TEST_CHECK(lines[0].compare(0, 19, "core,instrs,cycles,") == 0);
+  TEST_CHECK(lines[0].find(",ipc") != std::string::npos);
+
+  // one row per core then the totals, with a value for every column
+  size_t num_columns = count_matches(lines[0], ",");
+  for (size_t i = 1; i < lines.size(); ++i) {
+    auto& core = (i <= counters.num_cores) ? counters.cores[i-1] : counters.total;
+    std::stringstream row;
+    if (i <= counters.num_cores) {
+      row << (i - 1);
+    } else {
+      row << "total";
+    }
+    row << "," << core.instrs << "," << core.cycles << ",";
+    TEST_CHECK(lines[i].compare(0, row.str().size(), row.str()) == 0);
+    TEST_CHECK(count_matches(lines[i], ",") == num_columns);
+  }
+  return 0;
+}
+
+int run_kernel() {
+  // start device
+  std::cout << "start device" << std::endl;
+  RT_CHECK(vx_start(device));
+
+  // wait for completion
+  std::cout << "wait for completion" << std::endl;
+  RT_CHECK(vx_ready_wait(device, -1));
+
+  return 0;
+}
+
+int run_test(const kernel_arg_t& kernel_arg,
+             uint32_t buf_size, 
+             uint32_t num_points) {
+  // upload source buffer
+  std::cout << "upload source buffer" << std::endl;
+  {
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      buf_ptr[i] = i;
+    }
+  }
+  RT_CHECK(vx_copy_to_dev(staging_buf, kernel_arg.src_ptr, buf_size, 0));
+
+  // counters of a single launch
+  std::cout << "query counters" << std::endl;
+  RT_CHECK(vx_perf_query(device, &perf_begin));
+  RT_CHECK(run_kernel());
+  RT_CHECK(vx_perf_query(device, &perf_end));
+  RT_CHECK(check_counters(perf_end));
+  RT_CHECK(vx_perf_delta(&perf_begin, &perf_end, &perf_delta));
+  RT_CHECK(check_counters(perf_delta));
+  TEST_CHECK(perf_delta.num_cores == perf_end.num_cores);
+
+  // an input reused as output gets the same delta
+  RT_CHECK(vx_perf_delta(&perf_begin, &perf_end, &perf_begin));
+  TEST_CHECK(perf_begin.total.instrs == perf_delta.total.instrs);
+  TEST_CHECK(perf_begin.total.cycles == perf_delta.total.cycles);
+
+  // invalid arguments are rejected
+  {
+    vx_perf_counters_t mismatch = perf_end;
+    mismatch.num_cores = perf_end.num_cores + 1;
+    vx_perf_counters_t unused;
+    TEST_CHECK(vx_perf_delta(&mismatch, &perf_end, &unused) != 0);
+    TEST_CHECK(vx_perf_emit(&perf_delta, -1, stdout) != 0);
+    TEST_CHECK(vx_perf_emit(&perf_delta, VX_PERF_FORMAT_JSON, nullptr) != 0);
+  }
+
+  // emit the first launch
+  std::cout << "emit json counters" << std::endl;
+  RT_CHECK(check_json(perf_delta));
+  std::cout << "emit csv counters" << std::endl;
+  RT_CHECK(check_csv(perf_delta));
+
+  // verify result
+  std::cout << "verify result" << std::endl;  
+  RT_CHECK(vx_copy_from_dev(staging_buf, kernel_arg.dst_ptr, buf_size, 0));
+  {
+    int errors = 0;
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    for (uint32_t i = 0; i < num_points; ++i) {
+      int ref = i + 1; 
+      int cur = buf_ptr[i];
+      if (cur != ref) {
+        std::cout << "error at result #" << std::dec << i
+                  << std::hex << ": actual 0x" << cur << ", expected 0x" << ref << std::endl;
+        ++errors;
+      }
+    }
+    if (errors != 0) {
+      std::cout << "Found " << std::dec << errors << " errors!" << std::endl;
+      std::cout << "FAILED!" << std::endl;
+      return 1;  
+    }
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  size_t value; 
+  kernel_arg_t kernel_arg;
+  
+  // parse command arguments
+  parse_args(argc, argv);
+
+  if (count == 0) {
+    count = 1;
+  }
+
+  // open device connection
+  std::cout << "open device connection" << std::endl;  
+  RT_CHECK(vx_dev_open(&device));
+
+  unsigned max_cores, max_warps, max_threads;
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_CORES, &max_cores));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_WARPS, &max_warps));
+  RT_CHECK(vx_dev_caps(device, VX_CAPS_MAX_THREADS, &max_threads));
+
+  uint32_t num_tasks  = max_cores * max_warps * max_threads;
+  uint32_t num_points = count * num_tasks;
+  uint32_t buf_size   = num_points * sizeof(int32_t);
+
+  std::cout << "number of points: " << num_points << std::endl;
+  std::cout << "buffer size: " << buf_size << " bytes" << std::endl;
+
+  // upload program
+  std::cout << "upload program" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+
+  // allocate device memory
+  std::cout << "allocate device memory" << std::endl;  
+
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.src_ptr = value;
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.dst_ptr = value;
+
+  kernel_arg.num_tasks = num_tasks;
+  kernel_arg.task_size = count;
+
+  std::cout << "dev_src=" << std::hex << kernel_arg.src_ptr << std::endl;
+  std::cout << "dev_dst=" << std::hex << kernel_arg.dst_ptr << std::dec << std::endl;
+  
+  // allocate shared memory  
+  std::cout << "allocate shared memory" << std::endl;    
+  RT_CHECK(vx_alloc_shared_mem(device, buf_size, &staging_buf));
+  
+  // upload kernel argument
+  std::cout << "upload kernel argument" << std::endl;
+  {
+    auto buf_ptr = (int*)vx_host_ptr(staging_buf);
+    memcpy(buf_ptr, &kernel_arg, sizeof(kernel_arg_t));
+    RT_CHECK(vx_copy_to_dev(staging_buf, KERNEL_ARG_DEV_MEM_ADDR, sizeof(kernel_arg_t), 0));
+  }
+
+  // run tests
+  std::cout << "run tests" << std::endl;
+  RT_CHECK(run_test(kernel_arg, buf_size, num_points));
+
+  // cleanup
+  std::cout << "cleanup" << std::endl;  
+  cleanup();
+
+  std::cout << "PASSED!" << std::endl;
+
+  return 0;
+}
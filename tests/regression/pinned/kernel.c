@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include <vx_intrinsics.h>
+#include <vx_spawn.h>
+#include "common.h"
+
+void kernel_body(int task_id, kernel_arg_t* arg) {
+	uint32_t count   = arg->task_size;
+	int32_t* src_ptr = (int32_t*)arg->src_ptr;
+	int32_t* dst_ptr = (int32_t*)arg->dst_ptr;
+	
+	uint32_t offset = task_id * count;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		dst_ptr[offset+i] = src_ptr[offset+i] + 1;
+	}
+}
+
+void main() {
+	kernel_arg_t* arg = (kernel_arg_t*)KERNEL_ARG_DEV_MEM_ADDR;
+	vx_spawn_tasks(arg->num_tasks, (vx_spawn_tasks_cb)kernel_body, arg);
+}
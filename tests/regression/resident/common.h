@@ -0,0 +1,14 @@
+#ifndef _COMMON_H_
+#define _COMMON_H_
+
+#define KERNEL_ARG_DEV_MEM_ADDR 0x7ffff000
+
+#define GLOBAL_INIT_VALUE 0x1234
+
+typedef struct {
+  uint32_t num_points;
+  uint32_t data_ptr;
+  uint32_t dst_ptr;  
+} kernel_arg_t;
+
+#endif
@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <vx_intrinsics.h>
+#include "common.h"
+
+// writable global in the kernel image
+int32_t g_value = GLOBAL_INIT_VALUE;
+
+void main() {
+	kernel_arg_t* arg = (kernel_arg_t*)KERNEL_ARG_DEV_MEM_ADDR;
+	if (vx_core_id() != 0)
+		return;
+
+	int32_t* data_ptr = (int32_t*)arg->data_ptr;
+	int32_t* dst_ptr  = (int32_t*)arg->dst_ptr;
+
+	// report then modify the global and the uploaded data in place
+	dst_ptr[0] = g_value;
+	g_value = g_value + 1;
+
+	for (uint32_t i = 0; i < arg->num_points; ++i) {
+		data_ptr[i] += 1;
+	}
+
+	vx_fence();
+}
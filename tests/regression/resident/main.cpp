@@ -0,0 +1,189 @@
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <string.h>
+#include <vortex.h>
+#include "common.h"
+
+#define RT_CHECK(_expr)                                         \
+   do {                                                         \
+     int _ret = _expr;                                          \
+     if (0 == _ret)                                             \
+       break;                                                   \
+     printf("Error: '%s' returned %d!\n", #_expr, (int)_ret);   \
+	 cleanup();			                                              \
+     exit(-1);                                                  \
+   } while (false)
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char* kernel_file = "kernel.bin";
+uint32_t count = 0;
+
+vx_device_h device = nullptr;
+vx_buffer_h staging_buf = nullptr;
+
+static void show_usage() {
+   std::cout << "Vortex Test." << std::endl;
+   std::cout << "Usage: [-k: kernel] [-n words] [-h: help]" << std::endl;
+}
+
+static void parse_args(int argc, char **argv) {
+  int c;
+  while ((c = getopt(argc, argv, "n:k:h?")) != -1) {
+    switch (c) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'k':
+      kernel_file = optarg;
+      break;
+    case 'h':
+    case '?': {
+      show_usage();
+      exit(0);
+    } break;
+    default:
+      show_usage();
+      exit(-1);
+    }
+  }
+}
+
+void cleanup() {
+  if (staging_buf) {
+    vx_buf_release(staging_buf);
+  }
+  if (device) {
+    vx_dev_close(device);
+  }
+}
+
+// run the kernel once and check the global it saw and the data it incremented
+int run_test(const kernel_arg_t& kernel_arg,
+             const std::vector<int32_t>& data,
+             int32_t expected_value,
+             int32_t expected_delta) {
+  uint32_t buf_size = kernel_arg.num_points * sizeof(int32_t);
+
+  // start device
+  std::cout << "start device" << std::endl;
+  RT_CHECK(vx_start(device));
+
+  // wait for completion
+  std::cout << "wait for completion" << std::endl;
+  RT_CHECK(vx_ready_wait(device, -1));
+
+  int errors = 0;
+
+  // check the kernel global
+  RT_CHECK(vx_copy_from_dev(staging_buf, kernel_arg.dst_ptr, sizeof(int32_t), 0));
+  {
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    if (buf_ptr[0] != expected_value) {
+      std::cout << "error: global value actual 0x" << std::hex << buf_ptr[0]
+                << ", expected 0x" << expected_value << std::endl;
+      ++errors;
+    }
+  }
+
+  // check the uploaded data
+  RT_CHECK(vx_copy_from_dev(staging_buf, kernel_arg.data_ptr, buf_size, 0));
+  {
+    auto buf_ptr = (int32_t*)vx_host_ptr(staging_buf);
+    for (uint32_t i = 0; i < kernel_arg.num_points; ++i) {
+      int ref = data[i] + expected_delta; 
+      int cur = buf_ptr[i];
+      if (cur != ref) {
+        std::cout << "error at result #" << std::dec << i
+                  << std::hex << ": actual 0x" << cur << ", expected 0x" << ref << std::endl;
+        ++errors;
+      }
+    }
+  }
+
+  if (errors != 0) {
+    std::cout << "Found " << std::dec << errors << " errors!" << std::endl;
+    std::cout << "FAILED!" << std::endl;
+    return 1;  
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  size_t value; 
+  kernel_arg_t kernel_arg;
+  
+  // parse command arguments
+  parse_args(argc, argv);
+
+  if (count == 0) {
+    count = 1;
+  }
+
+  // open device connection
+  std::cout << "open device connection" << std::endl;  
+  RT_CHECK(vx_dev_open(&device));
+
+  uint32_t num_points = count;
+  uint32_t buf_size   = num_points * sizeof(int32_t);
+
+  std::cout << "number of points: " << num_points << std::endl;
+  std::cout << "buffer size: " << buf_size << " bytes" << std::endl;
+
+  // allocate device memory
+  std::cout << "allocate device memory" << std::endl;  
+
+  RT_CHECK(vx_alloc_dev_mem(device, buf_size, &value));
+  kernel_arg.data_ptr = value;
+  RT_CHECK(vx_alloc_dev_mem(device, sizeof(int32_t), &value));
+  kernel_arg.dst_ptr = value;
+
+  kernel_arg.num_points = num_points;
+
+  std::cout << "dev_data=" << std::hex << kernel_arg.data_ptr << std::endl;
+  std::cout << "dev_dst=" << std::hex << kernel_arg.dst_ptr << std::endl;
+  
+  // allocate shared memory  
+  std::cout << "allocate shared memory" << std::endl;    
+  uint32_t alloc_size = std::max<uint32_t>(buf_size, sizeof(kernel_arg_t));
+  RT_CHECK(vx_alloc_shared_mem(device, alloc_size, &staging_buf));
+  
+  // upload kernel argument
+  std::cout << "upload kernel argument" << std::endl;
+  {
+    auto buf_ptr = (int*)vx_host_ptr(staging_buf);
+    memcpy(buf_ptr, &kernel_arg, sizeof(kernel_arg_t));
+    RT_CHECK(vx_copy_to_dev(staging_buf, KERNEL_ARG_DEV_MEM_ADDR, sizeof(kernel_arg_t), 0));
+  }
+
+  std::vector<int32_t> data(num_points);
+  for (uint32_t i = 0; i < num_points; ++i) {
+    data[i] = i * 3;
+  }
+
+  // first launch sees the initial image
+  std::cout << "upload program and data" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+  RT_CHECK(vx_upload_bytes(device, kernel_arg.data_ptr, data.data(), buf_size));
+  RT_CHECK(run_test(kernel_arg, data, GLOBAL_INIT_VALUE, 1));
+
+  // second launch sees what the first one modified
+  std::cout << "run again" << std::endl;  
+  RT_CHECK(run_test(kernel_arg, data, GLOBAL_INIT_VALUE + 1, 2));
+
+  // re-uploading the same content must restore it
+  std::cout << "upload program and data again" << std::endl;  
+  RT_CHECK(vx_upload_kernel_file(device, kernel_file));
+  RT_CHECK(vx_upload_bytes(device, kernel_arg.data_ptr, data.data(), buf_size));
+  RT_CHECK(run_test(kernel_arg, data, GLOBAL_INIT_VALUE, 1));
+
+  // cleanup
+  std::cout << "cleanup" << std::endl;  
+  cleanup();
+
+  std::cout << "PASSED!" << std::endl;
+
+  return 0;
+}
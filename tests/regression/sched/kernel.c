@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include <vx_intrinsics.h>
+#include <vx_spawn.h>
+#include "common.h"
+
+// uneven work per task so that dynamic and stealing modes rebalance
+static int32_t task_value(int task_id, const int32_t* src_ptr) {
+	int32_t value = src_ptr[task_id];
+	int32_t count = task_id % 17;
+	for (int32_t i = 0; i < count; ++i) {
+		value = value * 3 + i;
+	}
+	return value;
+}
+
+// each mode writes its own slice, accumulating so a task run twice is caught
+static void run_slice(int task_id, kernel_arg_t* arg, int slice) {
+	int32_t* src_ptr = (int32_t*)arg->src_ptr;
+	int32_t* dst_ptr = (int32_t*)arg->dst_ptr + slice * arg->num_tasks;
+	dst_ptr[task_id] += task_value(task_id, src_ptr);
+	vx_fence();
+}
+
+void kernel_static(int task_id, kernel_arg_t* arg) {
+	run_slice(task_id, arg, 0);
+}
+
+void kernel_dynamic(int task_id, kernel_arg_t* arg) {
+	run_slice(task_id, arg, 1);
+}
+
+void kernel_steal(int task_id, kernel_arg_t* arg) {
+	run_slice(task_id, arg, 2);
+}
+
+void main() {
+	kernel_arg_t* arg = (kernel_arg_t*)KERNEL_ARG_DEV_MEM_ADDR;
+	vx_spawn_tasks_sched(arg->num_tasks, (vx_spawn_tasks_cb)kernel_static, arg, VX_SCHED_STATIC, 0);
+	vx_spawn_tasks_sched(arg->num_tasks, (vx_spawn_tasks_cb)kernel_dynamic, arg, VX_SCHED_DYNAMIC, arg->chunk);
+	vx_spawn_tasks_sched(arg->num_tasks, (vx_spawn_tasks_cb)kernel_steal, arg, VX_SCHED_STEAL, arg->chunk);
+}